@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+
+#include <safet/condition_variable.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace {
+// round trips per measured run, each a wake of the other thread and a wake back
+constexpr uint64_t round_trips = 1000;
+}
+
+TEST_CASE("condition_variable ping-pong latency", "[benchmark][condition_variable]")
+{
+    BENCHMARK("safet::condition_variable, " + std::to_string(round_trips) + " round trips")
+    {
+        // odd values are the ponger's turn, even the pinger's
+        safet::condition_variable<uint64_t> turn { 0 };
+
+        std::thread ponger { [&]() {
+            for (uint64_t i = 0; i < round_trips; ++i) {
+                turn.wait([](const uint64_t& value) { return value % 2 == 1; }, [](uint64_t&) {});
+                turn.modify([](uint64_t& value) { ++value; });
+            }
+        } };
+
+        for (uint64_t i = 0; i < round_trips; ++i) {
+            turn.modify([](uint64_t& value) { ++value; });
+            turn.wait([](const uint64_t& value) { return value % 2 == 0; }, [](uint64_t&) {});
+        }
+        ponger.join();
+
+        return turn.inspect([](const uint64_t& value) { return value; });
+    };
+
+    BENCHMARK("std::condition_variable, " + std::to_string(round_trips) + " round trips")
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        uint64_t turn { 0 };
+
+        std::thread ponger { [&]() {
+            for (uint64_t i = 0; i < round_trips; ++i) {
+                std::unique_lock guard { mutex };
+                cv.wait(guard, [&]() { return turn % 2 == 1; });
+                ++turn;
+                guard.unlock();
+                cv.notify_all();
+            }
+        } };
+
+        for (uint64_t i = 0; i < round_trips; ++i) {
+            {
+                std::scoped_lock guard { mutex };
+                ++turn;
+            }
+            cv.notify_all();
+
+            std::unique_lock guard { mutex };
+            cv.wait(guard, [&]() { return turn % 2 == 0; });
+        }
+        ponger.join();
+
+        return turn;
+    };
+}
@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+
+#include <safet/cow.hpp>
+
+#include <string>
+
+TEST_CASE("cow copy and cow::get_mutable", "[benchmark][cow]")
+{
+    const std::string source(256, 'x');
+    const safet::cow<std::string> borrowed { std::cref(source) };
+    const safet::shared_cow<std::string> shared { source };
+
+    BENCHMARK("std::string copy")
+    {
+        std::string copy = source;
+        return copy.size();
+    };
+
+    BENCHMARK("safet::cow copy, read only")
+    {
+        safet::cow<std::string> copy = borrowed;
+        return copy.get_const().size();
+    };
+
+    BENCHMARK("safet::cow copy then get_mutable")
+    {
+        safet::cow<std::string> copy = borrowed;
+        copy.get_mutable().back() = 'y';
+        return copy.get_const().size();
+    };
+
+    BENCHMARK("safet::shared_cow copy, read only")
+    {
+        safet::shared_cow<std::string> copy = shared;
+        return copy.get_const().size();
+    };
+
+    BENCHMARK("safet::shared_cow copy then get_mutable")
+    {
+        safet::shared_cow<std::string> copy = shared;
+        copy.get_mutable().back() = 'y';
+        return copy.get_const().size();
+    };
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch.hpp>
+
+#include <safet/atomic_value.hpp>
+#include <safet/combining_critical_section.hpp>
+#include <safet/critical_section.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t operations_per_thread = 10000;
+
+// 1, 2, 4, ... up to the hardware's concurrency, and always including it
+auto thread_counts() -> std::vector<size_t>
+{
+    const size_t hardware = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    std::vector<size_t> counts;
+    for (size_t count = 1; count < hardware; count *= 2) {
+        counts.push_back(count);
+    }
+    counts.push_back(hardware);
+
+    return counts;
+}
+
+template <typename Operation>
+auto run_threads(size_t thread_count, Operation& operation) -> void
+{
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&]() {
+            for (size_t j = 0; j < operations_per_thread; ++j) {
+                operation();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+}
+
+TEST_CASE("critical_section::enter under contention", "[benchmark][critical_section]")
+{
+    for (auto thread_count : thread_counts()) {
+        const auto suffix = std::to_string(thread_count) + " thread(s), " + std::to_string(operations_per_thread) + " operations each";
+
+        BENCHMARK("safet::critical_section::enter, " + suffix)
+        {
+            safet::critical_section<uint64_t> counter { 0 };
+            auto operation = [&]() { counter.enter([](uint64_t& value) { ++value; }); };
+            run_threads(thread_count, operation);
+
+            return counter.enter([](uint64_t& value) { return value; });
+        };
+
+        BENCHMARK("safet::combining_critical_section::enter_combined, " + suffix)
+        {
+            safet::combining_critical_section<uint64_t> counter { 0 };
+            auto operation = [&]() { counter.enter_combined([](uint64_t& value) { ++value; }); };
+            run_threads(thread_count, operation);
+
+            return counter.enter([](uint64_t& value) { return value; });
+        };
+
+        BENCHMARK("safet::atomic_value::enter, " + suffix)
+        {
+            safet::atomic_value<uint64_t> counter { 0 };
+            auto operation = [&]() { counter.enter([](uint64_t& value) { ++value; }); };
+            run_threads(thread_count, operation);
+
+            return counter.read();
+        };
+
+        BENCHMARK("std::mutex and std::scoped_lock, " + suffix)
+        {
+            std::mutex mutex;
+            uint64_t counter { 0 };
+            auto operation = [&]() {
+                std::scoped_lock guard { mutex };
+                ++counter;
+            };
+            run_threads(thread_count, operation);
+
+            return counter;
+        };
+    }
+}
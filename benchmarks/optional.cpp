@@ -0,0 +1,92 @@
+#include <catch2/catch.hpp>
+
+#include <safet/optional.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace {
+constexpr size_t count = 4096;
+
+// every third value is empty, so neither branch of an engaged check is predictable from the last
+template <typename Optional>
+auto make_inputs() -> std::vector<Optional>
+{
+    std::vector<Optional> inputs;
+    inputs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (i % 3 == 0) {
+            inputs.emplace_back();
+        } else {
+            inputs.emplace_back(static_cast<int64_t>(i));
+        }
+    }
+
+    return inputs;
+}
+
+auto halve_if_even(int64_t value) -> safet::optional<int64_t>
+{
+    if (value % 2 == 0) {
+        return value / 2;
+    }
+    return std::nullopt;
+}
+
+auto std_halve_if_even(int64_t value) -> std::optional<int64_t>
+{
+    if (value % 2 == 0) {
+        return value / 2;
+    }
+    return std::nullopt;
+}
+}
+
+TEST_CASE("optional::if_set and optional::and_then chains, eager and piped", "[benchmark][optional]")
+{
+    auto safet_inputs = make_inputs<safet::optional<int64_t>>();
+    auto std_inputs = make_inputs<std::optional<int64_t>>();
+
+    BENCHMARK("safet::optional if_set().and_then().value_or()")
+    {
+        int64_t sum = 0;
+        for (const auto& input : safet_inputs) {
+            sum += input.if_set([](int64_t value) { return value * 3; })
+                       .and_then(halve_if_even)
+                       .value_or([]() -> int64_t { return -1; });
+        }
+        return sum;
+    };
+
+    BENCHMARK("safet::optional pipe() | if_set() | and_then() | value_or()")
+    {
+        int64_t sum = 0;
+        for (const auto& input : safet_inputs) {
+            sum += input.pipe()
+                | safet::if_set([](int64_t value) { return value * 3; })
+                | safet::and_then(halve_if_even)
+                | safet::value_or([]() -> int64_t { return -1; });
+        }
+        return sum;
+    };
+
+    BENCHMARK("std::optional with explicit checks")
+    {
+        int64_t sum = 0;
+        for (const auto& input : std_inputs) {
+            std::optional<int64_t> tripled;
+            if (input.has_value()) {
+                tripled = *input * 3;
+            }
+
+            std::optional<int64_t> halved;
+            if (tripled.has_value()) {
+                halved = std_halve_if_even(*tripled);
+            }
+
+            sum += halved.value_or(-1);
+        }
+        return sum;
+    };
+}
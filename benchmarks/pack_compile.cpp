@@ -0,0 +1,58 @@
+// instantiates every pack metafunction over packs of SAFET_PACK_BENCHMARK_SIZE types, for the compile time benchmark
+// targets. There's nothing to run, compiling it is the benchmark
+
+#include <safet/pack.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#ifndef SAFET_PACK_BENCHMARK_SIZE
+#define SAFET_PACK_BENCHMARK_SIZE 50
+#endif
+
+namespace {
+constexpr size_t size = SAFET_PACK_BENCHMARK_SIZE;
+
+template <size_t I>
+struct element { };
+
+template <size_t I>
+struct is_even : std::bool_constant<I % 2 == 0> { };
+
+template <typename T>
+struct even_element;
+
+template <size_t I>
+struct even_element<element<I>> : is_even<I> { };
+
+template <typename Sequence, size_t Modulo>
+struct make_pack;
+
+template <size_t... Is, size_t Modulo>
+struct make_pack<std::index_sequence<Is...>, Modulo> {
+    using type = safet::pack<element<Is % Modulo>...>;
+};
+
+// every type distinct, and every type twice
+using distinct = typename make_pack<std::make_index_sequence<size>, size>::type;
+using duplicated = typename make_pack<std::make_index_sequence<size>, size / 2>::type;
+
+template <typename Pack, size_t... Is>
+constexpr auto lookups(std::index_sequence<Is...>) -> bool
+{
+    return (std::is_same_v<typename Pack::template ith_type<Is>::type, element<Is>> && ...)
+        && ((Pack::template index_of<element<Is>>::value == Is) && ...)
+        && ((Pack::template count_of<element<Is>>::value == 1) && ...)
+        && (Pack::template contains<element<Is>>::value && ...);
+}
+
+static_assert(lookups<distinct>(std::make_index_sequence<size> {}));
+static_assert(std::is_same_v<distinct::last_type::type, element<size - 1>>);
+static_assert(distinct::remove_prefix<size / 2>::size::value == size - size / 2);
+static_assert(distinct::remove_suffix<size / 2>::size::value == size - size / 2);
+static_assert(distinct::subpack<size / 4, size / 2>::size::value == size / 2);
+static_assert(distinct::filter<even_element>::size::value == (size + 1) / 2);
+static_assert(std::is_same_v<duplicated::remove_duplicates, typename make_pack<std::make_index_sequence<size / 2>, size / 2>::type>);
+static_assert(duplicated::count_of<element<0>>::value == 2);
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include <safet/variant.hpp>
+
+#include <cstdint>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace {
+constexpr size_t count = 4096;
+
+template <typename Variant>
+auto make_inputs() -> std::vector<Variant>
+{
+    std::vector<Variant> inputs;
+    inputs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        switch ((i * 7) % 3) {
+        case 0:
+            inputs.emplace_back(std::in_place_index<0>, static_cast<int64_t>(i));
+            break;
+        case 1:
+            inputs.emplace_back(std::in_place_index<1>, static_cast<double>(i) / 2);
+            break;
+        default:
+            inputs.emplace_back(std::in_place_index<2>, std::to_string(i));
+            break;
+        }
+    }
+
+    return inputs;
+}
+
+struct weigh {
+    auto operator()(int64_t value) const -> int64_t { return value; }
+    auto operator()(double value) const -> int64_t { return static_cast<int64_t>(value * 2); }
+    auto operator()(const std::string& value) const -> int64_t { return static_cast<int64_t>(value.size()); }
+};
+
+struct compare_kinds {
+    template <typename L, typename R>
+    auto operator()(const L& lhs, const R& rhs) const -> int64_t
+    {
+        return weigh {}(lhs) - weigh {}(rhs);
+    }
+};
+}
+
+TEST_CASE("variant::visit and variant::covisit", "[benchmark][variant]")
+{
+    using safet_variant = safet::variant<int64_t, double, std::string>;
+    using std_variant = std::variant<int64_t, double, std::string>;
+
+    auto safet_inputs = make_inputs<safet_variant>();
+    auto std_inputs = make_inputs<std_variant>();
+
+    BENCHMARK("safet::variant::visit")
+    {
+        int64_t sum = 0;
+        for (const auto& input : safet_inputs) {
+            sum += input.visit(weigh {});
+        }
+        return sum;
+    };
+
+    BENCHMARK("std::visit")
+    {
+        int64_t sum = 0;
+        for (const auto& input : std_inputs) {
+            sum += std::visit(weigh {}, input);
+        }
+        return sum;
+    };
+
+    BENCHMARK("safet::variant::covisit")
+    {
+        int64_t sum = 0;
+        for (size_t i = 1; i < safet_inputs.size(); ++i) {
+            sum += safet_inputs[i - 1].covisit(safet_inputs[i], compare_kinds {});
+        }
+        return sum;
+    };
+
+    BENCHMARK("std::visit of two variants")
+    {
+        int64_t sum = 0;
+        for (size_t i = 1; i < std_inputs.size(); ++i) {
+            sum += std::visit(compare_kinds {}, std_inputs[i - 1], std_inputs[i]);
+        }
+        return sum;
+    };
+}
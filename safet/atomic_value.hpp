@@ -0,0 +1,233 @@
+#pragma once
+
+#include <safet/critical_section.hpp>
+#include <safet/impl/concepts.hpp>
+#include <safet/mutex.hpp>
+
+#include <atomic>
+#include <bit>
+#include <type_traits>
+
+namespace safet {
+namespace atomic_value_impl {
+// compilers only expose a double-width compare-exchange when targeting it (e.g. `-mcx16` on x86-64), and even then
+// `std::atomic` and the `__atomic` builtins of a 16 byte `T` call into libatomic, so we use the `__sync` builtin, which
+// is emitted inline (as a full barrier). Note this changes `atomic_value`'s layout, so every translation unit must
+// agree on the flag
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16) && defined(__SIZEOF_INT128__)
+#define SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS 1
+    __extension__ using double_word = unsigned __int128;
+#else
+#define SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS 0
+#endif
+
+    // std::atomic<T> static_asserts on types that aren't trivially copyable, so it's only named once `T` is known to be
+    template <typename T>
+    struct is_always_lock_free : std::bool_constant<std::atomic<T>::is_always_lock_free> {
+    };
+
+    template <typename T>
+    inline constexpr bool lock_free_standard = std::conjunction_v<std::is_trivially_copyable<T>, is_always_lock_free<T>>;
+
+    template <typename T>
+    inline constexpr bool lock_free_double_width = SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS && !lock_free_standard<T> && std::is_trivially_copyable_v<T> && sizeof(T) == 16;
+
+    template <typename T>
+    class standard_storage {
+    public:
+        using raw_type = T;
+
+        explicit standard_storage(T value) noexcept
+            : m_value(value)
+        {
+        }
+
+        auto load() const noexcept -> raw_type
+        {
+            return m_value.load(std::memory_order_acquire);
+        }
+
+        auto store(T value) noexcept -> void
+        {
+            m_value.store(value, std::memory_order_release);
+        }
+
+        auto compare_exchange(raw_type& expected, const T& desired) noexcept -> bool
+        {
+            return m_value.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        static auto value(const raw_type& raw) noexcept -> T
+        {
+            return raw;
+        }
+
+    private:
+        std::atomic<T> m_value;
+    };
+
+#if SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS
+    // the bits are compared as loaded rather than re-encoded from a `T`, so padding within `T` can't fail the exchange
+    // forever
+    template <typename T>
+    class double_width_storage {
+    public:
+        using raw_type = double_word;
+
+        explicit double_width_storage(T value) noexcept
+            : m_word(std::bit_cast<double_word>(value))
+        {
+        }
+
+        // there is no double-width load, a compare-exchange that's unlikely to succeed reads the value instead
+        auto load() const noexcept -> raw_type
+        {
+            return __sync_val_compare_and_swap(&m_word, raw_type { 0 }, raw_type { 0 });
+        }
+
+        auto store(T value) noexcept -> void
+        {
+            auto expected = load();
+            while (!compare_exchange(expected, value)) {
+            }
+        }
+
+        auto compare_exchange(raw_type& expected, const T& desired) noexcept -> bool
+        {
+            const auto previous = __sync_val_compare_and_swap(&m_word, expected, std::bit_cast<raw_type>(desired));
+            if (previous == expected) {
+                return true;
+            }
+
+            expected = previous;
+            return false;
+        }
+
+        static auto value(const raw_type& raw) noexcept -> T
+        {
+            return std::bit_cast<T>(raw);
+        }
+
+    private:
+        // mutable as loading is itself a compare-exchange
+        alignas(16) mutable double_word m_word;
+    };
+#endif
+
+    template <typename T, typename Mutex>
+    struct storage_selector {
+        using type = critical_section<T, Mutex>;
+    };
+
+    template <typename T, typename Mutex>
+    requires(lock_free_standard<T>) struct storage_selector<T, Mutex> {
+        using type = standard_storage<T>;
+    };
+
+#if SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS
+    template <typename T, typename Mutex>
+    requires(lock_free_double_width<T>) struct storage_selector<T, Mutex> {
+        using type = double_width_storage<T>;
+    };
+#endif
+}
+
+// the functor based interface of `critical_section` for small values. When `T` is lock-free as a `std::atomic`, or
+// is 16 bytes and the target has a double-width compare-exchange, `enter` runs `f` on a copy of the value and
+// publishes it with a compare-exchange, re-running `f` on a fresh copy whenever another writer got in first, and
+// `inspect` is a single atomic load. Otherwise it falls back to a `critical_section<T, Mutex>`, so call sites are the
+// same either way.
+//
+// Since `f` may run more than once it should only modify its argument. When lock-free, nothing is published if `f`
+// throws
+template <typename T, impl::lockable Mutex = spin_mutex>
+class atomic_value {
+public:
+    static constexpr bool is_lock_free = atomic_value_impl::lock_free_standard<T> || atomic_value_impl::lock_free_double_width<T>;
+
+    template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, Params&&...>>>
+    atomic_value(Params&&... params)
+        : m_storage(T(std::forward<Params>(params)...))
+    {
+    }
+
+    atomic_value(const atomic_value&) = delete;
+    atomic_value(atomic_value&&) = delete;
+
+    ~atomic_value() = default;
+
+    auto operator=(const atomic_value&) -> atomic_value& = delete;
+    auto operator=(atomic_value&&) -> atomic_value& = delete;
+
+    auto operator=(T new_value) -> atomic_value&
+    {
+        if constexpr (is_lock_free) {
+            m_storage.store(new_value);
+        } else {
+            m_storage = std::move(new_value);
+        }
+
+        return *this;
+    }
+
+    template <typename Functor>
+    decltype(auto) enter(Functor&& f)
+    {
+        static_assert(impl::invocable<Functor&, T&>, "enter functor must be invocable with T&");
+
+        if constexpr (is_lock_free) {
+            auto expected = m_storage.load();
+            while (true) {
+                auto desired = storage_type::value(expected);
+
+                if constexpr (impl::invocable_and_returns_something<Functor&, T&>) {
+                    // `f` runs on a copy on this stack frame, so a reference it returns would dangle
+                    static_assert(!std::is_reference_v<std::invoke_result_t<Functor&, T&>>, "lock-free atomic_value enter functor must not return a reference");
+
+                    auto ret_val = f(desired);
+                    if (m_storage.compare_exchange(expected, desired)) {
+                        return ret_val;
+                    }
+                } else {
+                    f(desired);
+                    if (m_storage.compare_exchange(expected, desired)) {
+                        return;
+                    }
+                }
+            }
+        } else {
+            return m_storage.enter(std::forward<Functor>(f));
+        }
+    }
+
+    // a copy of the value, a single atomic load when lock-free
+    auto read() const -> T
+    {
+        if constexpr (is_lock_free) {
+            return storage_type::value(m_storage.load());
+        } else {
+            return m_storage.enter([](const T& value) -> T { return value; });
+        }
+    }
+
+    template <impl::invocable<const T&> InspectFunctor>
+    auto inspect(InspectFunctor&& f) const -> std::invoke_result_t<InspectFunctor&&, const T&>
+    {
+        if constexpr (is_lock_free) {
+            // `f` sees a copy on this stack frame, as in `enter`
+            static_assert(!std::is_reference_v<std::invoke_result_t<InspectFunctor&&, const T&>>, "lock-free atomic_value inspect functor must not return a reference");
+
+            const auto value = read();
+
+            return std::forward<InspectFunctor>(f)(value);
+        } else {
+            return m_storage.enter(std::forward<InspectFunctor>(f));
+        }
+    }
+
+private:
+    using storage_type = typename atomic_value_impl::storage_selector<T, Mutex>::type;
+
+    storage_type m_storage;
+};
+}
@@ -0,0 +1,344 @@
+#pragma once
+
+#include <safet/condition_variable.hpp>
+#include <safet/impl/hardware.hpp>
+#include <safet/optional.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <span>
+
+namespace safet {
+namespace channel_impl {
+    // each cell's sequence number says whose turn it is: equal to the cell's position when free for the producer of
+    // that lap, and position + 1 once filled for the consumer of that lap (see Vyukov's bounded MPMC queue)
+    template <typename T>
+    struct cell {
+        std::atomic<size_t> m_sequence;
+        alignas(T) std::byte m_storage[sizeof(T)];
+
+        auto value() -> T&
+        {
+            return *std::launder(reinterpret_cast<T*>(m_storage));
+        }
+    };
+
+    enum class waiter_kind {
+        CONSUMER,
+        PRODUCER,
+    };
+
+    // threads sleeping on a channel only need the condition_variable for its waiter list, all of the channel's state
+    // lives in atomics
+    struct parking_lot {
+    };
+}
+
+// bounded multi-producer multi-consumer queue over a fixed ring buffer. Pushing and popping is lock-free, threads only
+// ever sleep (on a keyed `condition_variable`) when the channel is full or empty, and only pay for a notification
+// when there is actually someone asleep on the other side. Batch operations claim many cells with a single atomic
+// operation and wake sleepers once per batch.
+//
+// Once `close`d no more items are accepted, while items already in the channel may still be popped. Blocking pops
+// return empty once the channel is both closed and drained
+template <typename T>
+class channel {
+public:
+    static_assert(std::is_nothrow_move_constructible_v<T>, "channel type must be nothrow move constructible");
+
+    // capacity is rounded up to a power of two
+    explicit channel(size_t capacity)
+        : m_mask(std::bit_ceil(capacity < 2 ? size_t { 2 } : capacity) - 1)
+        , m_cells(std::make_unique<channel_impl::cell<T>[]>(m_mask + 1))
+    {
+        for (size_t i = 0; i <= m_mask; ++i) {
+            m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    channel(const channel&) = delete;
+    channel(channel&&) = delete;
+
+    ~channel()
+    {
+        while (!try_pop().empty()) {
+        }
+    }
+
+    auto operator=(const channel&) -> channel& = delete;
+    auto operator=(channel&&) -> channel& = delete;
+
+    auto capacity() const -> size_t
+    {
+        return m_mask + 1;
+    }
+
+    // pushes `value` if there is space, `value` is only moved from if it was pushed
+    template <typename U>
+    requires(std::is_constructible_v<T, U&&>) auto try_push(U&& value) -> bool
+    {
+        size_t position;
+        if (claim(m_tail, 0, 1, position) == 0) {
+            return false;
+        }
+
+        new (m_cells[position & m_mask].m_storage) T(std::forward<U>(value));
+        m_cells[position & m_mask].m_sequence.store(position + 1, std::memory_order_release);
+
+        wake(channel_impl::waiter_kind::CONSUMER, notification_type::NOTIFY_ONE);
+        pass_on(channel_impl::waiter_kind::PRODUCER);
+
+        return true;
+    }
+
+    // blocks while the channel is full, returns false (without moving from `value`) if the channel is closed
+    template <typename U>
+    requires(std::is_constructible_v<T, U&&>) auto push(U&& value) -> bool
+    {
+        while (!try_push(std::forward<U>(value))) {
+            if (!sleep_until(channel_impl::waiter_kind::PRODUCER)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    auto try_pop() -> optional<T>
+    {
+        size_t position;
+        if (claim(m_head, 1, 1, position) == 0) {
+            return std::nullopt;
+        }
+
+        auto value = take(position);
+        wake(channel_impl::waiter_kind::PRODUCER, notification_type::NOTIFY_ONE);
+        pass_on(channel_impl::waiter_kind::CONSUMER);
+
+        return value;
+    }
+
+    // blocks while the channel is empty, returns empty once the channel is closed and drained
+    auto pop() -> optional<T>
+    {
+        while (true) {
+            auto value = try_pop();
+            if (!value.empty() || !sleep_until(channel_impl::waiter_kind::CONSUMER)) {
+                return value;
+            }
+        }
+    }
+
+    // moves as many of `values` as currently fit into the channel, returning how many were pushed (always a prefix)
+    auto try_push_batch(std::span<T> values) -> size_t
+    {
+        if (values.empty()) {
+            return 0;
+        }
+
+        size_t position;
+        const auto count = claim(m_tail, 0, values.size(), position);
+
+        for (size_t i = 0; i < count; ++i) {
+            new (m_cells[(position + i) & m_mask].m_storage) T(std::move(values[i]));
+            m_cells[(position + i) & m_mask].m_sequence.store(position + i + 1, std::memory_order_release);
+        }
+
+        if (count != 0) {
+            wake(channel_impl::waiter_kind::CONSUMER, count == 1 ? notification_type::NOTIFY_ONE : notification_type::NOTIFY_ALL);
+            pass_on(channel_impl::waiter_kind::PRODUCER);
+        }
+
+        return count;
+    }
+
+    // blocks until all of `values` are pushed or the channel is closed, returning how many were pushed
+    auto push_batch(std::span<T> values) -> size_t
+    {
+        size_t pushed = 0;
+
+        while (pushed < values.size()) {
+            pushed += try_push_batch(values.subspan(pushed));
+
+            if (pushed < values.size() && !sleep_until(channel_impl::waiter_kind::PRODUCER)) {
+                break;
+            }
+        }
+
+        return pushed;
+    }
+
+    // pops up to `max` items into `out`, returning how many were popped
+    template <typename OutputIterator>
+    auto try_pop_batch(OutputIterator out, size_t max) -> size_t
+    {
+        if (max == 0) {
+            return 0;
+        }
+
+        size_t position;
+        const auto count = claim(m_head, 1, max, position);
+
+        for (size_t i = 0; i < count; ++i) {
+            take(position + i).if_set([&](T&& value) { *out++ = std::move(value); });
+        }
+
+        if (count != 0) {
+            wake(channel_impl::waiter_kind::PRODUCER, count == 1 ? notification_type::NOTIFY_ONE : notification_type::NOTIFY_ALL);
+            pass_on(channel_impl::waiter_kind::CONSUMER);
+        }
+
+        return count;
+    }
+
+    // blocks until at least one item is available, then pops up to `max` items. Returns 0 only once the channel is
+    // closed and drained
+    template <typename OutputIterator>
+    auto pop_batch(OutputIterator out, size_t max) -> size_t
+    {
+        while (true) {
+            const auto count = try_pop_batch(out, max);
+            if (count != 0 || max == 0 || !sleep_until(channel_impl::waiter_kind::CONSUMER)) {
+                return count;
+            }
+        }
+    }
+
+    // no further items will be accepted and every sleeping producer and consumer is woken
+    auto close() -> void
+    {
+        m_signal.modify([this](channel_impl::parking_lot&) { m_tail.fetch_or(closed_bit, std::memory_order_seq_cst); });
+    }
+
+    auto closed() const -> bool
+    {
+        return (m_tail.load(std::memory_order_acquire) & closed_bit) != 0;
+    }
+
+private:
+    using notification_type = typename condition_variable<channel_impl::parking_lot>::notification_type;
+
+    // closing sets the top bit of the tail, so a producer's claim either completes before the close or fails against it,
+    // and every item pushed successfully is below the final tail consumers drain up to
+    static constexpr size_t closed_bit { size_t { 1 } << (std::numeric_limits<size_t>::digits - 1) };
+
+    // claims up to `max` consecutive cells at `counter` for which the cell sequence is `position + offset`, i.e. free
+    // cells for producers (offset 0) or filled cells for consumers (offset 1). Returns how many were claimed
+    auto claim(std::atomic<size_t>& counter, size_t offset, size_t max, size_t& position) -> size_t
+    {
+        position = counter.load(std::memory_order_relaxed);
+
+        while (true) {
+            if ((position & closed_bit) != 0) {
+                return 0;
+            }
+
+            size_t count = 0;
+            while (count < max && m_cells[(position + count) & m_mask].m_sequence.load(std::memory_order_acquire) == position + count + offset) {
+                ++count;
+            }
+
+            if (count == 0) {
+                const auto sequence = m_cells[position & m_mask].m_sequence.load(std::memory_order_acquire);
+                if (static_cast<std::ptrdiff_t>(sequence - (position + offset)) < 0) {
+                    // the cell is still the previous lap's, so the channel is full (or empty)
+                    return 0;
+                }
+
+                // another thread claimed it first, try again from wherever the counter is now
+                position = counter.load(std::memory_order_relaxed);
+            } else if (counter.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                return count;
+            }
+        }
+    }
+
+    // takes the item at our claimed `position` and frees its cell for the producer of the next lap
+    auto take(size_t position) -> optional<T>
+    {
+        auto& cell = m_cells[position & m_mask];
+
+        optional<T> value { std::move(cell.value()) };
+        std::destroy_at(&cell.value());
+        cell.m_sequence.store(position + m_mask + 1, std::memory_order_release);
+
+        return value;
+    }
+
+    auto ready(channel_impl::waiter_kind kind) const -> bool
+    {
+        if (kind == channel_impl::waiter_kind::CONSUMER) {
+            const auto head = m_head.load(std::memory_order_seq_cst);
+            return m_cells[head & m_mask].m_sequence.load(std::memory_order_seq_cst) == head + 1;
+        } else {
+            const auto tail = m_tail.load(std::memory_order_seq_cst) & ~closed_bit;
+            return m_cells[tail & m_mask].m_sequence.load(std::memory_order_seq_cst) == tail;
+        }
+    }
+
+    // every cell claimed by a producer has been popped, only final once closed
+    auto drained() const -> bool
+    {
+        return m_head.load(std::memory_order_seq_cst) == (m_tail.load(std::memory_order_seq_cst) & ~closed_bit);
+    }
+
+    // sleeps until `ready(kind)` or the channel is closed, returns false if it was closed
+    auto sleep_until(channel_impl::waiter_kind kind) -> bool
+    {
+        auto& sleepers = kind == channel_impl::waiter_kind::CONSUMER ? m_sleeping_consumers : m_sleeping_producers;
+
+        // announce ourselves before checking readiness, while the other side publishes before checking for sleepers,
+        // so at least one of us is guaranteed to see the other
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        m_signal.wait(
+            kind,
+            [&](const channel_impl::parking_lot&) { return closed() || ready(kind); },
+            [](channel_impl::parking_lot&) {});
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+
+        // even once closed the remaining items must still be drained by consumers, including any a producer claimed
+        // before the close but hasn't finished writing yet
+        return !closed() || (kind == channel_impl::waiter_kind::CONSUMER && !drained());
+    }
+
+    auto wake(channel_impl::waiter_kind kind, notification_type n) -> void
+    {
+        auto& sleepers = kind == channel_impl::waiter_kind::CONSUMER ? m_sleeping_consumers : m_sleeping_producers;
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) != 0) {
+            m_signal.notify(kind, n);
+        }
+    }
+
+    // called by a thread that just completed a claim of `kind`, right after its `wake` (whose fence this relies on).
+    // Claims can complete out of order, and the wakeup for a later cell finds no waiter ready while an earlier cell is
+    // still being written, so whoever completes a claim passes the wakeup on to another waiter of its own kind while
+    // the next cell is ready
+    auto pass_on(channel_impl::waiter_kind kind) -> void
+    {
+        auto& sleepers = kind == channel_impl::waiter_kind::CONSUMER ? m_sleeping_consumers : m_sleeping_producers;
+
+        if (sleepers.load(std::memory_order_seq_cst) != 0 && ready(kind)) {
+            m_signal.notify(kind, notification_type::NOTIFY_ONE);
+        }
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<channel_impl::cell<T>[]> m_cells;
+
+    alignas(impl::cache_line_size) std::atomic<size_t> m_tail { 0 };
+    alignas(impl::cache_line_size) std::atomic<size_t> m_head { 0 };
+    alignas(impl::cache_line_size) std::atomic<size_t> m_sleeping_consumers { 0 };
+    std::atomic<size_t> m_sleeping_producers { 0 };
+    condition_variable<channel_impl::parking_lot> m_signal;
+};
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <safet/critical_section.hpp>
+#include <safet/impl/concepts.hpp>
+#include <safet/impl/hardware.hpp>
+#include <safet/optional.hpp>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace safet {
+namespace combining_critical_section_impl {
+    // the type erased part of an `enter_combined` call the combiner sees
+    template <typename T>
+    class request_base {
+    public:
+        request_base(const request_base&) = delete;
+        request_base(request_base&&) = delete;
+
+        auto operator=(const request_base&) -> request_base& = delete;
+        auto operator=(request_base&&) -> request_base& = delete;
+
+        // the functor's result or exception is stored before the request is marked done
+        auto run(T& value) -> void
+        {
+            try {
+                m_run(*this, value);
+            } catch (...) {
+                m_exception = std::current_exception();
+            }
+
+            m_done.store(true, std::memory_order_release);
+        }
+
+        auto done() const noexcept -> bool
+        {
+            return m_done.load(std::memory_order_acquire);
+        }
+
+        request_base* m_next { nullptr };
+
+    protected:
+        explicit request_base(auto (*run)(request_base&, T&)->void) noexcept
+            : m_run(run)
+        {
+        }
+
+        ~request_base() = default;
+
+        auto rethrow_if_failed() const -> void
+        {
+            if (m_exception) {
+                std::rethrow_exception(m_exception);
+            }
+        }
+
+    private:
+        auto (*m_run)(request_base&, T&) -> void;
+        std::exception_ptr m_exception;
+        std::atomic<bool> m_done { false };
+    };
+
+    template <typename T, typename Functor>
+    class request : public request_base<T> {
+    public:
+        using result_type = std::invoke_result_t<Functor, T&>;
+
+        explicit request(Functor f) noexcept
+            : request_base<T>(&run_functor)
+            , m_functor(std::forward<Functor>(f))
+        {
+        }
+
+        ~request()
+        {
+            if constexpr (!std::is_void_v<result_type>) {
+                if (m_result.engaged()) {
+                    m_result.destroy();
+                }
+            }
+        }
+
+        decltype(auto) result() &&
+        {
+            this->rethrow_if_failed();
+
+            if constexpr (std::is_reference_v<result_type>) {
+                return m_result.get();
+            } else if constexpr (!std::is_void_v<result_type>) {
+                return result_type(std::move(m_result.get()));
+            }
+        }
+
+    private:
+        struct no_result {
+        };
+
+        static auto run_functor(request_base<T>& base, T& value) -> void
+        {
+            auto& self = static_cast<request&>(base);
+            if constexpr (std::is_void_v<result_type>) {
+                std::forward<Functor>(self.m_functor)(value);
+            } else {
+                self.m_result.construct(std::forward<Functor>(self.m_functor)(value));
+            }
+        }
+
+        Functor m_functor;
+        [[no_unique_address]] std::conditional_t<std::is_void_v<result_type>, no_result, optional_impl::storage_for<result_type>> m_result;
+    };
+}
+
+// a `critical_section<T, Mutex>` which additionally supports `enter_combined`, kept apart so plain sections don't carry
+// the combining state.
+//
+// `enter_combined(f)` publishes `f` to the section rather than every contending thread taking the lock in turn, and
+// whichever thread holds the lock runs every published functor in a batch before releasing it. Each caller still
+// receives its own functor's result (or exception), and the value stays in the combining thread's cache rather than
+// moving to each caller's. Pays off for short functors under heavy contention, uncontended it is a little slower than
+// `enter`
+template <typename T, impl::lockable Mutex = std::mutex>
+class combining_critical_section {
+public:
+    template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, Params&&...>>>
+    combining_critical_section(Params&&... params)
+        : m_section(std::forward<Params>(params)...)
+    {
+    }
+
+    combining_critical_section(const combining_critical_section&) = delete;
+    combining_critical_section(combining_critical_section&&) = delete;
+
+    ~combining_critical_section() = default;
+
+    auto operator=(const combining_critical_section&) -> combining_critical_section& = delete;
+    auto operator=(combining_critical_section&&) -> combining_critical_section& = delete;
+
+    // the same semantics as `critical_section::enter`, neither runs nor waits for published functors
+    template <typename Functor>
+    decltype(auto) enter(Functor&& f) &
+    {
+        return m_section.enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) enter(Functor&& f) const&
+    {
+        return m_section.enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(Functor&& f) &
+    {
+        return m_section.try_enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(Functor&& f) const&
+    {
+        return m_section.try_enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) enter_combined(Functor&& f) &
+    {
+        static_assert(impl::invocable<Functor&&, T&>, "enter_combined functor must be invocable with T&");
+
+        // lives on this thread's stack until it is done, so publishing never allocates
+        combining_critical_section_impl::request<T, Functor&&> request { std::forward<Functor>(f) };
+        publish(request);
+
+        auto& mutex = critical_section_impl::access::mutex(m_section);
+        if (mutex.try_lock()) {
+            std::unique_lock guard { mutex, std::adopt_lock };
+            combine();
+        } else {
+            // someone holds the lock, if it's a combiner it's likely to run this request shortly. Only a single
+            // try_lock is spent, so an instrumented `Mutex` counts one failure per call rather than one per spin
+            for (size_t spin = 0; spin < combined_spin_limit && !request.done(); ++spin) {
+                impl::cpu_relax();
+            }
+
+            if (!request.done()) {
+                // the holder isn't combining (e.g. a long `enter`), so block rather than spin. With the lock held the
+                // first batch claimed includes this request, if no earlier combiner already ran it
+                std::unique_lock guard { mutex };
+                combine();
+            }
+        }
+
+        return std::move(request).result();
+    }
+
+    // only available with an instrumented `Mutex` such as `instrumented_mutex`, see `safet/mutex.hpp`
+    auto stats() const requires(impl::instrumented_lockable<Mutex>)
+    {
+        return m_section.stats();
+    }
+
+    auto set_name(std::string_view name) -> void requires(impl::instrumented_lockable<Mutex>)
+    {
+        m_section.set_name(name);
+    }
+
+private:
+    using request_base = combining_critical_section_impl::request_base<T>;
+
+    // published requests form a stack, each pushed by its caller then claimed as a whole by the combiner
+    auto publish(request_base& request) -> void
+    {
+        auto* head = m_combined.load(std::memory_order_relaxed);
+        do {
+            request.m_next = head;
+        } while (!m_combined.compare_exchange_weak(head, &request, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // called with the lock held. Claims at most `max_combined_batches` batches so a combiner isn't held indefinitely
+    // by newly published requests, anything left is combined by its own caller or the next combiner
+    auto combine() -> void
+    {
+        auto& value = critical_section_impl::access::value(m_section);
+
+        for (size_t batch = 0; batch < max_combined_batches; ++batch) {
+            auto* pending = m_combined.exchange(nullptr, std::memory_order_acquire);
+            if (pending == nullptr) {
+                return;
+            }
+
+            // reversed so requests run in the order they were published
+            request_base* ordered { nullptr };
+            while (pending != nullptr) {
+                auto* next = pending->m_next;
+                pending->m_next = ordered;
+                ordered = pending;
+                pending = next;
+            }
+
+            while (ordered != nullptr) {
+                // read before running, once done the request's owner may return and destroy it
+                auto* next = ordered->m_next;
+                ordered->run(value);
+                ordered = next;
+            }
+        }
+    }
+
+    static constexpr size_t max_combined_batches { 4 };
+    static constexpr size_t combined_spin_limit { 1024 };
+
+    critical_section<T, Mutex> m_section;
+    std::atomic<request_base*> m_combined { nullptr };
+};
+}
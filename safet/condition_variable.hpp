@@ -1,12 +1,189 @@
 #pragma once
 
 #include <safet/impl/concepts.hpp>
+#include <safet/impl/coroutine.hpp>
+#include <safet/optional.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
 #include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <variant>
 
 namespace safet {
-template <typename T>
+namespace condition_variable_impl {
+    // keyed waiters are kept in an intrusive list of nodes living on each waiter's stack, guarded by the
+    // condition_variable's mutex. Notifiers call `m_try_wake` on the nodes they consider, which checks the waiter's
+    // condition and wakes it if satisfied
+    template <typename T>
+    struct waiter_node {
+        size_t m_key;
+        auto (*m_try_wake)(waiter_node&, T&) -> bool;
+        waiter_node* m_prev { nullptr };
+        waiter_node* m_next { nullptr };
+        // considered by every notification, whatever its key
+        bool m_unkeyed { false };
+        // set for suspended coroutines, which are resumed once the notifier has released the lock
+        impl::resumable* m_async { nullptr };
+    };
+
+    // coroutines woken by a notifier, resumed in order once it has released the lock so that they are free to use the
+    // condition_variable themselves
+    class resume_list {
+    public:
+        resume_list() = default;
+
+        resume_list(const resume_list&) = delete;
+        resume_list(resume_list&&) = delete;
+
+        ~resume_list()
+        {
+            for (auto* node = m_head; node != nullptr;) {
+                auto* next = node->m_resume_next;
+                impl::resume(*node);
+                node = next;
+            }
+        }
+
+        auto operator=(const resume_list&) -> resume_list& = delete;
+        auto operator=(resume_list&&) -> resume_list& = delete;
+
+        auto push(impl::resumable& node) -> void
+        {
+            node.m_resume_next = nullptr;
+            if (m_tail != nullptr) {
+                m_tail->m_resume_next = &node;
+            } else {
+                m_head = &node;
+            }
+            m_tail = &node;
+        }
+
+    private:
+        impl::resumable* m_head { nullptr };
+        impl::resumable* m_tail { nullptr };
+    };
+
+    // parks on its own flag rather than a condition variable, which for any `Mutex` other than `std::mutex` would be a
+    // `std::condition_variable_any` allocating on every wait
+    template <typename T, typename WaitCondFunctor>
+    struct blocking_waiter : waiter_node<T> {
+        blocking_waiter(size_t key, WaitCondFunctor& wait_functor)
+            : waiter_node<T> { key, &try_wake }
+            , m_wait_functor(wait_functor)
+        {
+        }
+
+        static auto try_wake(waiter_node<T>& node, T& value) -> bool
+        {
+            auto& self = static_cast<blocking_waiter&>(node);
+            if (!self.m_wait_functor(static_cast<const T&>(value))) {
+                return false;
+            }
+
+            // notified while the notifier still holds the lock, which the waiter retakes before it can return (and
+            // destroy `m_woken`)
+            self.m_woken.store(true, std::memory_order_release);
+            self.m_woken.notify_one();
+
+            return true;
+        }
+
+        WaitCondFunctor& m_wait_functor;
+        std::atomic<bool> m_woken { false };
+    };
+
+    // the awaiter of `condition_variable::wait_async`, linked into the condition_variable's waiters from the awaiting
+    // coroutine's frame. Notifiers check `WaitCondFunctor` and call `ReadyFunctor` while they hold the lock, so the
+    // coroutine resumes with the result already in hand
+    template <typename T, typename ConditionVariable, typename WaitCondFunctor, typename ReadyFunctor>
+    class wait_awaiter : waiter_node<T>, impl::resumable {
+    public:
+        using result_type = std::invoke_result_t<ReadyFunctor&&, T&>;
+
+        template <typename W, typename R>
+        wait_awaiter(ConditionVariable& cv, size_t key, bool unkeyed, W&& wait_functor, R&& ready_functor)
+            : waiter_node<T> { key, &try_wake, nullptr, nullptr, unkeyed, nullptr }
+            , m_cv(cv)
+            , m_wait_functor(std::forward<W>(wait_functor))
+            , m_ready_functor(std::forward<R>(ready_functor))
+        {
+            this->m_async = static_cast<impl::resumable*>(this);
+        }
+
+        wait_awaiter(const wait_awaiter&) = delete;
+        wait_awaiter(wait_awaiter&&) = delete;
+
+        auto operator=(const wait_awaiter&) -> wait_awaiter& = delete;
+        auto operator=(wait_awaiter&&) -> wait_awaiter& = delete;
+
+        // the condition can only be checked under the lock, which `await_suspend` takes
+        auto await_ready() const noexcept -> bool
+        {
+            return false;
+        }
+
+        auto await_suspend(std::coroutine_handle<> handle) -> bool
+        {
+            std::unique_lock l { m_cv.m_mutex };
+            if (m_wait_functor(static_cast<const T&>(m_cv.m_value))) {
+                complete(m_cv.m_value);
+                return false;
+            }
+
+            m_handle = handle;
+            m_cv.link(static_cast<waiter_node<T>&>(*this));
+
+            // may be resumed on the notifying thread as soon as the lock is released, so nothing may touch `this` now
+            return true;
+        }
+
+        auto await_resume() -> result_type
+        {
+            if constexpr (!std::is_void_v<result_type>) {
+                return std::move(m_result).value_or([]() -> result_type { std::terminate(); });
+            }
+        }
+
+    private:
+        using stored_type = std::conditional_t<std::is_void_v<result_type>, std::monostate, result_type>;
+
+        static auto try_wake(waiter_node<T>& node, T& value) -> bool
+        {
+            auto& self = static_cast<wait_awaiter&>(node);
+            if (!self.m_wait_functor(static_cast<const T&>(value))) {
+                return false;
+            }
+
+            self.complete(value);
+            return true;
+        }
+
+        auto complete(T& value) -> void
+        {
+            if constexpr (std::is_void_v<result_type>) {
+                std::move(m_ready_functor)(value);
+            } else {
+                m_result.emplace(std::move(m_ready_functor)(value));
+            }
+        }
+
+        ConditionVariable& m_cv;
+        WaitCondFunctor m_wait_functor;
+        ReadyFunctor m_ready_functor;
+        optional<stored_type> m_result;
+    };
+}
+
+// `Mutex` may be any Lockable type, such as the policies in `safet/mutex.hpp`. `std::mutex` gets to use the more
+// efficient `std::condition_variable`, anything else falls back to `std::condition_variable_any`. If `Mutex` supports
+// shared locking `inspect` takes a shared lock
+template <typename T, impl::lockable Mutex = std::mutex>
 class condition_variable {
 public:
     enum class notification_type {
@@ -29,6 +206,8 @@ public:
     auto operator=(const condition_variable&) -> condition_variable& = delete;
     auto operator=(condition_variable&&) -> condition_variable& = delete;
 
+    // wakes unkeyed waiters only, keyed waiters are woken by `modify` or the keyed `notify`. Does not take the lock so
+    // may be called from within any of the functors
     auto notify(notification_type n = notification_type::NOTIFY_ALL) -> void
     {
         switch (n) {
@@ -38,26 +217,111 @@ public:
         case notification_type::NOTIFY_ONE:
             m_cv.notify_one();
             break;
+        case notification_type::NO_NOTIFY:
+            break;
         }
     }
 
+    // wakes the waiters for `key` whose condition is satisfied, as well as all unkeyed waiters. Takes the lock to
+    // check conditions, so must not be called from within any of the functors
+    template <typename Key>
+    requires(!std::is_same_v<std::decay_t<Key>, notification_type>)
+    auto notify(const Key& key) -> void
+    {
+        condition_variable_impl::resume_list resume;
+        {
+            std::unique_lock l { m_mutex };
+            wake_keyed_waiters(hash_key(key), false, resume);
+        }
+
+        m_cv.notify_all();
+    }
+
+    // wakes only waiters for `key`, so for NOTIFY_ONE at most one of its satisfied waiters. Unkeyed waiters are
+    // unaffected, so this is only suitable when every waiter that could care about the change waits on `key`
+    template <typename Key>
+    requires(!std::is_same_v<std::decay_t<Key>, notification_type>)
+    auto notify(const Key& key, notification_type n) -> void
+    {
+        condition_variable_impl::resume_list resume;
+        if (n != notification_type::NO_NOTIFY) {
+            std::unique_lock l { m_mutex };
+            wake_keyed_waiters(hash_key(key), false, resume, n == notification_type::NOTIFY_ONE);
+        }
+    }
+
+    // NOTIFY_ALL wakes every waiter, keyed or not, though keyed waiters whose condition is still unsatisfied are left
+    // asleep. NOTIFY_ONE wakes the first keyed waiter whose condition is satisfied, or otherwise one unkeyed waiter
     template <impl::invocable<T&> ModifyFunctor>
     auto modify(ModifyFunctor&& f, notification_type n = notification_type::NOTIFY_ALL) -> std::invoke_result_t<ModifyFunctor&&, T&>
     {
-        decltype(auto) ret_val = [&]() -> decltype(auto) {
-            std::unique_lock l { m_mutex };
-            return std::forward<ModifyFunctor>(f)(m_value);
-        }();
+        auto keyed_woken = false;
+        condition_variable_impl::resume_list resume;
+
+        if constexpr (impl::invocable_and_returns_something<ModifyFunctor&&, T&>) {
+            decltype(auto) ret_val = [&]() -> decltype(auto) {
+                std::unique_lock l { m_mutex };
+                decltype(auto) result = std::forward<ModifyFunctor>(f)(m_value);
+                keyed_woken = wake_keyed_waiters(n, resume);
+
+                return result;
+            }();
 
-        notify(n);
+            notify_unless_woken(n, keyed_woken);
 
-        return ret_val;
+            return ret_val;
+        } else {
+            {
+                std::unique_lock l { m_mutex };
+                std::forward<ModifyFunctor>(f)(m_value);
+                keyed_woken = wake_keyed_waiters(n, resume);
+            }
+
+            notify_unless_woken(n, keyed_woken);
+        }
+    }
+
+    // as `modify`, but of the keyed waiters only those waiting on `key` are considered. Unkeyed waiters are always
+    // woken, as they could be waiting on anything
+    template <typename Key, impl::invocable<T&> ModifyFunctor>
+    requires(!std::is_same_v<std::decay_t<Key>, notification_type>)
+    auto modify(ModifyFunctor&& f, const Key& key) -> std::invoke_result_t<ModifyFunctor&&, T&>
+    {
+        condition_variable_impl::resume_list resume;
+
+        if constexpr (impl::invocable_and_returns_something<ModifyFunctor&&, T&>) {
+            decltype(auto) ret_val = [&]() -> decltype(auto) {
+                std::unique_lock l { m_mutex };
+                decltype(auto) result = std::forward<ModifyFunctor>(f)(m_value);
+                wake_keyed_waiters(hash_key(key), false, resume);
+
+                return result;
+            }();
+
+            m_cv.notify_all();
+
+            return ret_val;
+        } else {
+            {
+                std::unique_lock l { m_mutex };
+                std::forward<ModifyFunctor>(f)(m_value);
+                wake_keyed_waiters(hash_key(key), false, resume);
+            }
+
+            m_cv.notify_all();
+        }
     }
 
     template <impl::invocable<const T&> InspectFunctor>
     auto inspect(InspectFunctor&& f) const -> std::invoke_result_t<InspectFunctor&&, const T&>
     {
-        std::unique_lock l { m_mutex };
+        auto l = [this]() {
+            if constexpr (impl::shared_lockable<Mutex>) {
+                return std::shared_lock { m_mutex };
+            } else {
+                return std::unique_lock { m_mutex };
+            }
+        }();
         return std::forward<InspectFunctor>(f)(m_value);
     }
 
@@ -112,9 +376,255 @@ public:
         return std::forward<ReadyFunctor>(ready_functor)(std::move(m_value));
     }
 
+    // keyed waits are only woken by notifications for their `key` (or notifications for every key), and only once
+    // `wait_functor` is satisfied, which the notifier checks before waking anyone. This avoids waking every waiter on
+    // every change when each waits on its own condition
+    template <typename Key, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait(const Key& key, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, T&>, "wait ReadyFunctor must be invocable with T&");
+
+        std::unique_lock l { m_mutex };
+        wait_keyed(l, hash_key(key), wait_functor);
+
+        return std::forward<ReadyFunctor>(ready_functor)(m_value);
+    }
+
+    template <typename Key, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait(const Key& key, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) const&
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, const T&>, "wait ReadyFunctor must be invocable with const T&");
+
+        std::unique_lock l { m_mutex };
+        wait_keyed(l, hash_key(key), wait_functor);
+
+        return std::forward<ReadyFunctor>(ready_functor)(m_value);
+    }
+
+    template <typename Key, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait(const Key& key, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &&
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, T&&>, "wait ReadyFunctor must be invocable with T&&");
+
+        std::unique_lock l { m_mutex };
+        wait_keyed(l, hash_key(key), wait_functor);
+
+        return std::forward<ReadyFunctor>(ready_functor)(std::move(m_value));
+    }
+
+    // timed waits call `ready_functor` only if `wait_functor` was satisfied before the deadline. Like
+    // `critical_section::try_enter` the result is wrapped in an optional, or is a bool for void ready functors
+    template <typename Clock, typename Duration, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_until(const std::chrono::time_point<Clock, Duration>& deadline, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait_until WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, T&>, "wait_until ReadyFunctor must be invocable with T&");
+
+        std::unique_lock l { m_mutex };
+        const auto ready = m_cv.wait_until(l, deadline, [&]() {
+            return wait_functor(static_cast<const T&>(m_value));
+        });
+
+        return call_if_ready(ready, std::forward<ReadyFunctor>(ready_functor), m_value);
+    }
+
+    template <typename Clock, typename Duration, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_until(const std::chrono::time_point<Clock, Duration>& deadline, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) const&
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait_until WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, const T&>, "wait_until ReadyFunctor must be invocable with const T&");
+
+        std::unique_lock l { m_mutex };
+        const auto ready = m_cv.wait_until(l, deadline, [&]() {
+            return wait_functor(m_value);
+        });
+
+        return call_if_ready(ready, std::forward<ReadyFunctor>(ready_functor), m_value);
+    }
+
+    template <typename Clock, typename Duration, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_until(const std::chrono::time_point<Clock, Duration>& deadline, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &&
+    {
+        static_assert(impl::invocable<WaitCondFunctor&, const T&>, "wait_until WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<ReadyFunctor&&, T&&>, "wait_until ReadyFunctor must be invocable with T&&");
+
+        std::unique_lock l { m_mutex };
+        const auto ready = m_cv.wait_until(l, deadline, [&]() {
+            return wait_functor(static_cast<const T&>(m_value));
+        });
+
+        return call_if_ready(ready, std::forward<ReadyFunctor>(ready_functor), std::move(m_value));
+    }
+
+    template <typename Rep, typename Period, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_for(const std::chrono::duration<Rep, Period>& timeout, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &
+    {
+        return wait_until(std::chrono::steady_clock::now() + timeout, std::forward<WaitCondFunctor>(wait_functor), std::forward<ReadyFunctor>(ready_functor));
+    }
+
+    template <typename Rep, typename Period, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_for(const std::chrono::duration<Rep, Period>& timeout, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) const&
+    {
+        return wait_until(std::chrono::steady_clock::now() + timeout, std::forward<WaitCondFunctor>(wait_functor), std::forward<ReadyFunctor>(ready_functor));
+    }
+
+    template <typename Rep, typename Period, typename WaitCondFunctor, typename ReadyFunctor>
+    decltype(auto) wait_for(const std::chrono::duration<Rep, Period>& timeout, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) &&
+    {
+        return std::move(*this).wait_until(std::chrono::steady_clock::now() + timeout, std::forward<WaitCondFunctor>(wait_functor), std::forward<ReadyFunctor>(ready_functor));
+    }
+
+    // `co_await cv.wait_async(wait_functor, ready_functor)` suspends the awaiting coroutine until `wait_functor` is
+    // satisfied, then produces the result of `ready_functor`. Both are called under the lock, by whichever thread's
+    // `modify` or keyed `notify` satisfies the condition, and the coroutine is resumed on that thread once it has
+    // released the lock. The lock-free `notify(notification_type)` cannot wake coroutines. A suspended coroutine must
+    // not be destroyed before it is resumed
+    template <typename WaitCondFunctor, typename ReadyFunctor>
+    auto wait_async(WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) & -> condition_variable_impl::wait_awaiter<T, condition_variable, std::decay_t<WaitCondFunctor>, std::decay_t<ReadyFunctor>>
+    {
+        static_assert(impl::invocable<std::decay_t<WaitCondFunctor>&, const T&>, "wait_async WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<std::decay_t<ReadyFunctor>&&, T&>, "wait_async ReadyFunctor must be invocable with T&");
+
+        return { *this, 0, true, std::forward<WaitCondFunctor>(wait_functor), std::forward<ReadyFunctor>(ready_functor) };
+    }
+
+    // as the keyed `wait`, only notifications for `key` (or for every key) consider waking the coroutine
+    template <typename Key, typename WaitCondFunctor, typename ReadyFunctor>
+    auto wait_async(const Key& key, WaitCondFunctor&& wait_functor, ReadyFunctor&& ready_functor) & -> condition_variable_impl::wait_awaiter<T, condition_variable, std::decay_t<WaitCondFunctor>, std::decay_t<ReadyFunctor>>
+    {
+        static_assert(impl::invocable<std::decay_t<WaitCondFunctor>&, const T&>, "wait_async WaitCondFunctor must be invocable with const T&");
+        static_assert(impl::invocable<std::decay_t<ReadyFunctor>&&, T&>, "wait_async ReadyFunctor must be invocable with T&");
+
+        return { *this, hash_key(key), false, std::forward<WaitCondFunctor>(wait_functor), std::forward<ReadyFunctor>(ready_functor) };
+    }
+
 private:
-    mutable std::mutex m_mutex;
-    std::condition_variable m_cv;
+    using waiter_node = condition_variable_impl::waiter_node<T>;
+
+    template <typename Key>
+    static auto hash_key(const Key& key) -> size_t
+    {
+        return std::hash<Key> {}(key);
+    }
+
+    // must hold `m_mutex`, links a waiter to `m_waiters` until a notifier finds its condition satisfied
+    template <typename Lock, typename WaitCondFunctor>
+    auto wait_keyed(Lock& l, size_t key, WaitCondFunctor& wait_functor) const -> void
+    {
+        using blocking_waiter = condition_variable_impl::blocking_waiter<T, WaitCondFunctor>;
+
+        blocking_waiter waiter { key, wait_functor };
+
+        // the condition may have changed again since the notifier checked it, so we check and wait once more if
+        // necessary, just as any condition variable waiter must
+        while (!wait_functor(static_cast<const T&>(m_value))) {
+            waiter.m_woken.store(false, std::memory_order_relaxed);
+            link(waiter);
+
+            l.unlock();
+            waiter.m_woken.wait(false, std::memory_order_acquire);
+            l.lock();
+        }
+    }
+
+    // must hold `m_mutex`
+    auto link(waiter_node& node) const -> void
+    {
+        node.m_prev = nullptr;
+        node.m_next = m_waiters;
+        if (m_waiters != nullptr) {
+            m_waiters->m_prev = &node;
+        }
+        m_waiters = &node;
+    }
+
+    // must hold `m_mutex`
+    auto unlink(waiter_node& node) const -> void
+    {
+        if (node.m_prev != nullptr) {
+            node.m_prev->m_next = node.m_next;
+        } else {
+            m_waiters = node.m_next;
+        }
+        if (node.m_next != nullptr) {
+            node.m_next->m_prev = node.m_prev;
+        }
+    }
+
+    // must hold `m_mutex`, wakes (and unlinks) the waiters for `key` whose condition is satisfied, or every key if
+    // `any_key` is set. Returns whether any waiter was woken
+    auto wake_keyed_waiters(size_t key, bool any_key, condition_variable_impl::resume_list& resume, bool only_one = false) -> bool
+    {
+        auto woken = false;
+
+        for (auto* node = m_waiters; node != nullptr;) {
+            auto* next = node->m_next;
+
+            if ((any_key || node->m_unkeyed || node->m_key == key) && node->m_try_wake(*node, m_value)) {
+                unlink(*node);
+                if (node->m_async != nullptr) {
+                    resume.push(*node->m_async);
+                }
+                woken = true;
+
+                if (only_one) {
+                    break;
+                }
+            }
+
+            node = next;
+        }
+
+        return woken;
+    }
+
+    auto wake_keyed_waiters(notification_type n, condition_variable_impl::resume_list& resume) -> bool
+    {
+        if (m_waiters == nullptr || n == notification_type::NO_NOTIFY) {
+            return false;
+        }
+
+        return wake_keyed_waiters(0, true, resume, n == notification_type::NOTIFY_ONE);
+    }
+
+    auto notify_unless_woken(notification_type n, bool keyed_woken) -> void
+    {
+        if (n != notification_type::NOTIFY_ONE || !keyed_woken) {
+            notify(n);
+        }
+    }
+
+    template <typename ReadyFunctor, typename Value>
+    static decltype(auto) call_if_ready(bool ready, ReadyFunctor&& ready_functor, Value&& value)
+    {
+        if constexpr (impl::invocable_and_returns_something<ReadyFunctor&&, Value&&>) {
+            return [&]() -> optional<std::invoke_result_t<ReadyFunctor&&, Value&&>> {
+                if (ready) {
+                    return std::forward<ReadyFunctor>(ready_functor)(std::forward<Value>(value));
+                } else {
+                    return std::nullopt;
+                }
+            }();
+        } else {
+            if (ready) {
+                std::forward<ReadyFunctor>(ready_functor)(std::forward<Value>(value));
+            }
+
+            return ready;
+        }
+    }
+
+    using cv_type = std::conditional_t<std::is_same_v<Mutex, std::mutex>, std::condition_variable, std::condition_variable_any>;
+
+    mutable Mutex m_mutex;
+    mutable cv_type m_cv;
+    mutable waiter_node* m_waiters { nullptr };
     T m_value;
+
+    template <typename, typename, typename, typename>
+    friend class condition_variable_impl::wait_awaiter;
 };
 }
\ No newline at end of file
@@ -2,6 +2,15 @@
 
 #include <safet/variant.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace safet {
 template <typename T>
 class cow {
@@ -86,4 +95,243 @@ public:
 private:
     variant<T, const T&> m_value;
 };
+
+namespace cow_impl {
+    template <typename T>
+    struct shared_block {
+        template <typename... Args>
+        explicit shared_block(Args&&... args)
+            : m_value(std::forward<Args>(args)...)
+        {
+        }
+
+        std::atomic<size_t> m_refs { 1 };
+        T m_value;
+    };
+}
+
+// a copy on write value that shares ownership rather than borrowing: copies share a single reference counted value, and
+// the first `get_mutable()` on a copy whose value is shared gives it a value of its own. Copies of a `shared_cow` may be
+// used from different threads concurrently, as with `std::shared_ptr`, but a single `shared_cow` may not. A moved-from
+// `shared_cow` may only be assigned to or destroyed
+template <typename T>
+class shared_cow {
+public:
+    static_assert(std::is_copy_constructible_v<T>, "shared_cow type must be copy constructible");
+
+    shared_cow(T value)
+        : m_block(new block_type(std::move(value)))
+    {
+    }
+
+    template <typename... Args>
+    explicit shared_cow(std::in_place_t, Args&&... args)
+        : m_block(new block_type(std::forward<Args>(args)...))
+    {
+    }
+
+    shared_cow(const shared_cow& copy) noexcept
+        : m_block(copy.m_block)
+    {
+        // a new reference is created from an existing one, so nothing needs to be ordered against it
+        m_block->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    shared_cow(shared_cow&& move) noexcept
+        : m_block(std::exchange(move.m_block, nullptr))
+    {
+    }
+
+    ~shared_cow()
+    {
+        release();
+    }
+
+    auto operator=(const shared_cow& copy) noexcept -> shared_cow&
+    {
+        if (copy.m_block != m_block) {
+            copy.m_block->m_refs.fetch_add(1, std::memory_order_relaxed);
+            release();
+            m_block = copy.m_block;
+        }
+
+        return *this;
+    }
+    auto operator=(shared_cow&& move) noexcept -> shared_cow&
+    {
+        if (&move != this) {
+            release();
+            m_block = std::exchange(move.m_block, nullptr);
+        }
+
+        return *this;
+    }
+
+    auto operator=(T value) -> shared_cow&
+    {
+        set(std::move(value));
+
+        return *this;
+    }
+
+    auto get_const() const -> const T&
+    {
+        return m_block->m_value;
+    }
+
+    // copies the value first only if another `shared_cow` shares it
+    auto get_mutable() -> T&
+    {
+        if (shared()) {
+            auto* unshared = new block_type(std::as_const(m_block->m_value));
+            release();
+            m_block = unshared;
+        }
+
+        return m_block->m_value;
+    }
+
+    // assigns in place when the value isn't shared, otherwise replaces it without copying it first
+    auto set(T value) -> T&
+    {
+        if (shared()) {
+            auto* replacement = new block_type(std::move(value));
+            release();
+            m_block = replacement;
+        } else {
+            m_block->m_value = std::move(value);
+        }
+
+        return m_block->m_value;
+    }
+
+    // whether another `shared_cow` currently shares this one's value. Once false it stays false until this `shared_cow`
+    // is copied, as sharing can only start from it
+    auto shared() const -> bool
+    {
+        // acquire, so that when we're the last owner, reads by owners that have since released happen before our writes
+        return m_block->m_refs.load(std::memory_order_acquire) != 1;
+    }
+
+    auto operator->() const -> const T*
+    {
+        return &m_block->m_value;
+    }
+
+private:
+    using block_type = cow_impl::shared_block<T>;
+
+    auto release() -> void
+    {
+        // acq_rel, so every owner's use of the value happens before whichever of them destroys it
+        if (m_block != nullptr && m_block->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete m_block;
+        }
+    }
+
+    block_type* m_block;
+};
+
+namespace cow_impl {
+    template <typename View>
+    auto subview(View view, size_t offset, size_t count) -> View
+    {
+        offset = std::min(offset, view.size());
+        count = std::min(count, view.size() - offset);
+
+        return View { view.data() + offset, count };
+    }
+}
+
+// a copy on write contiguous range that either owns its data as an `Owned` container or borrows a `View` of someone
+// else's, e.g. a field of a larger buffer being parsed. Unlike `cow`, a borrow can refer to part of an object (a substring
+// or sub-span) rather than only to a whole one, and `get_mutable()` materializes only the borrowed part. A borrowing slice
+// must not outlive the data it views
+template <typename Owned, typename View>
+class cow_slice {
+public:
+    using owned_type = Owned;
+    using view_type = View;
+
+    static constexpr auto npos = static_cast<size_t>(-1);
+
+    cow_slice()
+        : m_value(std::in_place_index_t<1> {})
+    {
+    }
+
+    cow_slice(Owned value)
+        : m_value(std::in_place_index_t<0> {}, std::move(value))
+    {
+    }
+    cow_slice(View view)
+        : m_value(std::in_place_index_t<1> {}, view)
+    {
+    }
+    cow_slice(std::reference_wrapper<const Owned> ref)
+        : m_value(std::in_place_index_t<1> {}, View { ref.get() })
+    {
+    }
+
+    auto get_const() const -> View
+    {
+        return m_value.visit([](const auto& value) -> View { return View { value }; });
+    }
+
+    // copies the viewed data into an owned container first if this slice is borrowed
+    auto get_mutable() -> Owned&
+    {
+        return m_value.visit(
+            overloaded {
+                [this](View view) -> Owned& {
+                    return m_value.template emplace<0>(view.begin(), view.end());
+                },
+                [](Owned& value) -> Owned& {
+                    return value;
+                } });
+    }
+
+    auto set(Owned value) -> Owned&
+    {
+        return m_value.template emplace<0>(std::move(value));
+    }
+
+    auto set(View view) -> View
+    {
+        return m_value.template emplace<1>(view);
+    }
+
+    auto borrowed() const -> bool
+    {
+        return m_value.index() == 1;
+    }
+
+    // a borrowed slice of `count` elements from `offset` (clamped to the end), viewing this slice's data. It remains
+    // valid for as long as this slice's data does; if this slice owns its data, for as long as that isn't modified
+    auto slice(size_t offset, size_t count = npos) const -> cow_slice
+    {
+        return cow_slice { cow_impl::subview(get_const(), offset, count) };
+    }
+
+    auto size() const -> size_t
+    {
+        return get_const().size();
+    }
+
+    auto empty() const -> bool
+    {
+        return get_const().empty();
+    }
+
+    friend auto operator==(const cow_slice& lhs, const cow_slice& rhs) -> bool
+    {
+        return std::ranges::equal(lhs.get_const(), rhs.get_const());
+    }
+
+private:
+    variant<Owned, View> m_value;
+};
+
+// `std::string` keeps short owned strings inline in the slice, so only long transformed fields allocate
+using cow_string = cow_slice<std::string, std::string_view>;
+using cow_bytes = cow_slice<std::vector<std::byte>, std::span<const std::byte>>;
 }
\ No newline at end of file
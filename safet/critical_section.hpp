@@ -3,10 +3,25 @@
 #include <safet/impl/concepts.hpp>
 #include <safet/optional.hpp>
 
+#include <chrono>
+#include <coroutine>
 #include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <tuple>
 
 namespace safet {
-template <typename T>
+namespace critical_section_impl {
+    struct access;
+
+    template <typename Section, typename Functor>
+    class enter_awaiter;
+}
+
+// `Mutex` may be any type satisfying the standard Lockable requirements. If it additionally provides the shared
+// locking functions (e.g. `std::shared_mutex`) then const entry to the critical_section takes a shared lock, allowing
+// any number of readers to be inside at once, while mutable and r-value entry still take an exclusive lock
+template <typename T, impl::lockable Mutex = std::mutex>
 class critical_section {
 public:
     template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, Params&&...>>>
@@ -15,19 +30,21 @@ public:
     {
     }
 
-    critical_section(const critical_section<T>& copy) = delete;
-    critical_section(critical_section<T>&& move) = delete;
+    critical_section(const critical_section& copy) = delete;
+    critical_section(critical_section&& move) = delete;
 
     ~critical_section() = default;
 
-    auto operator=(const critical_section<T>& copy) -> critical_section<T>& = delete;
-    auto operator=(critical_section<T>&& move) -> critical_section<T>& = delete;
+    auto operator=(const critical_section& copy) -> critical_section& = delete;
+    auto operator=(critical_section&& move) -> critical_section& = delete;
 
-    auto operator=(T new_value) -> critical_section<T>&
+    auto operator=(T new_value) -> critical_section&
     {
-        enter([new_value = std::move(new_value)](T& value) {
+        enter([&new_value](T& value) {
             value = std::move(new_value);
         });
+
+        return *this;
     }
 
     template <typename Functor>
@@ -48,7 +65,7 @@ public:
     {
         static_assert(impl::invocable<Functor&&, const T&>, "enter functor must be invocable with const T&");
 
-        std::unique_lock guard { m_mutex };
+        auto guard = const_guard();
         if constexpr (impl::invocable_and_returns_something<Functor&&, const T&>) {
             return std::forward<Functor>(f)(m_value);
         } else {
@@ -75,23 +92,7 @@ public:
         static_assert(impl::invocable<Functor&&, T&>, "enter functor must be invocable with T&");
 
         std::unique_lock guard { m_mutex, std::try_to_lock };
-        if constexpr (impl::invocable_and_returns_something<Functor&&, T&>) {
-            return [&]() -> optional<std::invoke_result_t<Functor&&, T&>> {
-                if (guard.owns_lock()) {
-                    return std::forward<Functor>(f)(m_value);
-                } else {
-                    return std::nullopt;
-                }
-            }();
-        } else {
-            if (guard.owns_lock()) {
-                std::forward<Functor>(f)(m_value);
-
-                return true;
-            }
-
-            return false;
-        }
+        return call_if_owned(guard, std::forward<Functor>(f), m_value);
     }
 
     template <typename Functor>
@@ -99,18 +100,117 @@ public:
     {
         static_assert(impl::invocable<Functor&&, const T&>, "enter functor must be invocable with const T&");
 
+        auto guard = const_guard(std::try_to_lock);
+        return call_if_owned(guard, std::forward<Functor>(f), m_value);
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(Functor&& f) &&
+    {
+        static_assert(impl::invocable<Functor&&, T&&>, "enter functor must be invocable with T&&");
+
         std::unique_lock guard { m_mutex, std::try_to_lock };
-        if constexpr (impl::invocable_and_returns_something<Functor&&, const T&>) {
-            return [&]() -> optional<std::invoke_result_t<Functor&&, const T&>> {
+        return call_if_owned(guard, std::forward<Functor>(f), std::move(m_value));
+    }
+
+    // as `try_enter` but keeps trying to enter until `deadline` has passed, requires a timed `Mutex` (e.g.
+    // `std::timed_mutex` or any of the policies in `safet/mutex.hpp`)
+    template <typename Clock, typename Duration, typename Functor>
+    decltype(auto) try_enter_until(const std::chrono::time_point<Clock, Duration>& deadline, Functor&& f) &
+    {
+        static_assert(impl::timed_lockable<Mutex>, "try_enter_until requires a timed Mutex");
+        static_assert(impl::invocable<Functor&&, T&>, "enter functor must be invocable with T&");
+
+        std::unique_lock guard { m_mutex, deadline };
+        return call_if_owned(guard, std::forward<Functor>(f), m_value);
+    }
+
+    template <typename Clock, typename Duration, typename Functor>
+    decltype(auto) try_enter_until(const std::chrono::time_point<Clock, Duration>& deadline, Functor&& f) const&
+    {
+        static_assert(impl::timed_lockable<Mutex>, "try_enter_until requires a timed Mutex");
+        static_assert(impl::invocable<Functor&&, const T&>, "enter functor must be invocable with const T&");
+
+        auto guard = const_guard(deadline);
+        return call_if_owned(guard, std::forward<Functor>(f), m_value);
+    }
+
+    template <typename Clock, typename Duration, typename Functor>
+    decltype(auto) try_enter_until(const std::chrono::time_point<Clock, Duration>& deadline, Functor&& f) &&
+    {
+        static_assert(impl::timed_lockable<Mutex>, "try_enter_until requires a timed Mutex");
+        static_assert(impl::invocable<Functor&&, T&&>, "enter functor must be invocable with T&&");
+
+        std::unique_lock guard { m_mutex, deadline };
+        return call_if_owned(guard, std::forward<Functor>(f), std::move(m_value));
+    }
+
+    template <typename Rep, typename Period, typename Functor>
+    decltype(auto) try_enter_for(const std::chrono::duration<Rep, Period>& timeout, Functor&& f) &
+    {
+        return try_enter_until(std::chrono::steady_clock::now() + timeout, std::forward<Functor>(f));
+    }
+
+    template <typename Rep, typename Period, typename Functor>
+    decltype(auto) try_enter_for(const std::chrono::duration<Rep, Period>& timeout, Functor&& f) const&
+    {
+        return try_enter_until(std::chrono::steady_clock::now() + timeout, std::forward<Functor>(f));
+    }
+
+    template <typename Rep, typename Period, typename Functor>
+    decltype(auto) try_enter_for(const std::chrono::duration<Rep, Period>& timeout, Functor&& f) &&
+    {
+        return std::move(*this).try_enter_until(std::chrono::steady_clock::now() + timeout, std::forward<Functor>(f));
+    }
+
+    // `co_await section.enter_async(f)` suspends the awaiting coroutine rather than blocking while the section is held,
+    // then calls `f` with the value once the coroutine has been handed the lock, producing its result. Requires a
+    // `Mutex` supporting `lock_async`, such as `async_mutex`
+    template <typename Functor>
+    auto enter_async(Functor&& f) & -> critical_section_impl::enter_awaiter<critical_section, std::decay_t<Functor>>
+    {
+        static_assert(impl::async_lockable<Mutex>, "enter_async requires a Mutex supporting lock_async");
+        static_assert(impl::invocable<std::decay_t<Functor>&&, T&>, "enter_async functor must be invocable with T&");
+
+        return critical_section_impl::enter_awaiter<critical_section, std::decay_t<Functor>> { *this, std::forward<Functor>(f) };
+    }
+
+    template <typename Functor>
+    auto enter_async(Functor&& f) const& -> critical_section_impl::enter_awaiter<const critical_section, std::decay_t<Functor>>
+    {
+        static_assert(impl::async_lockable<Mutex>, "enter_async requires a Mutex supporting lock_async");
+        static_assert(impl::invocable<std::decay_t<Functor>&&, const T&>, "enter_async on const critical_section functor must be invocable with const T&");
+
+        return critical_section_impl::enter_awaiter<const critical_section, std::decay_t<Functor>> { *this, std::forward<Functor>(f) };
+    }
+
+    // only available with an instrumented `Mutex` such as `instrumented_mutex`, see `safet/mutex.hpp`
+    auto stats() const requires(impl::instrumented_lockable<Mutex>)
+    {
+        return m_mutex.stats();
+    }
+
+    auto set_name(std::string_view name) -> void requires(impl::instrumented_lockable<Mutex>)
+    {
+        m_mutex.set_name(name);
+    }
+
+private:
+    // shared by all the try_enter flavours, returns optional for functors that return something or bool otherwise
+    template <typename Guard, typename Functor, typename Value>
+    static decltype(auto) call_if_owned(Guard& guard, Functor&& f, Value&& value)
+    {
+        if constexpr (impl::invocable_and_returns_something<Functor&&, Value&&>) {
+            return [&]() -> optional<std::invoke_result_t<Functor&&, Value&&>> {
                 if (guard.owns_lock()) {
-                    return std::forward<Functor>(f)(m_value);
+                    return std::forward<Functor>(f)(std::forward<Value>(value));
                 } else {
                     return std::nullopt;
                 }
             }();
         } else {
             if (guard.owns_lock()) {
-                std::forward<Functor>(f)(m_value);
+                std::forward<Functor>(f)(std::forward<Value>(value));
 
                 return true;
             }
@@ -119,23 +219,169 @@ public:
         }
     }
 
-    template <typename Functor>
-    decltype(auto) try_enter(Functor&& f) &&
+    template <typename... LockArgs>
+    auto const_guard(const LockArgs&... lock_args) const
     {
-        static_assert(impl::invocable<Functor&&, T&&>, "enter functor must be invocable with T&&");
+        if constexpr (impl::shared_lockable<Mutex>) {
+            return std::shared_lock { m_mutex, lock_args... };
+        } else {
+            return std::unique_lock { m_mutex, lock_args... };
+        }
+    }
 
-        std::unique_lock guard { m_mutex, std::try_to_lock };
-        if constexpr (impl::invocable_and_returns_something<Functor&&, T&&>) {
-            return [&]() -> optional<std::invoke_result_t<Functor&&, T&&>> {
-                if (guard.owns_lock()) {
-                    return std::forward<Functor>(f)(std::move(m_value));
+    mutable Mutex m_mutex;
+    T m_value;
+
+    friend struct critical_section_impl::access;
+};
+
+// readers take a shared lock and never serialize each other, writers take an exclusive lock
+template <typename T>
+using shared_critical_section = critical_section<T, std::shared_mutex>;
+
+namespace critical_section_impl {
+    template <typename T>
+    struct is_critical_section : std::false_type {
+    };
+
+    template <typename T, typename Mutex>
+    struct is_critical_section<critical_section<T, Mutex>> : std::true_type {
+    };
+
+    template <typename T>
+    concept critical_section_reference = std::is_lvalue_reference_v<T> && is_critical_section<std::remove_cvref_t<T>>::value;
+
+    struct access {
+        // deferred so all guards can be locked together, shared if the section is const and supports it
+        template <typename T, typename Mutex>
+        static auto guard(critical_section<T, Mutex>& cs)
+        {
+            return std::unique_lock { cs.m_mutex, std::defer_lock };
+        }
+        template <typename T, typename Mutex>
+        static auto guard(const critical_section<T, Mutex>& cs)
+        {
+            return cs.const_guard(std::defer_lock);
+        }
+
+        template <typename T, typename Mutex>
+        static auto value(critical_section<T, Mutex>& cs) -> T&
+        {
+            return cs.m_value;
+        }
+        template <typename T, typename Mutex>
+        static auto value(const critical_section<T, Mutex>& cs) -> const T&
+        {
+            return cs.m_value;
+        }
+
+        template <typename T, typename Mutex>
+        static auto mutex(const critical_section<T, Mutex>& cs) -> Mutex&
+        {
+            return cs.m_mutex;
+        }
+    };
+
+    // holds the functor (and the mutex's own awaiter, linking this coroutine into its waiters) in the awaiting
+    // coroutine's frame, so suspending never allocates
+    template <typename Section, typename Functor>
+    class enter_awaiter {
+    public:
+        template <typename F>
+        enter_awaiter(Section& section, F&& f)
+            : m_section(section)
+            , m_functor(std::forward<F>(f))
+            , m_lock(access::mutex(section).lock_async())
+        {
+        }
+
+        enter_awaiter(const enter_awaiter&) = delete;
+        enter_awaiter(enter_awaiter&&) = delete;
+
+        auto operator=(const enter_awaiter&) -> enter_awaiter& = delete;
+        auto operator=(enter_awaiter&&) -> enter_awaiter& = delete;
+
+        auto await_ready() -> bool
+        {
+            return m_lock.await_ready();
+        }
+
+        auto await_suspend(std::coroutine_handle<> handle) -> bool
+        {
+            return m_lock.await_suspend(handle);
+        }
+
+        decltype(auto) await_resume()
+        {
+            m_lock.await_resume();
+
+            std::unique_lock guard { access::mutex(m_section), std::adopt_lock };
+            return std::move(m_functor)(access::value(m_section));
+        }
+
+    private:
+        Section& m_section;
+        Functor m_functor;
+        decltype(access::mutex(std::declval<Section&>()).lock_async()) m_lock;
+    };
+
+    template <typename... Guards>
+    auto lock_all(Guards&... guards) -> void
+    {
+        if constexpr (sizeof...(Guards) == 1) {
+            (guards.lock(), ...);
+        } else {
+            std::lock(guards...);
+        }
+    }
+
+    template <typename... Guards>
+    auto try_lock_all(Guards&... guards) -> bool
+    {
+        if constexpr (sizeof...(Guards) == 1) {
+            return (guards.try_lock() && ...);
+        } else {
+            // std::try_lock returns the index of the first failure or -1 upon success
+            return std::try_lock(guards...) == -1;
+        }
+    }
+
+    template <typename Params, size_t... Is>
+    decltype(auto) enter_helper(Params&& params, std::index_sequence<Is...>)
+    {
+        using functor_type = std::tuple_element_t<sizeof...(Is), std::remove_reference_t<Params>>;
+
+        static_assert((critical_section_reference<std::tuple_element_t<Is, std::remove_reference_t<Params>>> && ...), "enter must be given l-value critical_sections followed by a functor");
+        static_assert(impl::invocable<functor_type, decltype(access::value(std::get<Is>(params)))...>, "enter functor must be invocable with the value of each critical_section");
+
+        auto guards = std::tuple { access::guard(std::get<Is>(params))... };
+        std::apply([](auto&... g) { lock_all(g...); }, guards);
+
+        return std::forward<functor_type>(std::get<sizeof...(Is)>(params))(access::value(std::get<Is>(params))...);
+    }
+
+    template <typename Params, size_t... Is>
+    decltype(auto) try_enter_helper(Params&& params, std::index_sequence<Is...>)
+    {
+        using functor_type = std::tuple_element_t<sizeof...(Is), std::remove_reference_t<Params>>;
+
+        static_assert((critical_section_reference<std::tuple_element_t<Is, std::remove_reference_t<Params>>> && ...), "try_enter must be given l-value critical_sections followed by a functor");
+        static_assert(impl::invocable<functor_type, decltype(access::value(std::get<Is>(params)))...>, "try_enter functor must be invocable with the value of each critical_section");
+
+        auto guards = std::tuple { access::guard(std::get<Is>(params))... };
+        const auto locked = std::apply([](auto&... g) { return try_lock_all(g...); }, guards);
+
+        if constexpr (impl::invocable_and_returns_something<functor_type, decltype(access::value(std::get<Is>(params)))...>) {
+            return [&]() -> optional<std::invoke_result_t<functor_type, decltype(access::value(std::get<Is>(params)))...>> {
+                if (locked) {
+                    return std::forward<functor_type>(std::get<sizeof...(Is)>(params))(access::value(std::get<Is>(params))...);
                 } else {
                     return std::nullopt;
                 }
             }();
         } else {
-            if (guard.owns_lock()) {
-                std::forward<Functor>(f)(std::move(m_value));
+            if (locked) {
+                std::forward<functor_type>(std::get<sizeof...(Is)>(params))(access::value(std::get<Is>(params))...);
 
                 return true;
             }
@@ -143,9 +389,24 @@ public:
             return false;
         }
     }
+}
 
-private:
-    mutable std::mutex m_mutex;
-    T m_value;
-};
+// `enter(cs_a, cs_b, ..., f)` locks every critical_section together using the same deadlock avoidance as
+// `std::scoped_lock`, then calls `f` with each guarded value in the order the sections were given. Const sections are
+// passed to `f` as const references (and take a shared lock if supported). The same section must not be passed twice
+template <typename... Params>
+requires(sizeof...(Params) >= 2)
+decltype(auto) enter(Params&&... params)
+{
+    return critical_section_impl::enter_helper(std::forward_as_tuple(std::forward<Params>(params)...), std::make_index_sequence<sizeof...(Params) - 1> {});
+}
+
+// as `enter` but only calls `f` if every critical_section could be entered immediately, returning optional (or bool for
+// void functors) in the same manner as `critical_section::try_enter`
+template <typename... Params>
+requires(sizeof...(Params) >= 2)
+decltype(auto) try_enter(Params&&... params)
+{
+    return critical_section_impl::try_enter_helper(std::forward_as_tuple(std::forward<Params>(params)...), std::make_index_sequence<sizeof...(Params) - 1> {});
+}
 }
@@ -3,7 +3,14 @@
 #include <safet/impl/concepts.hpp>
 #include <safet/optional.hpp>
 
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
 namespace safet {
+// runs `Functor` when destroyed. Each copy runs it too, so prefer `scope_exit` for a cleanup that must run exactly once
 template <impl::invocable Functor>
 class finally {
 public:
@@ -19,21 +26,255 @@ public:
         move.m_finally = std::nullopt;
     }
 
-    auto operator=(const finally&) -> finally& = default;
+    // assigning over a finally runs its pending cleanup, just as destroying it would
+    auto operator=(const finally& copy) -> finally&
+    {
+        if (&copy != this) {
+            run();
+            m_finally = copy.m_finally;
+        }
+
+        return *this;
+    }
     auto operator=(finally&& move) -> finally&
     {
-        m_finally = std::move(move.m_finally);
-        move.m_finally = std::nullopt;
+        if (&move != this) {
+            run();
+            m_finally = std::move(move.m_finally);
+            move.m_finally = std::nullopt;
+        }
+
+        return *this;
     }
 
     ~finally()
+    {
+        run();
+    }
+
+private:
+    auto run() -> void
     {
         std::move(m_finally).if_set([](Functor&& finally) {
             std::move(finally)();
         });
+        m_finally = std::nullopt;
     }
 
-private:
     optional<Functor> m_finally;
 };
-}
\ No newline at end of file
+
+namespace finally_impl {
+    struct on_exit {
+        static constexpr bool may_throw { false };
+
+        auto should_run() const noexcept -> bool
+        {
+            return true;
+        }
+    };
+
+    // exits by an exception are told apart by whether more exceptions are in flight than when the guard was created
+    struct on_failure {
+        static constexpr bool may_throw { false };
+
+        auto should_run() const noexcept -> bool
+        {
+            return std::uncaught_exceptions() > m_exceptions;
+        }
+
+        int m_exceptions { std::uncaught_exceptions() };
+    };
+
+    // the functor only runs when nothing is unwinding, so it may throw out of the guard
+    struct on_success {
+        static constexpr bool may_throw { true };
+
+        auto should_run() const noexcept -> bool
+        {
+            return std::uncaught_exceptions() <= m_exceptions;
+        }
+
+        int m_exceptions { std::uncaught_exceptions() };
+    };
+
+    // the functor is stored directly next to a one byte flag, and guards move but never copy, so the functor runs at
+    // most once
+    template <typename Functor, typename Condition>
+    class scope_guard {
+    public:
+        explicit scope_guard(Functor f) noexcept(std::is_nothrow_move_constructible_v<Functor>)
+            : m_functor(std::move(f))
+        {
+        }
+
+        scope_guard(const scope_guard&) = delete;
+        scope_guard(scope_guard&& move) noexcept(std::is_nothrow_move_constructible_v<Functor>)
+            : m_functor(std::move(move.m_functor))
+            , m_condition(move.m_condition)
+            , m_active(std::exchange(move.m_active, false))
+        {
+        }
+
+        ~scope_guard() noexcept(!Condition::may_throw || noexcept(std::declval<Functor&>()()))
+        {
+            if (m_active && m_condition.should_run()) {
+                m_functor();
+            }
+        }
+
+        auto operator=(const scope_guard&) -> scope_guard& = delete;
+        auto operator=(scope_guard&&) -> scope_guard& = delete;
+
+        // dismisses the guard, its functor will not run
+        auto release() noexcept -> void
+        {
+            m_active = false;
+        }
+
+    private:
+        [[no_unique_address]] Functor m_functor;
+        [[no_unique_address]] Condition m_condition;
+        bool m_active { true };
+    };
+}
+
+// runs `Functor` when the scope exits, however it exits
+template <impl::invocable Functor>
+class scope_exit : public finally_impl::scope_guard<Functor, finally_impl::on_exit> {
+public:
+    explicit scope_exit(Functor f) noexcept(std::is_nothrow_move_constructible_v<Functor>)
+        : finally_impl::scope_guard<Functor, finally_impl::on_exit>(std::move(f))
+    {
+    }
+};
+
+// runs `Functor` only when the scope exits by an exception
+template <impl::invocable Functor>
+class scope_fail : public finally_impl::scope_guard<Functor, finally_impl::on_failure> {
+public:
+    explicit scope_fail(Functor f) noexcept(std::is_nothrow_move_constructible_v<Functor>)
+        : finally_impl::scope_guard<Functor, finally_impl::on_failure>(std::move(f))
+    {
+    }
+};
+
+// runs `Functor` only when the scope exits normally
+template <impl::invocable Functor>
+class scope_success : public finally_impl::scope_guard<Functor, finally_impl::on_success> {
+public:
+    explicit scope_success(Functor f) noexcept(std::is_nothrow_move_constructible_v<Functor>)
+        : finally_impl::scope_guard<Functor, finally_impl::on_success>(std::move(f))
+    {
+    }
+};
+
+// a stack of cleanup functors of any types, stored within `Capacity` inline bytes rather than each in a std::function,
+// and run last in first out when destroyed. Nodes link to the node before them by pointer, so a finally_stack can't be
+// moved
+template <size_t Capacity>
+class finally_stack {
+public:
+    finally_stack() = default;
+
+    finally_stack(const finally_stack&) = delete;
+    finally_stack(finally_stack&&) = delete;
+
+    ~finally_stack()
+    {
+        run();
+    }
+
+    auto operator=(const finally_stack&) -> finally_stack& = delete;
+    auto operator=(finally_stack&&) -> finally_stack& = delete;
+
+    // false, storing nothing, when there isn't room left for `f`
+    template <typename Functor>
+    requires(impl::invocable<std::decay_t<Functor>&>) auto push(Functor&& f) -> bool
+    {
+        using node_type = typed_node<std::decay_t<Functor>>;
+        static_assert(sizeof(node_type) <= Capacity, "functor can never fit in this finally_stack");
+        static_assert(alignof(node_type) <= alignof(std::max_align_t), "finally_stack functors must not be over aligned");
+
+        const auto offset = (m_used + alignof(node_type) - 1) / alignof(node_type) * alignof(node_type);
+        if (offset + sizeof(node_type) > Capacity) {
+            return false;
+        }
+
+        m_top = ::new (static_cast<void*>(m_buffer + offset)) node_type { m_top, std::forward<Functor>(f) };
+        m_used = offset + sizeof(node_type);
+        ++m_size;
+
+        return true;
+    }
+
+    // runs every pending functor now, last pushed first
+    auto run() -> void
+    {
+        while (m_top != nullptr) {
+            pop(true);
+        }
+    }
+
+    // dismisses every pending functor without running it
+    auto release() noexcept -> void
+    {
+        while (m_top != nullptr) {
+            pop(false);
+        }
+    }
+
+    auto size() const noexcept -> size_t
+    {
+        return m_size;
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return m_size == 0;
+    }
+
+private:
+    struct node {
+        node* m_prev;
+        auto (*m_finish)(node&, bool run) -> void;
+    };
+
+    template <typename Functor>
+    struct typed_node : node {
+        typed_node(node* prev, Functor f)
+            : node { prev, &finish }
+            , m_functor(std::move(f))
+        {
+        }
+
+        static auto finish(node& base, bool run) -> void
+        {
+            auto& self = static_cast<typed_node&>(base);
+            // destroyed however the functor exits
+            scope_exit destroy { [&self]() { self.~typed_node(); } };
+            if (run) {
+                self.m_functor();
+            }
+        }
+
+        Functor m_functor;
+    };
+
+    // the node is unlinked before it runs, so a throwing functor leaves the rest of the stack intact
+    auto pop(bool run) -> void
+    {
+        auto* top = m_top;
+        m_top = top->m_prev;
+        m_used = static_cast<size_t>(reinterpret_cast<std::byte*>(top) - m_buffer);
+        --m_size;
+
+        top->m_finish(*top, run);
+    }
+
+    alignas(std::max_align_t) std::byte m_buffer[Capacity];
+    node* m_top { nullptr };
+    size_t m_used { 0 };
+    size_t m_size { 0 };
+};
+}
@@ -1,3 +1,800 @@
+#pragma once
+
+#include <safet/impl/concepts.hpp>
+#include <safet/optional.hpp>
+#include <safet/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace safet {
+enum class future_errc {
+    broken_promise = 1,
+};
+
+namespace future_impl {
+    class error_category : public std::error_category {
+    public:
+        auto name() const noexcept -> const char* override
+        {
+            return "safet::future";
+        }
+
+        auto message(int condition) const -> std::string override
+        {
+            switch (static_cast<future_errc>(condition)) {
+            case future_errc::broken_promise:
+                return "promise destroyed without a result";
+            }
+
+            return "unknown future error";
+        }
+    };
+}
+
+inline auto future_category() noexcept -> const std::error_category&
+{
+    static const future_impl::error_category category;
+    return category;
+}
+
+inline auto make_error_code(future_errc e) noexcept -> std::error_code
+{
+    return std::error_code { static_cast<int>(e), future_category() };
+}
+}
+
+template <>
+struct std::is_error_code_enum<safet::future_errc> : std::true_type {
+};
+
 namespace safet {
+template <typename T, typename E = std::error_code>
+class future;
+
+template <typename T, typename E = std::error_code>
+class promise;
+
+namespace future_impl {
+    // `future<void>` holds its (lack of) value as a monostate so results are always a variant
+    template <typename T>
+    using stored_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    template <typename T>
+    struct is_future : std::false_type {
+    };
+
+    template <typename T, typename E>
+    struct is_future<future<T, E>> : std::true_type {
+    };
+
+    // continuations returning a future are flattened, so `then` yields `future<U>` rather than `future<future<U>>`
+    template <typename R, typename E>
+    struct then_future {
+        using type = future<R, E>;
+    };
+
+    template <typename U, typename E>
+    struct then_future<future<U, E>, E> {
+        using type = future<U, E>;
+    };
+
+    // shared states are allocated from per-thread free lists of same-sized blocks, so a steady stream of futures
+    // doesn't touch the global allocator. Each block remembers the thread that allocated it and goes back to that
+    // thread's list wherever it's freed, through a lock-free stack the owner takes whole once its own list runs dry.
+    // That keeps blocks recycling when promises are completed on one thread and futures consumed on another (e.g.
+    // `thread_pool` workers and the thread submitting to them), rather than piling up on whichever thread frees them
+    template <size_t Size, size_t Align>
+    class block_pool {
+    public:
+        static auto allocate() -> void*
+        {
+            auto& list = local();
+            if (list.m_head == nullptr) {
+                list.collect_remote();
+            }
+
+            if (list.m_head != nullptr) {
+                auto* block = list.m_head;
+                list.m_head = block->m_next;
+                --list.m_count;
+
+                return block;
+            }
+
+            return new_block(list.owner());
+        }
+
+        static auto deallocate(void* block) noexcept -> void
+        {
+            auto* block_owner = header_of(block).m_owner;
+
+            auto& list = local();
+            if (block_owner != list.m_owner) {
+                push_remote(*block_owner, block);
+            } else if (list.m_count < max_cached) {
+                list.m_head = new (block) node { list.m_head };
+                ++list.m_count;
+            } else {
+                free_block(block);
+            }
+        }
+
+    private:
+        static_assert(Size >= sizeof(void*) && Align >= alignof(void*), "block_pool blocks must fit a free list node");
+
+        static constexpr size_t max_cached = 256;
+
+        struct node {
+            node* m_next;
+        };
+
+        // shared by the thread that allocated a block and any that free it, so it lives until the last of those blocks
+        // is freed
+        struct owner {
+            // one for each block allocated by this owner and not yet freed, and one for the owning thread
+            std::atomic<size_t> m_refs { 1 };
+            // blocks freed by other threads, or `closed` once the owning thread has exited
+            std::atomic<node*> m_remote { nullptr };
+        };
+
+        struct header {
+            owner* m_owner;
+        };
+
+        // keeps each block `Align`ed after its header
+        static constexpr size_t header_size = Align > sizeof(header) ? Align : sizeof(header);
+
+        static inline node closed { nullptr };
+
+        static auto header_of(void* block) noexcept -> header&
+        {
+            return *std::launder(reinterpret_cast<header*>(static_cast<std::byte*>(block) - header_size));
+        }
+
+        static auto new_block(owner& o) -> void*
+        {
+            auto* base = static_cast<std::byte*>(::operator new(header_size + Size, std::align_val_t { Align }));
+            new (base) header { &o };
+            o.m_refs.fetch_add(1, std::memory_order_relaxed);
+
+            return base + header_size;
+        }
+
+        static auto free_block(void* block) noexcept -> void
+        {
+            auto* block_owner = header_of(block).m_owner;
+            ::operator delete(static_cast<std::byte*>(block) - header_size, std::align_val_t { Align });
+            release(*block_owner);
+        }
+
+        static auto release(owner& o) noexcept -> void
+        {
+            if (o.m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete &o;
+            }
+        }
+
+        // the block's own reference keeps `o` alive until the push completes
+        static auto push_remote(owner& o, void* block) noexcept -> void
+        {
+            auto* n = new (block) node { nullptr };
+
+            auto* head = o.m_remote.load(std::memory_order_relaxed);
+            do {
+                if (head == &closed) {
+                    free_block(block);
+                    return;
+                }
+
+                n->m_next = head;
+            } while (!o.m_remote.compare_exchange_weak(head, n, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        struct free_list {
+            ~free_list()
+            {
+                while (m_head != nullptr) {
+                    free_block(std::exchange(m_head, m_head->m_next));
+                }
+
+                if (m_owner != nullptr) {
+                    // from now on other threads free our blocks themselves
+                    for (auto* remote = m_owner->m_remote.exchange(&closed, std::memory_order_acquire); remote != nullptr;) {
+                        free_block(std::exchange(remote, remote->m_next));
+                    }
+
+                    release(*m_owner);
+                }
+            }
+
+            auto owner() -> block_pool::owner&
+            {
+                if (m_owner == nullptr) {
+                    m_owner = new block_pool::owner;
+                }
+
+                return *m_owner;
+            }
+
+            // takes every block other threads have returned since, beyond `max_cached` they're freed
+            auto collect_remote() noexcept -> void
+            {
+                if (m_owner == nullptr) {
+                    return;
+                }
+
+                for (auto* remote = m_owner->m_remote.exchange(nullptr, std::memory_order_acquire); remote != nullptr;) {
+                    auto* next = remote->m_next;
+                    if (m_count < max_cached) {
+                        remote->m_next = m_head;
+                        m_head = remote;
+                        ++m_count;
+                    } else {
+                        free_block(remote);
+                    }
+                    remote = next;
+                }
+            }
+
+            node* m_head { nullptr };
+            size_t m_count { 0 };
+            block_pool::owner* m_owner { nullptr };
+        };
+
+        static auto local() -> free_list&
+        {
+            thread_local free_list list;
+            return list;
+        }
+    };
+
+    // holds a single move-only callable inline when it fits, or on the heap otherwise, and calls it exactly once
+    template <typename Arg>
+    class continuation {
+    public:
+        template <typename Functor>
+        auto emplace(Functor&& f) -> void
+        {
+            using functor_type = std::decay_t<Functor>;
+
+            if constexpr (sizeof(functor_type) <= sizeof(m_buffer) && alignof(functor_type) <= alignof(std::max_align_t)) {
+                new (m_buffer) functor_type(std::forward<Functor>(f));
+                m_invoke = [](std::byte* buffer, Arg arg) {
+                    // moved out before calling, as the call may well release the state this buffer lives in
+                    auto& stored = *std::launder(reinterpret_cast<functor_type*>(buffer));
+                    auto local = std::move(stored);
+                    std::destroy_at(&stored);
+
+                    std::move(local)(std::forward<Arg>(arg));
+                };
+            } else {
+                new (m_buffer) functor_type*(new functor_type(std::forward<Functor>(f)));
+                m_invoke = [](std::byte* buffer, Arg arg) {
+                    std::unique_ptr<functor_type> owner { *std::launder(reinterpret_cast<functor_type**>(buffer)) };
+                    (*std::move(owner))(std::forward<Arg>(arg));
+                };
+            }
+        }
+
+        auto invoke(Arg arg) -> void
+        {
+            m_invoke(m_buffer, std::forward<Arg>(arg));
+        }
+
+    private:
+        alignas(std::max_align_t) std::byte m_buffer[6 * sizeof(void*)];
+        auto (*m_invoke)(std::byte*, Arg) -> void { nullptr };
+    };
+
+    // the state shared by one promise and one future. The result is written exactly once, before `m_status` becomes
+    // READY, and the continuation at most once, before `m_status` becomes CONTINUED. Whichever of the two happens
+    // second runs the continuation
+    template <typename T, typename E>
+    class shared_state {
+    public:
+        using result_type = variant<stored_type<T>, E>;
+
+        static auto create() -> shared_state*
+        {
+            return new (block_pool<sizeof(shared_state), alignof(shared_state)>::allocate()) shared_state;
+        }
+
+        auto release() noexcept -> void
+        {
+            if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::destroy_at(this);
+                block_pool<sizeof(shared_state), alignof(shared_state)>::deallocate(this);
+            }
+        }
+
+        auto set(result_type&& result) -> void
+        {
+            m_result.emplace(std::move(result));
+
+            if (m_status.exchange(READY, std::memory_order_acq_rel) == CONTINUED) {
+                run_continuation();
+            } else {
+                m_status.notify_all();
+            }
+        }
+
+        template <typename Functor>
+        auto subscribe(Functor&& f) -> void
+        {
+            m_continuation.emplace(std::forward<Functor>(f));
+
+            auto expected = PENDING;
+            if (!m_status.compare_exchange_strong(expected, CONTINUED, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                // already READY
+                run_continuation();
+            }
+        }
+
+        auto ready() const -> bool
+        {
+            return m_status.load(std::memory_order_acquire) == READY;
+        }
+
+        auto wait() const -> void
+        {
+            for (auto status = m_status.load(std::memory_order_acquire); status != READY; status = m_status.load(std::memory_order_acquire)) {
+                m_status.wait(status, std::memory_order_acquire);
+            }
+        }
+
+        // must be READY
+        auto take() -> result_type
+        {
+            return std::move(m_result).value_or([]() -> result_type { return E { future_errc::broken_promise }; });
+        }
+
+    private:
+        static constexpr uint32_t PENDING = 0;
+        static constexpr uint32_t CONTINUED = 1;
+        static constexpr uint32_t READY = 2;
+
+        auto run_continuation() -> void
+        {
+            m_result.if_set([this](result_type& result) { m_continuation.invoke(std::move(result)); });
+        }
+
+        std::atomic<uint32_t> m_status { PENDING };
+        // one for the promise and one for the future (or whatever took ownership of the future)
+        std::atomic<uint32_t> m_refs { 2 };
+        optional<result_type> m_result;
+        continuation<result_type&&> m_continuation;
+    };
+
+    // `future<void>` continuations take no arguments
+    template <typename T, typename Functor>
+    decltype(auto) invoke_continuation(Functor&& f, stored_type<T>&& value)
+    {
+        if constexpr (std::is_void_v<T>) {
+            static_cast<void>(value);
+            return std::forward<Functor>(f)();
+        } else {
+            return std::forward<Functor>(f)(std::move(value));
+        }
+    }
+
+    template <typename T, typename Functor>
+    using continuation_result = decltype(invoke_continuation<T>(std::declval<Functor>(), std::declval<stored_type<T>&&>()));
+
+    struct access {
+        template <typename T, typename E>
+        static auto make(shared_state<T, E>* state) -> std::pair<promise<T, E>, future<T, E>>
+        {
+            return { promise<T, E> { state }, future<T, E> { state } };
+        }
+
+        // registers `f` to be called with the result of `fut`, consuming it without creating another future
+        template <typename T, typename E, typename Functor>
+        static auto subscribe(future<T, E>&& fut, Functor&& f) -> void
+        {
+            auto* state = std::exchange(fut.m_state, nullptr);
+            state->subscribe([state, f = std::forward<Functor>(f)](typename shared_state<T, E>::result_type&& result) mutable {
+                std::move(f)(std::move(result));
+                state->release();
+            });
+        }
+
+        template <typename T, typename E>
+        static auto set(promise<T, E>& p, typename shared_state<T, E>::result_type&& result) -> bool
+        {
+            return p.set_result(std::move(result));
+        }
+    };
+}
+
+template <typename T, typename E = std::error_code>
+auto make_promise() -> std::pair<promise<T, E>, future<T, E>>;
+
+// the producing side of a future. Destroying a promise without setting a result sets the error
+// `future_errc::broken_promise`, so a future always completes
+template <typename T, typename E>
+class promise {
+public:
+    static_assert(std::is_constructible_v<E, future_errc>, "future error type must be constructible from future_errc");
+
+    promise(const promise&) = delete;
+    promise(promise&& move) noexcept
+        : m_state(std::exchange(move.m_state, nullptr))
+    {
+    }
+
+    ~promise()
+    {
+        set_error(E { future_errc::broken_promise });
+    }
+
+    auto operator=(const promise&) -> promise& = delete;
+    auto operator=(promise&& move) noexcept -> promise&
+    {
+        if (&move != this) {
+            set_error(E { future_errc::broken_promise });
+            m_state = std::exchange(move.m_state, nullptr);
+        }
+
+        return *this;
+    }
+
+    // a result may only be set once, subsequent attempts return false
+    template <typename... Args>
+    auto set_value(Args&&... args) -> bool
+    {
+        return set_result(result_type { std::in_place_index_t<0> {}, std::forward<Args>(args)... });
+    }
+
+    auto set_error(E error) -> bool
+    {
+        return set_result(result_type { std::in_place_index_t<1> {}, std::move(error) });
+    }
+
+    auto satisfied() const -> bool
+    {
+        return m_state == nullptr;
+    }
+
+private:
+    using state_type = future_impl::shared_state<T, E>;
+    using result_type = typename state_type::result_type;
+
+    explicit promise(state_type* state)
+        : m_state(state)
+    {
+    }
+
+    auto set_result(result_type&& result) -> bool
+    {
+        if (m_state == nullptr) {
+            return false;
+        }
+
+        auto* state = std::exchange(m_state, nullptr);
+        state->set(std::move(result));
+        state->release();
+
+        return true;
+    }
+
+    state_type* m_state;
+
+    friend struct future_impl::access;
+};
+
+// the consuming side of a promise, holding either a `T` or an error `E` once ready. Futures are move only and each
+// result is consumed exactly once, either by `result()`/`value()` or by a continuation registered with `then`
+template <typename T, typename E>
+class future {
+public:
+    using value_type = future_impl::stored_type<T>;
+    using error_type = E;
+    using result_type = variant<value_type, E>;
+
+    future(const future&) = delete;
+    future(future&& move) noexcept
+        : m_state(std::exchange(move.m_state, nullptr))
+    {
+    }
+
+    ~future()
+    {
+        if (m_state != nullptr) {
+            m_state->release();
+        }
+    }
+
+    auto operator=(const future&) -> future& = delete;
+    auto operator=(future&& move) noexcept -> future&
+    {
+        if (&move != this) {
+            if (m_state != nullptr) {
+                m_state->release();
+            }
+            m_state = std::exchange(move.m_state, nullptr);
+        }
+
+        return *this;
+    }
+
+    // false once consumed (by `then`, `result` etc.)
+    auto valid() const -> bool
+    {
+        return m_state != nullptr;
+    }
+
+    auto ready() const -> bool
+    {
+        return m_state != nullptr && m_state->ready();
+    }
+
+    // blocks the calling thread, prefer `then` wherever possible
+    auto wait() const -> void
+    {
+        if (m_state != nullptr) {
+            m_state->wait();
+        }
+    }
+
+    // blocks until ready and consumes the result. Empty if the future was already consumed
+    auto result() && -> optional<result_type>
+    {
+        if (m_state == nullptr) {
+            return std::nullopt;
+        }
+
+        m_state->wait();
+
+        auto* state = std::exchange(m_state, nullptr);
+        optional<result_type> result { state->take() };
+        state->release();
+
+        return result;
+    }
+
+    // as `result` but discarding any error
+    auto value() && -> optional<value_type>
+    {
+        return std::move(*this).result().and_then([](result_type&& result) { return std::move(result).template get<0>(); });
+    }
+
+    // as `result` but discarding any value
+    auto error() && -> optional<E>
+    {
+        return std::move(*this).result().and_then([](result_type&& result) { return std::move(result).template get<1>(); });
+    }
+
+    // calls `f` with the value once ready, on whichever thread completes the promise (or immediately on this thread if
+    // already complete). Errors skip `f` and propagate to the returned future. `f` may return a future itself, in
+    // which case the returned future completes along with it. Continuations must not throw
+    template <typename Functor>
+    auto then(Functor&& f) && -> typename future_impl::then_future<future_impl::stored_type<future_impl::continuation_result<T, Functor&&>>, E>::type
+    {
+        using return_type = future_impl::continuation_result<T, Functor&&>;
+        using next_future = typename future_impl::then_future<future_impl::stored_type<return_type>, E>::type;
+        using next_value = typename next_future::value_type;
+
+        auto [next_promise, next] = make_promise<next_value, E>();
+
+        future_impl::access::subscribe(std::move(*this), [p = std::move(next_promise), f = std::forward<Functor>(f)](result_type&& result) mutable {
+            std::move(result).visit(overloaded {
+                [&](value_type&& value) {
+                    if constexpr (future_impl::is_future<return_type>::value) {
+                        future_impl::access::subscribe(future_impl::invoke_continuation<T>(std::move(f), std::move(value)), [p = std::move(p)](typename return_type::result_type&& inner) mutable {
+                            future_impl::access::set(p, std::move(inner));
+                        });
+                    } else if constexpr (std::is_void_v<return_type>) {
+                        future_impl::invoke_continuation<T>(std::move(f), std::move(value));
+                        p.set_value();
+                    } else {
+                        p.set_value(future_impl::invoke_continuation<T>(std::move(f), std::move(value)));
+                    }
+                },
+                [&](E&& error) {
+                    p.set_error(std::move(error));
+                } });
+        });
+
+        return std::move(next);
+    }
+
+    // as `then`, but `f` is posted to `executor` rather than running on the thread completing the promise
+    template <impl::executor Executor, typename Functor>
+    auto then(Executor& executor, Functor&& f) && -> typename future_impl::then_future<future_impl::stored_type<future_impl::continuation_result<T, Functor&&>>, E>::type
+    {
+        auto [hop_promise, hop] = make_promise<T, E>();
+
+        // attached before the hop can complete, so `f` always runs on the executor
+        auto next = std::move(hop).then(std::forward<Functor>(f));
+
+        future_impl::access::subscribe(std::move(*this), [&executor, p = std::move(hop_promise)](result_type&& result) mutable {
+            executor.post([p = std::move(p), result = std::move(result)]() mutable { future_impl::access::set(p, std::move(result)); });
+        });
+
+        return next;
+    }
+
+private:
+    using state_type = future_impl::shared_state<T, E>;
+
+    explicit future(state_type* state)
+        : m_state(state)
+    {
+    }
+
+    state_type* m_state;
+
+    friend struct future_impl::access;
+    friend class promise<T, E>;
+};
+
+template <typename T, typename E>
+auto make_promise() -> std::pair<promise<T, E>, future<T, E>>
+{
+    return future_impl::access::make(future_impl::shared_state<T, E>::create());
+}
+
+template <typename T, typename E = std::error_code, typename... Args>
+auto make_ready_future(Args&&... args) -> future<T, E>
+{
+    auto [p, f] = make_promise<T, E>();
+    p.set_value(std::forward<Args>(args)...);
+
+    return std::move(f);
+}
+
+template <typename T, typename E = std::error_code>
+auto make_error_future(E error) -> future<T, E>
+{
+    auto [p, f] = make_promise<T, E>();
+    p.set_error(std::move(error));
+
+    return std::move(f);
+}
+
+namespace future_impl {
+    template <typename E, typename... Ts>
+    struct when_all_state {
+        promise<std::tuple<stored_type<Ts>...>, E> m_promise;
+        std::tuple<optional<stored_type<Ts>>...> m_values;
+        std::atomic<size_t> m_remaining { sizeof...(Ts) };
+        std::atomic<bool> m_failed { false };
+    };
+
+    template <typename T>
+    auto unwrap(optional<T>&& value) -> T
+    {
+        // only called once every value has been set
+        return std::move(value).value_or([]() -> T { std::terminate(); });
+    }
+}
+
+// completes with every value once all `futures` complete, or with the first error as soon as any fails
+template <typename E, typename... Ts>
+auto when_all(future<Ts, E>... futures) -> future<std::tuple<future_impl::stored_type<Ts>...>, E>
+{
+    using state_type = future_impl::when_all_state<E, Ts...>;
+
+    auto [p, f] = make_promise<std::tuple<future_impl::stored_type<Ts>...>, E>();
+    auto state = std::make_shared<state_type>(std::move(p));
+
+    auto complete_one = [state]<size_t I>(std::integral_constant<size_t, I>, auto&& result) {
+        std::move(result).visit(overloaded {
+            [&](E&& error) {
+                if (!state->m_failed.exchange(true)) {
+                    state->m_promise.set_error(std::move(error));
+                }
+            },
+            [&](auto&& value) { std::get<I>(state->m_values) = std::move(value); } });
+
+        if (state->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !state->m_failed.load()) {
+            std::apply([&](auto&&... values) { state->m_promise.set_value(future_impl::unwrap(std::move(values))...); }, std::move(state->m_values));
+        }
+    };
+
+    [&]<size_t... Is>(std::index_sequence<Is...>)
+    {
+        (future_impl::access::subscribe(std::move(futures), [complete_one](auto&& result) { complete_one(std::integral_constant<size_t, Is> {}, std::move(result)); }), ...);
+    }
+    (std::index_sequence_for<Ts...> {});
+
+    return std::move(f);
+}
+
+// completes with every value, in order, once all `futures` complete, or with the first error as soon as any fails
+template <typename T, typename E>
+auto when_all(std::vector<future<T, E>> futures) -> future<std::vector<future_impl::stored_type<T>>, E>
+{
+    using value_type = future_impl::stored_type<T>;
+
+    struct state_type {
+        promise<std::vector<value_type>, E> m_promise;
+        std::vector<optional<value_type>> m_values;
+        std::atomic<size_t> m_remaining;
+        std::atomic<bool> m_failed { false };
+    };
+
+    auto [p, f] = make_promise<std::vector<value_type>, E>();
+    if (futures.empty()) {
+        p.set_value();
+        return std::move(f);
+    }
+
+    auto state = std::make_shared<state_type>(std::move(p), std::vector<optional<value_type>>(futures.size()), futures.size());
+
+    for (size_t i = 0; i < futures.size(); ++i) {
+        future_impl::access::subscribe(std::move(futures[i]), [state, i](typename future<T, E>::result_type&& result) {
+            std::move(result).visit(overloaded {
+                [&](value_type&& value) { state->m_values[i] = std::move(value); },
+                [&](E&& error) {
+                    if (!state->m_failed.exchange(true)) {
+                        state->m_promise.set_error(std::move(error));
+                    }
+                } });
+
+            if (state->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !state->m_failed.load()) {
+                std::vector<value_type> values;
+                values.reserve(state->m_values.size());
+                for (auto& value : state->m_values) {
+                    values.push_back(future_impl::unwrap(std::move(value)));
+                }
+
+                state->m_promise.set_value(std::move(values));
+            }
+        });
+    }
+
+    return std::move(f);
+}
+
+// completes with the index and value of the first of `futures` to succeed, or the last error if all of them fail
+template <typename T, typename E>
+auto when_any(std::vector<future<T, E>> futures) -> future<std::pair<size_t, future_impl::stored_type<T>>, E>
+{
+    using value_type = future_impl::stored_type<T>;
+
+    struct state_type {
+        promise<std::pair<size_t, value_type>, E> m_promise;
+        std::atomic<size_t> m_remaining;
+        std::atomic<bool> m_succeeded { false };
+    };
+
+    auto [p, f] = make_promise<std::pair<size_t, value_type>, E>();
+    if (futures.empty()) {
+        // nothing can ever succeed
+        return std::move(f);
+    }
+
+    auto state = std::make_shared<state_type>(std::move(p), futures.size());
+
+    for (size_t i = 0; i < futures.size(); ++i) {
+        future_impl::access::subscribe(std::move(futures[i]), [state, i](typename future<T, E>::result_type&& result) {
+            // a success is recorded before its decrement, so the last failure always sees it
+            std::move(result).visit(overloaded {
+                [&](value_type&& value) {
+                    if (!state->m_succeeded.exchange(true)) {
+                        state->m_promise.set_value(i, std::move(value));
+                    }
+                    state->m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+                },
+                [&](E&& error) {
+                    if (state->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 && !state->m_succeeded.load()) {
+                        state->m_promise.set_error(std::move(error));
+                    }
+                } });
+        });
+    }
 
-}
\ No newline at end of file
+    return std::move(f);
+}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <concepts>
 #include <cstddef>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -39,4 +41,57 @@ concept one_of = std::disjunction_v<std::is_same<T, Args>...>;
 
 template <typename T, typename U>
 concept decays_to = std::is_same_v<std::decay_t<T>, U>;
+
+template <typename T>
+concept lockable = requires(T& t)
+{
+    t.lock();
+    { t.try_lock() } -> std::convertible_to<bool>;
+    t.unlock();
+};
+
+template <typename T>
+concept shared_lockable = lockable<T> && requires(T& t)
+{
+    t.lock_shared();
+    { t.try_lock_shared() } -> std::convertible_to<bool>;
+    t.unlock_shared();
+};
+
+template <typename T>
+concept timed_lockable = lockable<T> && requires(T& t, std::chrono::steady_clock::duration d, std::chrono::steady_clock::time_point tp)
+{
+    { t.try_lock_for(d) } -> std::convertible_to<bool>;
+    { t.try_lock_until(tp) } -> std::convertible_to<bool>;
+};
+
+template <typename T>
+concept instrumented_lockable = lockable<T> && requires(T& t, const T& c_t, std::string_view name)
+{
+    t.set_name(name);
+    c_t.stats();
+};
+
+template <typename T>
+concept async_lockable = lockable<T> && requires(T& t)
+{
+    t.lock_async();
+};
+
+// anything that can run a task "somewhere else", e.g. `thread_pool`
+template <typename T>
+concept executor = requires(T& t, void (*task)())
+{
+    t.post(task);
+};
+
+// a source of raw memory, e.g. `arena` or `pool`
+template <typename T>
+concept memory_resource = requires(T& t, void* p, size_t size, size_t alignment)
+{
+    {
+        t.allocate(size, alignment)
+        } -> std::same_as<void*>;
+    t.deallocate(p, size, alignment);
+};
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <coroutine>
+
+namespace safet::impl {
+// a suspended coroutine waiting to be resumed by whoever releases what it waits on. The node lives in the coroutine's
+// own awaiter, so queueing it never allocates
+struct resumable {
+    std::coroutine_handle<> m_handle {};
+    resumable* m_resume_next { nullptr };
+};
+
+// resumes `node`'s coroutine on this thread. A resumed coroutine commonly releases something that resumes the next
+// waiter in turn, so resumptions made from within a resumption are queued and run by the outermost call instead,
+// keeping the stack depth constant however long the chain of handoffs
+inline auto resume(resumable& node) -> void
+{
+    struct trampoline {
+        resumable* m_head { nullptr };
+        resumable* m_tail { nullptr };
+        bool m_running { false };
+    };
+    thread_local trampoline local;
+
+    node.m_resume_next = nullptr;
+    if (local.m_tail != nullptr) {
+        local.m_tail->m_resume_next = &node;
+    } else {
+        local.m_head = &node;
+    }
+    local.m_tail = &node;
+
+    if (local.m_running) {
+        return;
+    }
+
+    local.m_running = true;
+    while (local.m_head != nullptr) {
+        // unqueued before resuming, as the coroutine (and the node with it) may be destroyed by the time it suspends
+        auto* next = local.m_head;
+        local.m_head = next->m_resume_next;
+        if (local.m_head == nullptr) {
+            local.m_tail = nullptr;
+        }
+
+        next->m_handle.resume();
+    }
+    local.m_running = false;
+}
+}
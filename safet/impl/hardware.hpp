@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace safet::impl {
+// gcc warns against `std::hardware_destructive_interference_size` in headers as it varies with `-mtune`, which would
+// change the layout of our types between translation units, so there we pin it to 64 bytes
+#if defined(__cpp_lib_hardware_interference_size) && (!defined(__GNUG__) || defined(__clang__))
+inline constexpr std::size_t cache_line_size = std::hardware_destructive_interference_size;
+#else
+inline constexpr std::size_t cache_line_size = 64;
+#endif
+
+// hint to the processor that we're in a spin-wait loop, lowering power usage and freeing up execution resources for
+// the sibling hyperthread, which is frequently the one we're waiting on
+inline auto cpu_relax() noexcept -> void
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+}
@@ -1,7 +1,19 @@
 #pragma once
 
+#include <safet/impl/concepts.hpp>
+#include <safet/optional.hpp>
+
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace safet {
 
@@ -158,4 +170,731 @@ public:
 private:
     std::weak_ptr<T> m_ptr;
 };
+
+namespace memory_impl {
+    // a block of memory obtained from the global allocator, usable from just past this header
+    struct chunk {
+        chunk* m_next;
+        size_t m_size;
+    };
+
+    inline auto align_up(uintptr_t address, size_t alignment) -> uintptr_t
+    {
+        return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+
+    inline auto allocate_chunk(size_t size, chunk* next) -> chunk*
+    {
+        return new (::operator new(sizeof(chunk) + size)) chunk { next, size };
+    }
+
+    inline auto free_chunks(chunk* head) noexcept -> void
+    {
+        while (head != nullptr) {
+            ::operator delete(std::exchange(head, head->m_next));
+        }
+    }
+
+    inline auto chunk_begin(chunk* c) -> uintptr_t
+    {
+        return reinterpret_cast<uintptr_t>(c + 1);
+    }
+}
+
+// a monotonic memory resource: allocating bumps a pointer through chunks obtained from the global allocator (each twice
+// the size of the last), deallocating does nothing, and memory is only reclaimed all at once by `reset()` or destruction.
+// Suited to object graphs that are built up and then torn down together. Not thread safe
+class arena {
+public:
+    explicit arena(size_t initial_chunk_size = 4096) noexcept
+        : m_next_chunk_size(initial_chunk_size)
+    {
+    }
+
+    // resources are referred to by address from the allocators and deleters using them
+    arena(const arena&) = delete;
+    arena(arena&&) = delete;
+
+    ~arena()
+    {
+        memory_impl::free_chunks(m_chunks);
+    }
+
+    auto operator=(const arena&) -> arena& = delete;
+    auto operator=(arena&&) -> arena& = delete;
+
+    auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void*
+    {
+        auto address = memory_impl::align_up(m_cursor, alignment);
+        if (m_chunks == nullptr || address + size > m_end) {
+            grow(size + alignment);
+            address = memory_impl::align_up(m_cursor, alignment);
+        }
+
+        m_cursor = address + size;
+
+        return reinterpret_cast<void*>(address);
+    }
+
+    auto deallocate(void*, size_t, size_t = alignof(std::max_align_t)) noexcept -> void
+    {
+    }
+
+    // reclaims everything allocated so far, keeping only the largest chunk to allocate from again, so an arena reused for
+    // similar work settles into a single chunk and stops going to the global allocator. Anything allocated from the arena
+    // must already be destroyed
+    auto reset() noexcept -> void
+    {
+        if (m_chunks != nullptr) {
+            memory_impl::free_chunks(std::exchange(m_chunks->m_next, nullptr));
+            m_cursor = memory_impl::chunk_begin(m_chunks);
+        }
+    }
+
+private:
+    auto grow(size_t minimum_size) -> void
+    {
+        auto size = std::max(m_next_chunk_size, minimum_size);
+        m_chunks = memory_impl::allocate_chunk(size, m_chunks);
+        m_cursor = memory_impl::chunk_begin(m_chunks);
+        m_end = m_cursor + size;
+        m_next_chunk_size = size * 2;
+    }
+
+    memory_impl::chunk* m_chunks { nullptr };
+    uintptr_t m_cursor { 0 };
+    uintptr_t m_end { 0 };
+    size_t m_next_chunk_size;
+};
+
+// a size class memory resource: requests of up to `max_block_size` bytes are rounded up to a power of two and served from
+// a free list for that size, refilled from chunks obtained from the global allocator, so memory deallocated to the pool
+// is reused by the next allocation of a similar size. Larger or over-aligned requests go straight to the global
+// allocator. Chunks are only returned to the global allocator when the pool is destroyed. Not thread safe
+class pool {
+public:
+    static constexpr size_t min_block_size = alignof(std::max_align_t);
+    static constexpr size_t max_block_size = 4096;
+
+    explicit pool(size_t chunk_size = 64 * 1024) noexcept
+        : m_chunk_size(std::max(chunk_size, max_block_size))
+    {
+    }
+
+    pool(const pool&) = delete;
+    pool(pool&&) = delete;
+
+    ~pool()
+    {
+        memory_impl::free_chunks(m_chunks);
+    }
+
+    auto operator=(const pool&) -> pool& = delete;
+    auto operator=(pool&&) -> pool& = delete;
+
+    auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void*
+    {
+        if (!pooled(size, alignment)) {
+            return ::operator new(size, std::align_val_t { alignment });
+        }
+
+        auto size_class = size_class_of(size);
+        if (auto* block = m_free[size_class]; block != nullptr) {
+            m_free[size_class] = block->m_next;
+            return block;
+        }
+
+        return carve(min_block_size << size_class);
+    }
+
+    auto deallocate(void* memory, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept -> void
+    {
+        if (!pooled(size, alignment)) {
+            ::operator delete(memory, std::align_val_t { alignment });
+            return;
+        }
+
+        auto size_class = size_class_of(size);
+        m_free[size_class] = new (memory) free_block { m_free[size_class] };
+    }
+
+private:
+    struct free_block {
+        free_block* m_next;
+    };
+
+    static constexpr size_t size_class_count = std::bit_width(max_block_size / min_block_size);
+
+    static auto pooled(size_t size, size_t alignment) -> bool
+    {
+        return size <= max_block_size && alignment <= alignof(std::max_align_t);
+    }
+
+    static auto size_class_of(size_t size) -> size_t
+    {
+        return std::bit_width((std::max(size, min_block_size) - 1) / min_block_size);
+    }
+
+    auto carve(size_t block_size) -> void*
+    {
+        if (m_chunks == nullptr || m_cursor + block_size > m_end) {
+            // whatever is left of the current chunk is too small for this block, and is abandoned
+            m_chunks = memory_impl::allocate_chunk(m_chunk_size, m_chunks);
+            m_cursor = memory_impl::align_up(memory_impl::chunk_begin(m_chunks), alignof(std::max_align_t));
+            m_end = memory_impl::chunk_begin(m_chunks) + m_chunk_size;
+        }
+
+        auto* block = reinterpret_cast<void*>(m_cursor);
+        m_cursor += block_size;
+
+        return block;
+    }
+
+    std::array<free_block*, size_class_count> m_free {};
+    memory_impl::chunk* m_chunks { nullptr };
+    uintptr_t m_cursor { 0 };
+    uintptr_t m_end { 0 };
+    size_t m_chunk_size;
+};
+
+// a standard allocator over a memory resource, e.g. for `allocate_shared` or standard containers. The resource must
+// outlive everything allocated from it
+template <typename T, impl::memory_resource Resource>
+class resource_allocator {
+public:
+    using value_type = T;
+
+    resource_allocator(Resource& resource) noexcept
+        : m_resource(&resource)
+    {
+    }
+
+    template <typename U>
+    resource_allocator(const resource_allocator<U, Resource>& other) noexcept
+        : m_resource(&other.resource())
+    {
+    }
+
+    auto allocate(size_t count) -> T*
+    {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length {};
+        }
+
+        return static_cast<T*>(m_resource->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    auto deallocate(T* memory, size_t count) noexcept -> void
+    {
+        m_resource->deallocate(memory, count * sizeof(T), alignof(T));
+    }
+
+    auto resource() const -> Resource&
+    {
+        return *m_resource;
+    }
+
+    template <typename U>
+    friend auto operator==(const resource_allocator& lhs, const resource_allocator<U, Resource>& rhs) -> bool
+    {
+        return &lhs.resource() == &rhs.resource();
+    }
+
+private:
+    Resource* m_resource;
+};
+
+// destroys an object and returns its memory to the resource it was allocated from, for the `unique_ptr`s made by
+// `make_unique_in`. The pointer must be to the complete object, not to a base class
+template <typename T, impl::memory_resource Resource>
+class resource_deleter {
+public:
+    resource_deleter() noexcept = default;
+    resource_deleter(Resource& resource) noexcept
+        : m_resource(&resource)
+    {
+    }
+
+    auto operator()(T* ptr) const -> void
+    {
+        std::destroy_at(ptr);
+        m_resource->deallocate(ptr, sizeof(T), alignof(T));
+    }
+
+private:
+    Resource* m_resource { nullptr };
+};
+
+template <typename T, impl::memory_resource Resource, typename... Params>
+auto make_unique_in(Resource& resource, Params&&... params) -> unique_ptr<T, resource_deleter<T, Resource>>
+{
+    auto* memory = resource.allocate(sizeof(T), alignof(T));
+
+    try {
+        auto* ptr = new (memory) T(std::forward<Params>(params)...);
+        return unique_ptr<T, resource_deleter<T, Resource>> { ptr, resource_deleter<T, Resource> { resource } };
+    } catch (...) {
+        resource.deallocate(memory, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+// the object and its reference counts share one allocation from `allocator`, which the last owner returns it to
+template <typename T, typename Allocator, typename... Params>
+auto allocate_shared(const Allocator& allocator, Params&&... params) -> shared_ptr<T>
+{
+    return shared_ptr<T> { std::allocate_shared<T>(allocator, std::forward<Params>(params)...) };
+}
+
+template <typename T, impl::memory_resource Resource, typename... Params>
+auto make_shared_in(Resource& resource, Params&&... params) -> shared_ptr<T>
+{
+    return safet::allocate_shared<T>(resource_allocator<T, Resource> { resource }, std::forward<Params>(params)...);
+}
+
+namespace memory_impl {
+    // the reference counts and the object of a `local_shared_ptr`, in a single allocation. The object is destroyed with
+    // the last strong reference, the block with the last reference of either kind
+    template <typename T>
+    struct local_block {
+        template <typename... Params>
+        explicit local_block(Params&&... params)
+        {
+            std::construct_at(std::addressof(m_value), std::forward<Params>(params)...);
+        }
+
+        ~local_block()
+        {
+        }
+
+        size_t m_strong { 1 };
+        // one for all strong references together, plus one per weak reference
+        size_t m_weak { 1 };
+        union {
+            T m_value;
+        };
+    };
+}
+
+// a `shared_ptr` for objects that never leave the thread they were created on: the reference counts aren't atomic, and
+// are allocated together with the object by `make_local_shared`
+template <typename T>
+class local_shared_ptr {
+public:
+    constexpr local_shared_ptr() noexcept { }
+    constexpr local_shared_ptr(std::nullptr_t) noexcept { }
+    local_shared_ptr(const local_shared_ptr<T>& copy) noexcept
+        : m_block(copy.m_block)
+    {
+        if (m_block != nullptr) {
+            ++m_block->m_strong;
+        }
+    }
+    local_shared_ptr(local_shared_ptr<T>&& move) noexcept
+        : m_block(std::exchange(move.m_block, nullptr))
+    {
+    }
+
+    ~local_shared_ptr()
+    {
+        release();
+    }
+
+    auto operator=(const local_shared_ptr<T>& copy) noexcept -> local_shared_ptr<T>&
+    {
+        if (copy.m_block != nullptr) {
+            ++copy.m_block->m_strong;
+        }
+        release();
+        m_block = copy.m_block;
+
+        return *this;
+    }
+    auto operator=(local_shared_ptr<T>&& move) noexcept -> local_shared_ptr<T>&
+    {
+        if (&move != this) {
+            release();
+            m_block = std::exchange(move.m_block, nullptr);
+        }
+
+        return *this;
+    }
+
+    auto deref() const -> optional<T&>
+    {
+        if (m_block != nullptr) {
+            return m_block->m_value;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    auto empty() const -> bool
+    {
+        return m_block == nullptr;
+    }
+
+    auto clear() -> void
+    {
+        release();
+        m_block = nullptr;
+    }
+
+private:
+    explicit local_shared_ptr(memory_impl::local_block<T>* block) noexcept
+        : m_block(block)
+    {
+    }
+
+    auto release() -> void
+    {
+        if (m_block != nullptr && --m_block->m_strong == 0) {
+            std::destroy_at(std::addressof(m_block->m_value));
+            if (--m_block->m_weak == 0) {
+                delete m_block;
+            }
+        }
+    }
+
+    memory_impl::local_block<T>* m_block { nullptr };
+
+    template <typename>
+    friend class local_weak_ptr;
+
+    template <typename U, typename... Params>
+    friend auto make_local_shared(Params&&... params) -> local_shared_ptr<U>;
+};
+
+template <typename T, typename... Params>
+auto make_local_shared(Params&&... params) -> local_shared_ptr<T>
+{
+    return local_shared_ptr<T> { new memory_impl::local_block<T>(std::forward<Params>(params)...) };
+}
+
+template <typename T>
+class local_weak_ptr {
+public:
+    local_weak_ptr() noexcept { }
+    local_weak_ptr(const local_shared_ptr<T>& s_ptr) noexcept
+        : m_block(s_ptr.m_block)
+    {
+        retain();
+    }
+    local_weak_ptr(const local_weak_ptr<T>& copy) noexcept
+        : m_block(copy.m_block)
+    {
+        retain();
+    }
+    local_weak_ptr(local_weak_ptr<T>&& move) noexcept
+        : m_block(std::exchange(move.m_block, nullptr))
+    {
+    }
+
+    ~local_weak_ptr()
+    {
+        release();
+    }
+
+    auto operator=(const local_weak_ptr<T>& copy) noexcept -> local_weak_ptr<T>&
+    {
+        return assign(copy.m_block);
+    }
+    auto operator=(local_weak_ptr<T>&& move) noexcept -> local_weak_ptr<T>&
+    {
+        if (&move != this) {
+            release();
+            m_block = std::exchange(move.m_block, nullptr);
+        }
+
+        return *this;
+    }
+
+    auto operator=(const local_shared_ptr<T>& s_ptr) noexcept -> local_weak_ptr<T>&
+    {
+        return assign(s_ptr.m_block);
+    }
+
+    auto lock() const -> local_shared_ptr<T>
+    {
+        if (m_block == nullptr || m_block->m_strong == 0) {
+            return nullptr;
+        }
+
+        ++m_block->m_strong;
+        return local_shared_ptr<T> { m_block };
+    }
+
+    auto clear() -> void
+    {
+        release();
+        m_block = nullptr;
+    }
+
+private:
+    auto assign(memory_impl::local_block<T>* block) -> local_weak_ptr<T>&
+    {
+        if (block != nullptr) {
+            ++block->m_weak;
+        }
+        release();
+        m_block = block;
+
+        return *this;
+    }
+
+    auto retain() -> void
+    {
+        if (m_block != nullptr) {
+            ++m_block->m_weak;
+        }
+    }
+
+    auto release() -> void
+    {
+        if (m_block != nullptr && --m_block->m_weak == 0) {
+            delete m_block;
+        }
+    }
+
+    memory_impl::local_block<T>* m_block { nullptr };
+};
+
+namespace memory_impl {
+    // tells `intrusive_weak_ptr`s whether the object they observe still exists, and outlives it for as long as they do
+    struct intrusive_weak_block {
+        // one for the object while it exists, plus one per weak reference
+        size_t m_refs;
+        bool m_alive;
+    };
+}
+
+// gives a type the reference count `intrusive_ptr` uses, embedded in the object itself. Like `local_shared_ptr` the
+// count is not atomic. The block weak references need is only allocated when the first `intrusive_weak_ptr` is made.
+// Objects must be allocated with `new` (see `make_intrusive`) and, to be destroyed through an `intrusive_ptr` to a base
+// class, have a virtual destructor
+class intrusive_ref_counted {
+protected:
+    intrusive_ref_counted() noexcept = default;
+
+    // a copy is another object, with references of its own
+    intrusive_ref_counted(const intrusive_ref_counted&) noexcept
+    {
+    }
+    auto operator=(const intrusive_ref_counted&) noexcept -> intrusive_ref_counted&
+    {
+        return *this;
+    }
+
+    ~intrusive_ref_counted()
+    {
+        if (m_weak != nullptr) {
+            m_weak->m_alive = false;
+            if (--m_weak->m_refs == 0) {
+                delete m_weak;
+            }
+        }
+    }
+
+private:
+    size_t m_refs { 0 };
+    memory_impl::intrusive_weak_block* m_weak { nullptr };
+
+    template <typename>
+    friend class intrusive_ptr;
+
+    template <typename>
+    friend class intrusive_weak_ptr;
+};
+
+template <typename T>
+class intrusive_ptr {
+public:
+    static_assert(std::is_base_of_v<intrusive_ref_counted, T>, "intrusive_ptr type must derive from intrusive_ref_counted");
+
+    constexpr intrusive_ptr() noexcept { }
+    constexpr intrusive_ptr(std::nullptr_t) noexcept { }
+    // other `intrusive_ptr`s may already refer to `ptr`, the count is in the object
+    explicit intrusive_ptr(T* ptr) noexcept
+        : m_ptr(ptr)
+    {
+        retain();
+    }
+    intrusive_ptr(const intrusive_ptr<T>& copy) noexcept
+        : m_ptr(copy.m_ptr)
+    {
+        retain();
+    }
+    intrusive_ptr(intrusive_ptr<T>&& move) noexcept
+        : m_ptr(std::exchange(move.m_ptr, nullptr))
+    {
+    }
+
+    ~intrusive_ptr()
+    {
+        release();
+    }
+
+    auto operator=(const intrusive_ptr<T>& copy) noexcept -> intrusive_ptr<T>&
+    {
+        if (copy.m_ptr != nullptr) {
+            ++counts(copy.m_ptr).m_refs;
+        }
+        release();
+        m_ptr = copy.m_ptr;
+
+        return *this;
+    }
+    auto operator=(intrusive_ptr<T>&& move) noexcept -> intrusive_ptr<T>&
+    {
+        if (&move != this) {
+            release();
+            m_ptr = std::exchange(move.m_ptr, nullptr);
+        }
+
+        return *this;
+    }
+
+    auto deref() const -> optional<T&>
+    {
+        if (m_ptr != nullptr) {
+            return *m_ptr;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    auto empty() const -> bool
+    {
+        return m_ptr == nullptr;
+    }
+
+    auto clear() -> void
+    {
+        release();
+        m_ptr = nullptr;
+    }
+
+private:
+    static auto counts(T* ptr) -> intrusive_ref_counted&
+    {
+        return *ptr;
+    }
+
+    auto retain() -> void
+    {
+        if (m_ptr != nullptr) {
+            ++counts(m_ptr).m_refs;
+        }
+    }
+
+    auto release() -> void
+    {
+        if (m_ptr != nullptr && --counts(m_ptr).m_refs == 0) {
+            // no longer lockable, even from within its own destructor
+            if (auto* weak = counts(m_ptr).m_weak; weak != nullptr) {
+                weak->m_alive = false;
+            }
+            delete m_ptr;
+        }
+    }
+
+    T* m_ptr { nullptr };
+
+    template <typename>
+    friend class intrusive_weak_ptr;
+};
+
+template <typename T, typename... Params>
+auto make_intrusive(Params&&... params) -> intrusive_ptr<T>
+{
+    return intrusive_ptr<T> { new T(std::forward<Params>(params)...) };
+}
+
+template <typename T>
+class intrusive_weak_ptr {
+public:
+    intrusive_weak_ptr() noexcept { }
+    intrusive_weak_ptr(const intrusive_ptr<T>& s_ptr)
+        : m_ptr(s_ptr.m_ptr)
+    {
+        if (m_ptr != nullptr) {
+            auto& counts = intrusive_ptr<T>::counts(m_ptr);
+            if (counts.m_weak == nullptr) {
+                counts.m_weak = new memory_impl::intrusive_weak_block { 1, true };
+            }
+
+            m_block = counts.m_weak;
+            ++m_block->m_refs;
+        }
+    }
+    intrusive_weak_ptr(const intrusive_weak_ptr<T>& copy) noexcept
+        : m_ptr(copy.m_ptr)
+        , m_block(copy.m_block)
+    {
+        if (m_block != nullptr) {
+            ++m_block->m_refs;
+        }
+    }
+    intrusive_weak_ptr(intrusive_weak_ptr<T>&& move) noexcept
+        : m_ptr(std::exchange(move.m_ptr, nullptr))
+        , m_block(std::exchange(move.m_block, nullptr))
+    {
+    }
+
+    ~intrusive_weak_ptr()
+    {
+        release();
+    }
+
+    auto operator=(const intrusive_weak_ptr<T>& copy) noexcept -> intrusive_weak_ptr<T>&
+    {
+        if (&copy != this) {
+            *this = intrusive_weak_ptr<T> { copy };
+        }
+
+        return *this;
+    }
+    auto operator=(intrusive_weak_ptr<T>&& move) noexcept -> intrusive_weak_ptr<T>&
+    {
+        if (&move != this) {
+            release();
+            m_ptr = std::exchange(move.m_ptr, nullptr);
+            m_block = std::exchange(move.m_block, nullptr);
+        }
+
+        return *this;
+    }
+
+    auto operator=(const intrusive_ptr<T>& s_ptr) -> intrusive_weak_ptr<T>&
+    {
+        return *this = intrusive_weak_ptr<T> { s_ptr };
+    }
+
+    auto lock() const -> intrusive_ptr<T>
+    {
+        if (m_block == nullptr || !m_block->m_alive) {
+            return nullptr;
+        }
+
+        return intrusive_ptr<T> { m_ptr };
+    }
+
+    auto clear() -> void
+    {
+        release();
+        m_ptr = nullptr;
+        m_block = nullptr;
+    }
+
+private:
+    auto release() -> void
+    {
+        if (m_block != nullptr && --m_block->m_refs == 0) {
+            delete m_block;
+        }
+    }
+
+    T* m_ptr { nullptr };
+    memory_impl::intrusive_weak_block* m_block { nullptr };
+};
 }
@@ -0,0 +1,581 @@
+#pragma once
+
+#include <safet/impl/concepts.hpp>
+#include <safet/impl/coroutine.hpp>
+#include <safet/impl/hardware.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace safet {
+// Lock policies for `critical_section` and `condition_variable`. Each is a standard Lockable type, so any of them
+// can also be used with `std::unique_lock`, `std::scoped_lock`, etc. Which one fits best depends on how long the lock
+// is held and how contended it is:
+//   - `spin_mutex` never sleeps, best when held for a handful of instructions with few threads competing
+//   - `atomic_mutex` parks waiters immediately via `std::atomic::wait`, a futex on linux, with no syscall to lock or
+//     unlock when uncontended
+//   - `adaptive_mutex` spins briefly before parking like `atomic_mutex`, for locks usually released within the spin
+//   - `async_mutex` additionally lets coroutines `co_await` the lock, suspending rather than blocking the thread
+// Any of these (or a standard mutex) can be wrapped in `instrumented_mutex` to collect contention statistics
+
+namespace mutex_impl {
+    // none of the policies can park with a timeout (`std::atomic::wait` has none), so timed locking polls `try_lock`
+    // until the deadline. it backs off from spinning to yielding to sleeping, with sleeps doubling up to a cap and never
+    // past the deadline, so a short hold is still picked up quickly while a long timeout doesn't burn a whole core
+    template <typename Mutex, typename Clock, typename Duration>
+    auto try_lock_until(Mutex& m, const std::chrono::time_point<Clock, Duration>& deadline) noexcept -> bool
+    {
+        constexpr uint32_t spin_rounds = 64;
+        constexpr uint32_t yield_rounds = 16;
+        constexpr auto max_sleep = std::chrono::microseconds { 1000 };
+
+        auto sleep = std::chrono::microseconds { 1 };
+        for (uint32_t round = 0; !m.try_lock(); ++round) {
+            const auto now = Clock::now();
+            if (now >= deadline) {
+                return false;
+            }
+
+            if (round < spin_rounds) {
+                impl::cpu_relax();
+            } else if (round < spin_rounds + yield_rounds) {
+                std::this_thread::yield();
+            } else {
+                const auto remaining = std::chrono::ceil<std::chrono::microseconds>(deadline - now);
+                std::this_thread::sleep_for(std::min(sleep, remaining));
+                sleep = std::min(sleep * 2, max_sleep);
+            }
+        }
+
+        return true;
+    }
+}
+
+// test and test-and-set spinlock, waiting threads spin on a relaxed load so they share the cache line instead of
+// bouncing it between cores until the lock actually looks free
+class spin_mutex {
+public:
+    spin_mutex() noexcept = default;
+
+    spin_mutex(const spin_mutex&) = delete;
+    spin_mutex(spin_mutex&&) = delete;
+
+    auto operator=(const spin_mutex&) -> spin_mutex& = delete;
+    auto operator=(spin_mutex&&) -> spin_mutex& = delete;
+
+    auto lock() noexcept -> void
+    {
+        while (m_locked.exchange(true, std::memory_order_acquire)) {
+            while (m_locked.load(std::memory_order_relaxed)) {
+                impl::cpu_relax();
+            }
+        }
+    }
+
+    auto try_lock() noexcept -> bool
+    {
+        return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    template <typename Rep, typename Period>
+    auto try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept -> bool
+    {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Clock, typename Duration>
+    auto try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept -> bool
+    {
+        return mutex_impl::try_lock_until(*this, deadline);
+    }
+
+    auto unlock() noexcept -> void
+    {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> m_locked { false };
+};
+
+namespace mutex_impl {
+    // three state futex lock (see "Futexes Are Tricky", Drepper). The state only becomes `CONTENDED` once a thread is
+    // about to park, so unlocking only needs to notify when someone might actually be waiting
+    template <uint32_t SpinCount>
+    class parking_mutex {
+    public:
+        parking_mutex() noexcept = default;
+
+        parking_mutex(const parking_mutex&) = delete;
+        parking_mutex(parking_mutex&&) = delete;
+
+        auto operator=(const parking_mutex&) -> parking_mutex& = delete;
+        auto operator=(parking_mutex&&) -> parking_mutex& = delete;
+
+        auto lock() noexcept -> void
+        {
+            auto state = UNLOCKED;
+            if (m_state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return;
+            }
+
+            for (uint32_t spin = 0; spin < SpinCount; ++spin) {
+                impl::cpu_relax();
+
+                state = m_state.load(std::memory_order_relaxed);
+                if (state == UNLOCKED && m_state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return;
+                } else if (state == CONTENDED) {
+                    // others are already parked, no point spinning any longer
+                    break;
+                }
+            }
+
+            // from here on we must leave the state as CONTENDED even if we acquire it, we cannot know if others are
+            // also parked and they must be notified when we unlock
+            while (m_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+                m_state.wait(CONTENDED, std::memory_order_relaxed);
+            }
+        }
+
+        auto try_lock() noexcept -> bool
+        {
+            auto state = UNLOCKED;
+            return m_state.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        template <typename Rep, typename Period>
+        auto try_lock_for(const std::chrono::duration<Rep, Period>& timeout) noexcept -> bool
+        {
+            return try_lock_until(std::chrono::steady_clock::now() + timeout);
+        }
+
+        template <typename Clock, typename Duration>
+        auto try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) noexcept -> bool
+        {
+            return mutex_impl::try_lock_until(*this, deadline);
+        }
+
+        auto unlock() noexcept -> void
+        {
+            if (m_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+                m_state.notify_one();
+            }
+        }
+
+    private:
+        static constexpr uint32_t UNLOCKED = 0;
+        static constexpr uint32_t LOCKED = 1;
+        static constexpr uint32_t CONTENDED = 2;
+
+        std::atomic<uint32_t> m_state { UNLOCKED };
+    };
+}
+
+using atomic_mutex = mutex_impl::parking_mutex<0>;
+
+template <uint32_t SpinCount = 128>
+using adaptive_mutex = mutex_impl::parking_mutex<SpinCount>;
+
+// a mutex that coroutines can acquire with `co_await m.lock_async()`, suspending instead of blocking while it's held.
+// Waiters, coroutines and threads alike, queue in an intrusive list of nodes living in their own frame (or stack) and
+// are served in FIFO order, with `unlock` handing the lock directly to the next waiter. A coroutine handed the lock is
+// resumed on the unlocking thread.
+//
+// `critical_section<T, async_mutex>::enter_async` is the safe way to use this, `lock_async` is the building block
+class async_mutex {
+public:
+    struct waiter {
+        waiter* m_next { nullptr };
+        // called once the waiter owns the lock
+        auto (*m_wake)(waiter&) -> void;
+    };
+
+    class lock_awaiter : waiter, impl::resumable {
+    public:
+        explicit lock_awaiter(async_mutex& m) noexcept
+            : waiter { nullptr, &wake }
+            , m_mutex(m)
+        {
+        }
+
+        lock_awaiter(const lock_awaiter&) = delete;
+        lock_awaiter(lock_awaiter&&) = delete;
+
+        auto operator=(const lock_awaiter&) -> lock_awaiter& = delete;
+        auto operator=(lock_awaiter&&) -> lock_awaiter& = delete;
+
+        auto await_ready() noexcept -> bool
+        {
+            return m_mutex.try_lock();
+        }
+
+        auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool
+        {
+            m_handle = handle;
+
+            // may already be resumed on another thread once queued, so nothing may touch `this` afterwards
+            return m_mutex.enqueue(*this);
+        }
+
+        auto await_resume() noexcept -> void
+        {
+        }
+
+    private:
+        static auto wake(waiter& w) -> void
+        {
+            impl::resume(static_cast<lock_awaiter&>(w));
+        }
+
+        async_mutex& m_mutex;
+    };
+
+    async_mutex() noexcept = default;
+
+    async_mutex(const async_mutex&) = delete;
+    async_mutex(async_mutex&&) = delete;
+
+    ~async_mutex() = default;
+
+    auto operator=(const async_mutex&) -> async_mutex& = delete;
+    auto operator=(async_mutex&&) -> async_mutex& = delete;
+
+    // awaiting the result acquires the lock, which must then be released with `unlock`
+    auto lock_async() noexcept -> lock_awaiter
+    {
+        return lock_awaiter { *this };
+    }
+
+    auto lock() -> void
+    {
+        if (try_lock()) {
+            return;
+        }
+
+        blocking_waiter w;
+        if (enqueue(w)) {
+            std::unique_lock l { w.m_mutex };
+            w.m_cv.wait(l, [&]() { return w.m_owned; });
+        }
+    }
+
+    auto try_lock() noexcept -> bool
+    {
+        auto expected = UNLOCKED;
+        return m_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    auto unlock() -> void
+    {
+        // `m_queue` is only accessed by the lock holder
+        if (m_queue == nullptr) {
+            auto expected = LOCKED;
+            if (m_state.compare_exchange_strong(expected, UNLOCKED, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+
+            // new waiters have been pushed onto `m_state`, newest first, so take them all and reverse them into FIFO
+            auto* pushed = reinterpret_cast<waiter*>(m_state.exchange(LOCKED, std::memory_order_acquire));
+            while (pushed != nullptr) {
+                auto* next = pushed->m_next;
+                pushed->m_next = m_queue;
+                m_queue = pushed;
+                pushed = next;
+            }
+        }
+
+        auto* next = m_queue;
+        m_queue = next->m_next;
+
+        next->m_wake(*next);
+    }
+
+private:
+    // blocking `lock` calls wait on their own condition variable, notified under its mutex as the waiter may return
+    // (destroying both) as soon as it observes `m_owned`
+    struct blocking_waiter : waiter {
+        blocking_waiter() noexcept
+            : waiter { nullptr, &wake }
+        {
+        }
+
+        static auto wake(waiter& w) -> void
+        {
+            auto& self = static_cast<blocking_waiter&>(w);
+
+            std::unique_lock l { self.m_mutex };
+            self.m_owned = true;
+            self.m_cv.notify_one();
+        }
+
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_owned { false };
+    };
+
+    // UNLOCKED is never a valid waiter address, LOCKED (null) means locked with no waiters pushed, anything else is
+    // locked with the newest pushed waiter
+    static constexpr uintptr_t UNLOCKED = 1;
+    static constexpr uintptr_t LOCKED = 0;
+
+    // returns false if the lock was acquired rather than `w` queued
+    auto enqueue(waiter& w) noexcept -> bool
+    {
+        auto state = m_state.load(std::memory_order_relaxed);
+        for (;;) {
+            if (state == UNLOCKED) {
+                if (m_state.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return false;
+                }
+            } else {
+                w.m_next = reinterpret_cast<waiter*>(state);
+                if (m_state.compare_exchange_weak(state, reinterpret_cast<uintptr_t>(&w), std::memory_order_release, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    std::atomic<uintptr_t> m_state { UNLOCKED };
+    waiter* m_queue { nullptr };
+};
+
+struct lock_stats {
+    std::string name;
+    uint64_t acquisitions { 0 };
+    // acquisitions which could not lock immediately and had to wait
+    uint64_t contended_acquisitions { 0 };
+    uint64_t failed_try_locks { 0 };
+    std::chrono::nanoseconds total_wait { 0 };
+    std::chrono::nanoseconds max_wait { 0 };
+    // hold times are only recorded for exclusive locks, shared holders have no single owner to time
+    std::chrono::nanoseconds total_hold { 0 };
+    std::chrono::nanoseconds max_hold { 0 };
+};
+
+namespace mutex_impl {
+    inline auto record_max(std::atomic<int64_t>& max, int64_t value) noexcept -> void
+    {
+        auto current = max.load(std::memory_order_relaxed);
+        while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    inline constexpr size_t stats_shard_count { 8 };
+
+    // threads are assigned a shard round robin the first time they record anything, and keep to it for every
+    // `instrumented_mutex`
+    inline auto stats_shard_index() noexcept -> size_t
+    {
+        static std::atomic<size_t> next { 0 };
+        thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed) % stats_shard_count;
+
+        return index;
+    }
+
+    // one cache line per shard, so threads recording statistics only write to lines no other thread writes to (as
+    // long as there are no more threads than shards), rather than all contending on one next to the lock
+    struct alignas(impl::cache_line_size) stats_shard {
+        std::atomic<uint64_t> m_acquisitions { 0 };
+        std::atomic<uint64_t> m_contended_acquisitions { 0 };
+        std::atomic<uint64_t> m_failed_try_locks { 0 };
+        std::atomic<int64_t> m_total_wait { 0 };
+        std::atomic<int64_t> m_max_wait { 0 };
+        std::atomic<int64_t> m_total_hold { 0 };
+        std::atomic<int64_t> m_max_hold { 0 };
+    };
+}
+
+// wraps another lock policy, recording statistics about its use with relaxed atomic counters, sharded by thread and
+// only summed by `stats()`. The wrapped `Mutex` is otherwise used exactly as it would be directly, so it's the only
+// cost of instrumentation. For `critical_section<T, instrumented_mutex<...>>` the statistics are exposed through
+// `stats()` and `set_name()`, neither of which takes the wrapped `Mutex`, so both may be called at any time, even from
+// within the critical section
+template <impl::lockable Mutex = std::mutex>
+class instrumented_mutex {
+public:
+    instrumented_mutex() = default;
+
+    instrumented_mutex(const instrumented_mutex&) = delete;
+    instrumented_mutex(instrumented_mutex&&) = delete;
+
+    auto operator=(const instrumented_mutex&) -> instrumented_mutex& = delete;
+    auto operator=(instrumented_mutex&&) -> instrumented_mutex& = delete;
+
+    auto lock() -> void
+    {
+        if (!m_mutex.try_lock()) {
+            const auto start = clock::now();
+            m_mutex.lock();
+            m_hold_start = clock::now();
+
+            record_wait(m_hold_start - start);
+        } else {
+            m_hold_start = clock::now();
+        }
+
+        local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto try_lock() -> bool
+    {
+        if (m_mutex.try_lock()) {
+            m_hold_start = clock::now();
+            local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        local().m_failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    template <typename Rep, typename Period>
+    requires(impl::timed_lockable<Mutex>)
+    auto try_lock_for(const std::chrono::duration<Rep, Period>& timeout) -> bool
+    {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    template <typename Clock, typename Duration>
+    requires(impl::timed_lockable<Mutex>)
+    auto try_lock_until(const std::chrono::time_point<Clock, Duration>& deadline) -> bool
+    {
+        if (m_mutex.try_lock()) {
+            m_hold_start = clock::now();
+            local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        const auto start = clock::now();
+        if (m_mutex.try_lock_until(deadline)) {
+            m_hold_start = clock::now();
+            local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+            record_wait(m_hold_start - start);
+
+            return true;
+        }
+
+        local().m_failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    auto unlock() -> void
+    {
+        const auto held = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_hold_start).count();
+        auto& shard = local();
+        shard.m_total_hold.fetch_add(held, std::memory_order_relaxed);
+        mutex_impl::record_max(shard.m_max_hold, held);
+
+        m_mutex.unlock();
+    }
+
+    auto lock_shared() -> void requires(impl::shared_lockable<Mutex>)
+    {
+        if (!m_mutex.try_lock_shared()) {
+            const auto start = clock::now();
+            m_mutex.lock_shared();
+
+            record_wait(clock::now() - start);
+        }
+
+        local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto try_lock_shared() -> bool requires(impl::shared_lockable<Mutex>)
+    {
+        if (m_mutex.try_lock_shared()) {
+            local().m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        local().m_failed_try_locks.fetch_add(1, std::memory_order_relaxed);
+
+        return false;
+    }
+
+    auto unlock_shared() -> void requires(impl::shared_lockable<Mutex>)
+    {
+        m_mutex.unlock_shared();
+    }
+
+    auto set_name(std::string_view name) -> void
+    {
+        std::unique_lock l { m_name_mutex };
+        m_name = name;
+    }
+
+    // counters are read shard by shard while others may still be recording, so a snapshot of a busy lock is only
+    // approximately consistent
+    auto stats() const -> lock_stats
+    {
+        lock_stats snapshot;
+        {
+            std::unique_lock l { m_name_mutex };
+            snapshot.name = m_name;
+        }
+
+        int64_t total_wait { 0 };
+        int64_t max_wait { 0 };
+        int64_t total_hold { 0 };
+        int64_t max_hold { 0 };
+        for (const auto& shard : m_shards) {
+            snapshot.acquisitions += shard.m_acquisitions.load(std::memory_order_relaxed);
+            snapshot.contended_acquisitions += shard.m_contended_acquisitions.load(std::memory_order_relaxed);
+            snapshot.failed_try_locks += shard.m_failed_try_locks.load(std::memory_order_relaxed);
+            total_wait += shard.m_total_wait.load(std::memory_order_relaxed);
+            max_wait = std::max(max_wait, shard.m_max_wait.load(std::memory_order_relaxed));
+            total_hold += shard.m_total_hold.load(std::memory_order_relaxed);
+            max_hold = std::max(max_hold, shard.m_max_hold.load(std::memory_order_relaxed));
+        }
+
+        snapshot.total_wait = std::chrono::nanoseconds { total_wait };
+        snapshot.max_wait = std::chrono::nanoseconds { max_wait };
+        snapshot.total_hold = std::chrono::nanoseconds { total_hold };
+        snapshot.max_hold = std::chrono::nanoseconds { max_hold };
+
+        return snapshot;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    auto record_wait(clock::duration wait) -> void
+    {
+        const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+
+        auto& shard = local();
+        shard.m_contended_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        shard.m_total_wait.fetch_add(waited, std::memory_order_relaxed);
+        mutex_impl::record_max(shard.m_max_wait, waited);
+    }
+
+    auto local() noexcept -> mutex_impl::stats_shard&
+    {
+        return m_shards[mutex_impl::stats_shard_index()];
+    }
+
+    mutable Mutex m_mutex;
+    // only ever touched by the exclusive owner, the lock itself orders access
+    clock::time_point m_hold_start;
+
+    mutable std::mutex m_name_mutex;
+    std::string m_name;
+
+    std::array<mutex_impl::stats_shard, mutex_impl::stats_shard_count> m_shards;
+};
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <safet/impl/concepts.hpp>
+#include <safet/memory.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace safet {
+template <typename T, typename Reset>
+class object_pool;
+
+namespace object_pool_impl {
+    // the memory of one pooled object, and its link while it waits in a free list
+    template <typename T>
+    struct node {
+        auto value() noexcept -> T*
+        {
+            return std::launder(reinterpret_cast<T*>(m_storage));
+        }
+
+        static auto of(T* value) noexcept -> node*
+        {
+            return reinterpret_cast<node*>(reinterpret_cast<std::byte*>(value) - offsetof(node, m_storage));
+        }
+
+        alignas(T) std::byte m_storage[sizeof(T)];
+        node* m_next { nullptr };
+    };
+
+    // frees a list of nodes, destroying their objects first when the pool keeps them constructed
+    template <typename T, bool Constructed>
+    auto free_nodes(node<T>* head) noexcept -> void
+    {
+        while (head != nullptr) {
+            auto* next = head->m_next;
+            if constexpr (Constructed) {
+                std::destroy_at(head->value());
+            }
+            delete head;
+            head = next;
+        }
+    }
+
+    // the global free list of one pool, shared with the thread caches holding that pool's objects so those can be
+    // returned to it, or freed, even once the pool itself is gone
+    template <typename T, bool Constructed>
+    struct shared_state {
+        ~shared_state()
+        {
+            free_nodes<T, Constructed>(m_head);
+        }
+
+        std::mutex m_mutex;
+        node<T>* m_head { nullptr };
+        // objects waiting for reuse in the global list, plus those in each thread's cache as of its last flush or
+        // refill, so threads only update it when they take the mutex anyway
+        std::atomic<size_t> m_retained { 0 };
+        std::atomic<bool> m_open { true };
+    };
+
+    // the objects of each pool this thread released most recently, taken again without any synchronization. Caches
+    // return everything they hold to the global list when the thread exits. A pool may outlive the cache, e.g. one at
+    // namespace scope is destroyed after the main thread's thread_locals, so the cache's lifetime is tracked in a
+    // trivially destructible thread_local that stays readable throughout
+    template <typename T, bool Constructed>
+    class thread_cache {
+    public:
+        using state_type = shared_state<T, Constructed>;
+
+        static constexpr size_t capacity = 64;
+
+        struct entry {
+            std::shared_ptr<state_type> m_state;
+            node<T>* m_head { nullptr };
+            size_t m_count { 0 };
+            // how much of `m_count` is included in the state's `m_retained`
+            size_t m_reported { 0 };
+        };
+
+        thread_cache() noexcept
+        {
+            s_lifetime = lifetime::ALIVE;
+        }
+
+        thread_cache(const thread_cache&) = delete;
+
+        ~thread_cache()
+        {
+            for (auto& e : m_entries) {
+                flush(e, e.m_count);
+            }
+
+            s_lifetime = lifetime::DESTROYED;
+        }
+
+        auto operator=(const thread_cache&) -> thread_cache& = delete;
+
+        // null once this thread's cache has been destroyed, callers then use the global list directly
+        static auto local() -> thread_cache*
+        {
+            if (s_lifetime == lifetime::DESTROYED) {
+                return nullptr;
+            }
+
+            thread_local thread_cache cache;
+            return &cache;
+        }
+
+        // as `local`, but also null if this thread hasn't created its cache, so it's never created during exit
+        static auto existing() -> thread_cache*
+        {
+            return s_lifetime == lifetime::ALIVE ? local() : nullptr;
+        }
+
+        auto find(const std::shared_ptr<state_type>& state) -> entry&
+        {
+            if (m_last < m_entries.size() && m_entries[m_last].m_state == state) {
+                return m_entries[m_last];
+            }
+
+            // pools come and go far less often than objects, so closed ones are only dropped when looking for another
+            std::erase_if(m_entries, [](entry& e) {
+                if (e.m_state->m_open.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+
+                free_nodes<T, Constructed>(std::exchange(e.m_head, nullptr));
+                return true;
+            });
+
+            auto found = std::find_if(m_entries.begin(), m_entries.end(), [&state](const entry& e) { return e.m_state == state; });
+            if (found == m_entries.end()) {
+                found = m_entries.insert(m_entries.end(), entry { state });
+            }
+
+            m_last = static_cast<size_t>(found - m_entries.begin());
+            return *found;
+        }
+
+        // takes the whole cache of a pool being destroyed by this thread
+        auto drop(const std::shared_ptr<state_type>& state) noexcept -> void
+        {
+            std::erase_if(m_entries, [&state](entry& e) {
+                if (e.m_state != state) {
+                    return false;
+                }
+
+                free_nodes<T, Constructed>(std::exchange(e.m_head, nullptr));
+                return true;
+            });
+        }
+
+        // this cache's objects not yet counted in the state's `m_retained`, negative once it has handed out reported ones
+        static auto unreported(const entry& e) noexcept -> std::ptrdiff_t
+        {
+            return static_cast<std::ptrdiff_t>(e.m_count - e.m_reported);
+        }
+
+        // the state's `m_retained` plus this thread's unreported objects, exact for a pool only this thread uses
+        auto retained(const std::shared_ptr<state_type>& state) const noexcept -> size_t
+        {
+            auto total = static_cast<std::ptrdiff_t>(state->m_retained.load(std::memory_order_relaxed));
+            for (const auto& e : m_entries) {
+                if (e.m_state == state) {
+                    total += unreported(e);
+                }
+            }
+
+            return static_cast<size_t>(std::max<std::ptrdiff_t>(total, 0));
+        }
+
+        // moves `count` nodes from the cache to the global list, in one critical section
+        static auto flush(entry& e, size_t count) noexcept -> void
+        {
+            reconcile(e);
+            if (count == 0) {
+                return;
+            }
+
+            auto* first = e.m_head;
+            auto* last = first;
+            for (size_t i = 1; i < count; ++i) {
+                last = last->m_next;
+            }
+
+            e.m_head = std::exchange(last->m_next, nullptr);
+            e.m_count -= count;
+            e.m_reported -= count;
+
+            std::lock_guard guard { e.m_state->m_mutex };
+            last->m_next = e.m_state->m_head;
+            e.m_state->m_head = first;
+        }
+
+        // refills an empty cache with up to half its capacity from the global list
+        static auto refill(entry& e) -> void
+        {
+            reconcile(e);
+
+            std::lock_guard guard { e.m_state->m_mutex };
+            while (e.m_state->m_head != nullptr && e.m_count < capacity / 2) {
+                auto* n = std::exchange(e.m_state->m_head, e.m_state->m_head->m_next);
+                n->m_next = e.m_head;
+                e.m_head = n;
+                ++e.m_count;
+                ++e.m_reported;
+            }
+        }
+
+    private:
+        // wraps around for a negative difference, which the unsigned addition then takes back off
+        static auto reconcile(entry& e) noexcept -> void
+        {
+            if (e.m_count != e.m_reported) {
+                e.m_state->m_retained.fetch_add(e.m_count - e.m_reported, std::memory_order_relaxed);
+                e.m_reported = e.m_count;
+            }
+        }
+
+        enum class lifetime : uint8_t {
+            NOT_CREATED,
+            ALIVE,
+            DESTROYED,
+        };
+
+        static inline thread_local lifetime s_lifetime { lifetime::NOT_CREATED };
+
+        std::vector<entry> m_entries;
+        size_t m_last { 0 };
+    };
+}
+
+// returns objects to the `object_pool` they were acquired from, for the `unique_ptr`s it hands out
+template <typename T, typename Reset = void>
+class pool_deleter {
+public:
+    pool_deleter() noexcept = default;
+    pool_deleter(object_pool<T, Reset>& pool) noexcept
+        : m_pool(&pool)
+    {
+    }
+
+    auto operator()(T* ptr) const -> void
+    {
+        m_pool->release(ptr);
+    }
+
+private:
+    object_pool<T, Reset>* m_pool { nullptr };
+};
+
+// recycles objects of one type: destroying or clearing the `unique_ptr` an object was acquired through returns it to
+// the pool, to be handed out again by a later `acquire`. Released objects are cached per thread, so acquiring and
+// releasing on the same thread doesn't synchronize, and spill over to a global list shared by all threads. At most
+// `max_retained` objects wait for reuse at once, past that released objects are freed.
+//
+// Without a `Reset` hook objects are destroyed on release and constructed again on `acquire`, only their memory is
+// reused. With one, released objects are passed to `Reset` instead of being destroyed and `acquire` hands them out
+// again as they are, default constructing new objects only when none are waiting.
+//
+// The pool must outlive every object acquired from it
+template <typename T, typename Reset = void>
+class object_pool {
+public:
+    using pointer = unique_ptr<T, pool_deleter<T, Reset>>;
+
+    static_assert(std::is_void_v<Reset> || impl::invocable<std::add_lvalue_reference_t<Reset>, T&>, "object_pool reset hook must be invocable with T&");
+    static_assert(std::is_void_v<Reset> || std::is_default_constructible_v<T>, "object_pool with a reset hook must be able to default construct T");
+
+    explicit object_pool(size_t max_retained = 1024) requires(std::is_void_v<Reset>)
+        : m_max_retained(max_retained)
+    {
+    }
+
+    template <typename R = Reset>
+    requires(!std::is_void_v<Reset> && std::is_same_v<R, Reset>)
+    explicit object_pool(R reset, size_t max_retained = 1024)
+        : m_reset(std::move(reset))
+        , m_max_retained(max_retained)
+    {
+    }
+
+    object_pool(const object_pool&) = delete;
+    object_pool(object_pool&&) = delete;
+
+    ~object_pool()
+    {
+        m_state->m_open.store(false, std::memory_order_relaxed);
+        if (auto* cache = cache_type::existing(); cache != nullptr) {
+            cache->drop(m_state);
+        }
+    }
+
+    auto operator=(const object_pool&) -> object_pool& = delete;
+    auto operator=(object_pool&&) -> object_pool& = delete;
+
+    template <typename... Params>
+    auto acquire(Params&&... params) -> pointer requires(std::is_void_v<Reset>)
+    {
+        static_assert(std::is_constructible_v<T, Params&&...>, "object_pool::acquire params must construct T");
+
+        auto* n = take();
+        if (n == nullptr) {
+            n = new node_type;
+        }
+
+        try {
+            std::construct_at(reinterpret_cast<T*>(n->m_storage), std::forward<Params>(params)...);
+        } catch (...) {
+            delete n;
+            throw;
+        }
+
+        return pointer { n->value(), pool_deleter<T, Reset> { *this } };
+    }
+
+    auto acquire() -> pointer requires(!std::is_void_v<Reset>)
+    {
+        if (auto* n = take(); n != nullptr) {
+            return pointer { n->value(), pool_deleter<T, Reset> { *this } };
+        }
+
+        auto* n = new node_type;
+        try {
+            std::construct_at(reinterpret_cast<T*>(n->m_storage));
+        } catch (...) {
+            delete n;
+            throw;
+        }
+
+        return pointer { n->value(), pool_deleter<T, Reset> { *this } };
+    }
+
+    // how many objects are waiting for reuse, globally and in every thread's cache. Other threads' caches are only
+    // counted as of their last exchange with the global list, so this is only exact for objects this thread released
+    auto retained() const -> size_t
+    {
+        if (const auto* cache = cache_type::existing(); cache != nullptr) {
+            return cache->retained(m_state);
+        }
+
+        return m_state->m_retained.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr bool constructed = !std::is_void_v<Reset>;
+
+    using node_type = object_pool_impl::node<T>;
+    using state_type = object_pool_impl::shared_state<T, constructed>;
+    using cache_type = object_pool_impl::thread_cache<T, constructed>;
+
+    struct no_reset { };
+
+    auto take() -> node_type*
+    {
+        auto* cache = cache_type::local();
+        if (cache == nullptr) {
+            return take_global();
+        }
+
+        auto& e = cache->find(m_state);
+        if (e.m_head == nullptr) {
+            cache_type::refill(e);
+            if (e.m_head == nullptr) {
+                return nullptr;
+            }
+        }
+
+        --e.m_count;
+        return std::exchange(e.m_head, e.m_head->m_next);
+    }
+
+    auto release(T* ptr) -> void
+    {
+        if constexpr (constructed) {
+            m_reset(*ptr);
+        } else {
+            std::destroy_at(ptr);
+        }
+
+        auto* n = node_type::of(ptr);
+        n->m_next = nullptr;
+
+        auto* cache = cache_type::local();
+        if (cache == nullptr) {
+            release_global(n);
+            return;
+        }
+
+        // other threads' unreported objects aren't seen, so up to `capacity` more per thread may be kept
+        auto& e = cache->find(m_state);
+        const auto retained = static_cast<std::ptrdiff_t>(m_state->m_retained.load(std::memory_order_relaxed)) + cache_type::unreported(e);
+        if (retained >= static_cast<std::ptrdiff_t>(m_max_retained)) {
+            object_pool_impl::free_nodes<T, constructed>(n);
+            return;
+        }
+
+        n->m_next = e.m_head;
+        e.m_head = n;
+        if (++e.m_count > cache_type::capacity) {
+            cache_type::flush(e, cache_type::capacity / 2);
+        }
+    }
+
+    auto release_global(node_type* n) -> void
+    {
+        if (m_state->m_retained.fetch_add(1, std::memory_order_relaxed) >= m_max_retained) {
+            m_state->m_retained.fetch_sub(1, std::memory_order_relaxed);
+            object_pool_impl::free_nodes<T, constructed>(n);
+            return;
+        }
+
+        std::lock_guard guard { m_state->m_mutex };
+        n->m_next = m_state->m_head;
+        m_state->m_head = n;
+    }
+
+    auto take_global() -> node_type*
+    {
+        std::lock_guard guard { m_state->m_mutex };
+        if (m_state->m_head == nullptr) {
+            return nullptr;
+        }
+
+        m_state->m_retained.fetch_sub(1, std::memory_order_relaxed);
+        return std::exchange(m_state->m_head, m_state->m_head->m_next);
+    }
+
+    [[no_unique_address]] std::conditional_t<constructed, Reset, no_reset> m_reset {};
+    size_t m_max_retained;
+    std::shared_ptr<state_type> m_state { std::make_shared<state_type>() };
+
+    friend class pool_deleter<T, Reset>;
+};
+}
@@ -6,12 +6,25 @@
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <tuple>
 
 namespace safet {
 
 template <typename T>
 class optional;
 
+template <typename Source, typename... Stages>
+class optional_pipeline;
+
+// specialize for a type with a value that never occurs in practice (e.g. an invalid id or handle) to have `optional`
+// use that value to mean "empty", making `optional<T>` exactly as large as `T`. A specialization provides:
+//   static auto empty_value() -> T;            // constructs the sentinel
+//   static auto is_empty(const T& value) -> bool;
+// `T` must be move assignable, and an optional engaged with the sentinel value reads as empty
+template <typename T>
+struct optional_niche {
+};
+
 namespace optional_impl {
     template <typename T>
     struct is_optional : std::false_type {
@@ -40,6 +53,188 @@ namespace optional_impl {
     template <typename T, typename OptionalType>
     concept equality_comparable_with_optional = !std::same_as<T, optional<OptionalType>> && std::equality_comparable_with<T, OptionalType>;
 
+    template <typename T>
+    concept has_niche = requires(const T& value)
+    {
+        { optional_niche<T>::empty_value() } -> std::same_as<T>;
+        { optional_niche<T>::is_empty(value) } -> std::convertible_to<bool>;
+    };
+
+    // references are always stored as a plain pointer, so are always trivial
+    template <typename T>
+    inline constexpr bool trivially_copy_constructible = std::is_reference_v<T> || std::is_trivially_copy_constructible_v<T>;
+
+    template <typename T>
+    inline constexpr bool trivially_move_constructible = std::is_reference_v<T> || std::is_trivially_move_constructible_v<T>;
+
+    template <typename T>
+    inline constexpr bool trivially_destructible = std::is_reference_v<T> || std::is_trivially_destructible_v<T>;
+
+    template <typename T>
+    inline constexpr bool trivially_copy_assignable = std::is_reference_v<T> || (std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_assignable_v<T> && std::is_trivially_destructible_v<T>);
+
+    template <typename T>
+    inline constexpr bool trivially_move_assignable = std::is_reference_v<T> || (std::is_trivially_move_constructible_v<T> && std::is_trivially_move_assignable_v<T> && std::is_trivially_destructible_v<T>);
+
+    // the three representations below share one interface. `construct` may only be called while empty, `get` and
+    // `destroy` only while engaged
+
+    // the value in an aligned union followed by the flag, so the flag lands in what would otherwise be tail padding
+    // of the optional rather than pushing the value off its alignment
+    template <typename T>
+    class flagged_storage {
+    public:
+        constexpr flagged_storage() noexcept
+            : m_empty {}
+        {
+        }
+
+        // only used by `optional` when trivial, otherwise the union makes them deleted
+        flagged_storage(const flagged_storage&) = default;
+        flagged_storage(flagged_storage&&) = default;
+
+        // `optional` destroys any value
+        ~flagged_storage() requires(std::is_trivially_destructible_v<T>) = default;
+        constexpr ~flagged_storage()
+        {
+        }
+
+        auto operator=(const flagged_storage&) -> flagged_storage& = default;
+        auto operator=(flagged_storage&&) -> flagged_storage& = default;
+
+        constexpr auto engaged() const noexcept -> bool
+        {
+            return m_engaged;
+        }
+
+        constexpr auto get() noexcept -> T&
+        {
+            return m_value;
+        }
+        constexpr auto get() const noexcept -> const T&
+        {
+            return m_value;
+        }
+
+        template <typename... Args>
+        constexpr auto construct(Args&&... args) -> T&
+        {
+            auto& value = *std::construct_at(std::addressof(m_value), std::forward<Args>(args)...);
+            m_engaged = true;
+
+            return value;
+        }
+
+        constexpr auto destroy() -> void
+        {
+            std::destroy_at(std::addressof(m_value));
+            m_engaged = false;
+        }
+
+    private:
+        // an active member while empty, so that empty optionals are usable in constant expressions
+        struct empty_type {
+        };
+
+        union {
+            empty_type m_empty;
+            T m_value;
+        };
+        bool m_engaged { false };
+    };
+
+    // references are stored as a pointer, null when empty
+    template <typename T>
+    class reference_storage {
+    public:
+        using pointer_type = std::add_pointer_t<std::remove_reference_t<T>>;
+
+        constexpr reference_storage() noexcept = default;
+
+        reference_storage(const reference_storage&) = default;
+        reference_storage(reference_storage&&) = default;
+
+        ~reference_storage() = default;
+
+        auto operator=(const reference_storage&) -> reference_storage& = default;
+        auto operator=(reference_storage&&) -> reference_storage& = default;
+
+        constexpr auto engaged() const noexcept -> bool
+        {
+            return m_pointer != nullptr;
+        }
+
+        constexpr auto get() const noexcept -> T
+        {
+            return *m_pointer;
+        }
+
+        // no need to forward, always a single reference
+        template <typename Arg>
+        constexpr auto construct(Arg&& arg) noexcept -> T
+        {
+            m_pointer = std::addressof(arg);
+            return *m_pointer;
+        }
+
+        constexpr auto destroy() noexcept -> void
+        {
+            m_pointer = nullptr;
+        }
+
+    private:
+        pointer_type m_pointer { nullptr };
+    };
+
+    // a `T` which always holds a value, `optional_niche<T>::empty_value()` when empty
+    template <typename T>
+    class niche_storage {
+    public:
+        constexpr niche_storage() noexcept(std::is_nothrow_move_constructible_v<T>)
+            : m_value(optional_niche<T>::empty_value())
+        {
+        }
+
+        niche_storage(const niche_storage&) = default;
+        niche_storage(niche_storage&&) = default;
+
+        ~niche_storage() = default;
+
+        auto operator=(const niche_storage&) -> niche_storage& = default;
+        auto operator=(niche_storage&&) -> niche_storage& = default;
+
+        constexpr auto engaged() const noexcept -> bool
+        {
+            return !optional_niche<T>::is_empty(m_value);
+        }
+
+        constexpr auto get() noexcept -> T&
+        {
+            return m_value;
+        }
+        constexpr auto get() const noexcept -> const T&
+        {
+            return m_value;
+        }
+
+        template <typename... Args>
+        constexpr auto construct(Args&&... args) -> T&
+        {
+            m_value = T(std::forward<Args>(args)...);
+            return m_value;
+        }
+
+        constexpr auto destroy() -> void
+        {
+            m_value = optional_niche<T>::empty_value();
+        }
+
+    private:
+        T m_value;
+    };
+
+    template <typename T>
+    using storage_for = std::conditional_t<std::is_reference_v<T>, reference_storage<T>, std::conditional_t<has_niche<T>, niche_storage<T>, flagged_storage<T>>>;
 }
 
 template <typename T>
@@ -47,57 +242,55 @@ class optional {
 public:
     using value_type = T;
 
-    optional() noexcept
-        : m_engaged(false)
-    {
-    }
+    optional() noexcept = default;
 
-    optional(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
-        : m_engaged(false) // will be true upon `construct` being called below
+    constexpr optional(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
     {
         construct(std::move(value));
     }
 
     template <typename... Args>
-    optional(std::in_place_t, Args&&... args) noexcept(noexcept(T(std::declval<Args&&>()...)))
-        : m_engaged(false) // will be true upon `construct` being called below
+    constexpr optional(std::in_place_t, Args&&... args) noexcept(noexcept(T(std::declval<Args&&>()...)))
     {
         construct(std::forward<Args>(args)...);
     }
 
-    optional(std::nullopt_t) noexcept
-        : m_engaged(false)
+    constexpr optional(std::nullopt_t) noexcept
     {
     }
 
-    optional(const optional& copy) noexcept(std::is_nothrow_copy_constructible_v<T>)
-        : m_engaged(false) // will be true upon `construct` being called below (if copy is engaged)
+    // every special member is trivial when the corresponding member of `T` is, so e.g. `optional<int>` is trivially
+    // copyable and can be passed in registers, memcpy'd by containers, etc.
+    optional(const optional&) requires(optional_impl::trivially_copy_constructible<T>) = default;
+    constexpr optional(const optional& copy) noexcept(std::is_nothrow_copy_constructible_v<T>)
     {
-        if (copy.m_engaged) {
+        if (copy.engaged()) {
             // copy construct value, engaged if we are since we just copied that value
             construct(copy.value());
         }
     }
 
-    optional(optional&& move) noexcept(std::is_nothrow_move_constructible_v<T>)
-        : m_engaged(false) // will be true upon `construct` being called below (if move is engaged)
+    optional(optional&&) requires(optional_impl::trivially_move_constructible<T>) = default;
+    constexpr optional(optional&& move) noexcept(std::is_nothrow_move_constructible_v<T>)
     {
-        if (move.m_engaged) {
+        if (move.engaged()) {
             // move construct value, engaged if we are since we just copied that value
             construct(std::move(move).value());
         }
     }
 
-    ~optional() noexcept(std::is_nothrow_destructible_v<T>)
+    ~optional() requires(optional_impl::trivially_destructible<T>) = default;
+    constexpr ~optional() noexcept(std::is_nothrow_destructible_v<T>)
     {
         destroy();
     }
 
-    auto operator=(const optional& copy) noexcept(std::is_nothrow_copy_assignable_v<T>) -> optional&
+    auto operator=(const optional&) -> optional& requires(optional_impl::trivially_copy_assignable<T>) = default;
+    constexpr auto operator=(const optional& copy) noexcept(std::is_nothrow_copy_assignable_v<T>) -> optional&
     {
         if (&copy != this) {
-            if (copy.m_engaged) {
-                construct(copy.value());
+            if (copy.engaged()) {
+                assign(copy.value());
             } else {
                 // destroy a value if we have one
                 destroy();
@@ -107,11 +300,12 @@ public:
         return *this;
     }
 
-    auto operator=(optional&& move) noexcept(std::is_nothrow_move_assignable_v<T>) -> optional&
+    auto operator=(optional&&) -> optional& requires(optional_impl::trivially_move_assignable<T>) = default;
+    constexpr auto operator=(optional&& move) noexcept(std::is_nothrow_move_assignable_v<T>) -> optional&
     {
         if (&move != this) {
-            if (move.m_engaged) {
-                construct(std::move(move).value());
+            if (move.engaged()) {
+                assign(std::move(move).value());
             } else {
                 // destroy a value if we have one
                 destroy();
@@ -121,41 +315,41 @@ public:
         return *this;
     }
 
-    auto operator=(T new_value) noexcept(std::is_nothrow_move_assignable_v<T>) -> optional&
+    constexpr auto operator=(T new_value) noexcept(std::is_nothrow_move_assignable_v<T>) -> optional&
     {
-        construct(std::move(new_value));
+        assign(std::move(new_value));
 
         return *this;
     }
 
-    auto operator=(std::nullopt_t) noexcept(std::is_nothrow_destructible_v<T>) -> optional&
+    constexpr auto operator=(std::nullopt_t) noexcept(std::is_nothrow_destructible_v<T>) -> optional&
     {
         destroy();
 
         return *this;
     }
 
-    auto operator&&(bool condition) & noexcept -> optional<T&>
+    constexpr auto operator&&(bool condition) & noexcept -> optional<T&>
     {
-        if (m_engaged && condition) {
+        if (engaged() && condition) {
             return optional<T&> { value() };
         } else {
             return std::nullopt;
         }
     }
 
-    auto operator&&(bool condition) const& noexcept -> optional<const T&>
+    constexpr auto operator&&(bool condition) const& noexcept -> optional<const T&>
     {
-        if (m_engaged && condition) {
+        if (engaged() && condition) {
             return optional<const T&> { value() };
         } else {
             return std::nullopt;
         }
     }
 
-    auto operator&&(bool condition) && noexcept(std::is_nothrow_move_constructible_v<T>) -> optional<T>
+    constexpr auto operator&&(bool condition) && noexcept(std::is_nothrow_move_constructible_v<T>) -> optional<T>
     {
-        if (m_engaged && condition) {
+        if (engaged() && condition) {
             return optional<T> { std::move(*this).value() };
         } else {
             return std::nullopt;
@@ -163,20 +357,20 @@ public:
     }
 
    template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) &
+    constexpr decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) &
     {
         static_assert(impl::invocable<Functor&&, T&, AdditionalArgs&&...>, "if_set functor must be invocable with T&");
 
         if constexpr (impl::invocable_and_returns_something<Functor&&, T&, AdditionalArgs&&...>) {
             return [&]() -> optional<std::invoke_result_t<Functor&&, T&, AdditionalArgs&&...>> {
-                if (m_engaged) {
+                if (engaged()) {
                     return std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
                 }
 
                 return std::nullopt;
             }();
         } else {
-            if (m_engaged) {
+            if (engaged()) {
                 std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
             }
 
@@ -185,20 +379,20 @@ public:
     }
 
    template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) const&
+    constexpr decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) const&
     {
         static_assert(impl::invocable<Functor&&, const T&, AdditionalArgs&&...>, "if_set functor on const optional must be invocable with const T&");
 
         if constexpr (impl::invocable_and_returns_something<Functor&&, const T&, AdditionalArgs&&...>) {
             return [&]() -> optional<std::invoke_result_t<Functor&&, const T&, AdditionalArgs&&...>> {
-                if (m_engaged) {
+                if (engaged()) {
                     return std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
                 }
 
                 return std::nullopt;
             }();
         } else {
-            if (m_engaged) {
+            if (engaged()) {
                 std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
             }
 
@@ -207,20 +401,20 @@ public:
     }
 
     template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) &&
+    constexpr decltype(auto) if_set(Functor&& f, AdditionalArgs&&... additional_args) &&
     {
         static_assert(impl::invocable<Functor&&, T&&, AdditionalArgs&&...>, "if_set functor on r-value optional must be invocable with T&&");
 
         if constexpr (impl::invocable_and_returns_something<Functor&&, T&&, AdditionalArgs&&...>) {
             return [&]() -> optional<std::invoke_result_t<Functor&&, T&&, AdditionalArgs&&...>> {
-                if (m_engaged) {
+                if (engaged()) {
                     return std::forward<Functor>(f)(std::move(*this).value(), std::forward<AdditionalArgs>(additional_args)...);
                 }
 
                 return std::nullopt;
             }();
         } else {
-            if (m_engaged) {
+            if (engaged()) {
                 std::forward<Functor>(f)(std::move(*this).value(), std::forward<AdditionalArgs>(additional_args)...);
             }
 
@@ -230,9 +424,9 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns<Functor&&, T, AdditionalArgs&&...>)
-    auto value_or(Functor&& f, AdditionalArgs&&... additional_args) & -> T
+    constexpr auto value_or(Functor&& f, AdditionalArgs&&... additional_args) & -> T
     {
-        if (m_engaged) {
+        if (engaged()) {
             return value();
         } else {
             return std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
@@ -241,9 +435,9 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns<Functor&&, T, AdditionalArgs&&...>)
-    auto value_or(Functor&& f, AdditionalArgs&&... additional_args) const& -> T
+    constexpr auto value_or(Functor&& f, AdditionalArgs&&... additional_args) const& -> T
     {
-        if (m_engaged) {
+        if (engaged()) {
             return value();
         } else {
             return std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
@@ -252,9 +446,9 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns<Functor&&, T, AdditionalArgs&&...>)
-    auto value_or(Functor&& f, AdditionalArgs&&... additional_args) && -> T
+    constexpr auto value_or(Functor&& f, AdditionalArgs&&... additional_args) && -> T
     {
-        if (m_engaged) {
+        if (engaged()) {
             return std::move(*this).value();
         } else {
             return std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
@@ -263,10 +457,10 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns_something<Functor&&, AdditionalArgs&&...>)
-    auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) const -> optional<std::invoke_result_t<Functor&&, AdditionalArgs&&...>>
+    constexpr auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) const -> optional<std::invoke_result_t<Functor&&, AdditionalArgs&&...>>
     {
-        // const overload only, as we only ever inspect `m_engaged`
-        if (m_engaged) {
+        // const overload only, as we only ever inspect whether we're engaged
+        if (engaged()) {
             return std::nullopt;
         } else {
             return std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
@@ -275,10 +469,10 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns_nothing<Functor&&, AdditionalArgs&&...>)
-    auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) & -> optional&
+    constexpr auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) & -> optional&
     {
-        // const overload only, as we only ever inspect `m_engaged`
-        if (!m_engaged) {
+        // const overload only, as we only ever inspect whether we're engaged
+        if (!engaged()) {
             std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
         }
 
@@ -287,10 +481,10 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns_nothing<Functor&&, AdditionalArgs&&...>)
-    auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) const& -> const optional&
+    constexpr auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) const& -> const optional&
     {
-        // const overload only, as we only ever inspect `m_engaged`
-        if (!m_engaged) {
+        // const overload only, as we only ever inspect whether we're engaged
+        if (!engaged()) {
             std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
         }
 
@@ -299,10 +493,10 @@ public:
 
     template <typename Functor, typename... AdditionalArgs>
     requires(impl::invocable_and_returns_nothing<Functor&&, AdditionalArgs&&...>)
-    auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) && -> optional
+    constexpr auto if_unset(Functor&& f, AdditionalArgs&&... additional_args) && -> optional
     {
-        // const overload only, as we only ever inspect `m_engaged`
-        if (!m_engaged) {
+        // const overload only, as we only ever inspect whether we're engaged
+        if (!engaged()) {
             std::forward<Functor>(f)(std::forward<AdditionalArgs>(additional_args)...);
         }
 
@@ -310,12 +504,12 @@ public:
     }
 
     template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) &
+    constexpr decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) &
     {
         static_assert(optional_impl::invocable_and_returns_optional<Functor&&, T&, AdditionalArgs&&...>, "and_then functor on optional must return an optional");
 
         return [&]() -> std::invoke_result_t<Functor&&, T&, AdditionalArgs&&...> {
-            if (m_engaged) {
+            if (engaged()) {
                 return std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
             } else {
                 return std::nullopt;
@@ -324,12 +518,12 @@ public:
     }
 
     template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) const&
+    constexpr decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) const&
     {
         static_assert(optional_impl::invocable_and_returns_optional<Functor&&, const T&, AdditionalArgs&&...>, "and_then functor on optional must return an optional");
 
         return [&]() -> std::invoke_result_t<Functor&&, const T&, AdditionalArgs&&...> {
-            if (m_engaged) {
+            if (engaged()) {
                 return std::forward<Functor>(f)(value(), std::forward<AdditionalArgs>(additional_args)...);
             } else {
                 return std::nullopt;
@@ -338,12 +532,12 @@ public:
     }
 
     template <typename Functor, typename... AdditionalArgs>
-    decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) &&
+    constexpr decltype(auto) and_then(Functor&& f, AdditionalArgs&&... additional_args) &&
     {
         static_assert(optional_impl::invocable_and_returns_optional<Functor&&, T&&, AdditionalArgs&&...>, "and_then functor on optional must return an optional");
 
         return [&]() -> std::invoke_result_t<Functor&&, T&&, AdditionalArgs&&...> {
-            if (m_engaged) {
+            if (engaged()) {
                 return std::forward<Functor>(f)(std::move(*this).value(), std::forward<AdditionalArgs>(additional_args)...);
             } else {
                 return std::nullopt;
@@ -352,22 +546,22 @@ public:
     }
 
     template <typename... Args>
-    auto emplace(Args&&... args) -> T&
+    constexpr auto emplace(Args&&... args) -> T&
     {
         return construct(std::forward<Args>(args)...);
     }
 
     template <impl::invocable_and_returns<T> Functor>
-    auto emplace_if_empty(Functor&& f) -> T&
+    constexpr auto emplace_if_empty(Functor&& f) -> T&
     {
-        if (m_engaged) {
+        if (engaged()) {
             return value();
         } else {
             return construct(std::forward<Functor>(f)());
         }
     }
 
-    auto collapse() && -> optional<typename optional_impl::innermost_type<T>::type>
+    constexpr auto collapse() && -> optional<typename optional_impl::innermost_type<T>::type>
     {
         if constexpr (optional_impl::is_optional<T>::value) {
             return std::move(*this).if_set([&](auto&& value) -> optional<typename optional_impl::innermost_type<T>::type> {
@@ -379,78 +573,267 @@ public:
         }
     }
 
-    auto empty() const -> bool
+    constexpr auto empty() const -> bool
+    {
+        return !engaged();
+    }
+
+    // a lazy alternative to chaining `if_set` and `and_then`, see `optional_pipeline`. The pipeline refers to this
+    // optional, so should be evaluated in the expression that builds it
+    constexpr auto pipe() & -> optional_pipeline<optional&>
     {
-        return !m_engaged;
+        return optional_pipeline<optional&> { *this };
+    }
+
+    constexpr auto pipe() const& -> optional_pipeline<const optional&>
+    {
+        return optional_pipeline<const optional&> { *this };
+    }
+
+    constexpr auto pipe() && -> optional_pipeline<optional&&>
+    {
+        return optional_pipeline<optional&&> { std::move(*this) };
     }
 
 private:
-    // store references as pointers
+    template <typename Source, typename... Stages>
+    friend class optional_pipeline;
+
     static constexpr auto is_reference = std::is_reference<T>::value;
-    using storage_type = std::conditional<is_reference, std::add_pointer_t<std::remove_reference_t<T>>, T>::type;
 
-    auto value() & -> T&
+    constexpr auto engaged() const noexcept -> bool
     {
-        if constexpr (is_reference) {
-            // stored as pointer, double deref
-            return **reinterpret_cast<storage_type*>(m_buffer);
-        } else {
-            return *reinterpret_cast<storage_type*>(m_buffer);
-        }
+        return m_storage.engaged();
+    }
+
+    constexpr auto value() & -> T&
+    {
+        return m_storage.get();
     }
-    auto value() const& -> const T&
+    constexpr auto value() const& -> const T&
     {
-        if constexpr (is_reference) {
-            // stored as pointer, double deref
-            return **reinterpret_cast<const storage_type*>(m_buffer);
-        } else {
-            return *reinterpret_cast<const storage_type*>(m_buffer);
-        }
+        return m_storage.get();
     }
-    auto value() && -> T
+    constexpr auto value() && -> T
     {
         if constexpr (is_reference) {
-            // stored as pointer, double deref (no need to move a reference)
-            return **reinterpret_cast<storage_type*>(m_buffer);
+            // no need to move a reference
+            return m_storage.get();
         } else {
-            return std::move(*reinterpret_cast<storage_type*>(m_buffer));
+            return std::move(m_storage.get());
         }
     }
     template <typename... Args>
-    auto construct(Args&&... args) -> T&
+    constexpr auto construct(Args&&... args) -> T&
     {
-        if (m_engaged) {
-            destroy();
-        }
+        destroy();
 
-        m_engaged = true;
+        return m_storage.construct(std::forward<Args>(args)...);
+    }
+    // assigns in place if we already hold a value (and `T` supports it), references are always rebound rather than
+    // assigned through
+    template <typename Value>
+    constexpr auto assign(Value&& value) -> void
+    {
+        if constexpr (!is_reference && std::is_assignable_v<T&, Value&&>) {
+            if (engaged()) {
+                m_storage.get() = std::forward<Value>(value);
+                return;
+            }
+        }
 
-        if constexpr (is_reference) {
-            // stored as pointer, double deref (no need to forward args, should always be 1 arg which is a reference)
-            return **(new (m_buffer) storage_type(std::addressof(args)...));
-        } else {
-            return *(new (m_buffer) storage_type(std::forward<Args>(args)...));
+        construct(std::forward<Value>(value));
+    }
+    constexpr auto destroy() -> void
+    {
+        if (engaged()) {
+            m_storage.destroy();
         }
     }
-    auto destroy() -> void
+
+    optional_impl::storage_for<T> m_storage;
+};
+
+namespace optional_impl {
+    template <typename Functor>
+    struct if_set_stage {
+        Functor m_functor;
+    };
+
+    template <typename Functor>
+    struct and_then_stage {
+        Functor m_functor;
+    };
+
+    template <typename Functor>
+    struct value_or_stage {
+        Functor m_functor;
+    };
+
+    template <typename T>
+    struct is_and_then_stage : std::false_type {
+    };
+
+    template <typename Functor>
+    struct is_and_then_stage<and_then_stage<Functor>> : std::true_type {
+    };
+
+    template <typename T>
+    struct is_pipeline_stage : std::false_type {
+    };
+
+    template <typename Functor>
+    struct is_pipeline_stage<if_set_stage<Functor>> : std::true_type {
+    };
+
+    template <typename Functor>
+    struct is_pipeline_stage<and_then_stage<Functor>> : std::true_type {
+    };
+
+    // the value type of the optional an eager chain would have produced after each stage, and the argument the next
+    // stage's functor is called with in its place
+    template <typename ValueType, typename Argument, typename... Stages>
+    struct pipeline_types {
+        using value_type = ValueType;
+        using argument_type = Argument;
+    };
+
+    template <bool ReturnsNothing, typename ValueType, typename Argument, typename Functor, typename... Stages>
+    struct if_set_types : pipeline_types<ValueType, Argument, Stages...> {
+    };
+
+    template <typename ValueType, typename Argument, typename Functor, typename... Stages>
+    struct if_set_types<false, ValueType, Argument, Functor, Stages...>
+        : pipeline_types<std::invoke_result_t<Functor&&, Argument>, std::invoke_result_t<Functor&&, Argument>&&, Stages...> {
+    };
+
+    template <typename ValueType, typename Argument, typename Functor, typename... Stages>
+    struct pipeline_types<ValueType, Argument, if_set_stage<Functor>, Stages...>
+        : if_set_types<impl::invocable_and_returns_nothing<Functor&&, Argument>, ValueType, Argument, Functor, Stages...> {
+    };
+
+    template <typename ValueType, typename Argument, typename Functor, typename... Stages>
+    struct pipeline_types<ValueType, Argument, and_then_stage<Functor>, Stages...>
+        : pipeline_types<typename std::invoke_result_t<Functor&&, Argument>::value_type, typename std::invoke_result_t<Functor&&, Argument>::value_type&&, Stages...> {
+    };
+}
+
+// `safet::if_set` and `safet::and_then` stages, ended with `safet::value_or` or `evaluate()`
+template <typename Functor>
+constexpr auto if_set(Functor&& f) -> optional_impl::if_set_stage<std::decay_t<Functor>>
+{
+    return { std::forward<Functor>(f) };
+}
+
+template <typename Functor>
+constexpr auto and_then(Functor&& f) -> optional_impl::and_then_stage<std::decay_t<Functor>>
+{
+    return { std::forward<Functor>(f) };
+}
+
+template <typename Functor>
+constexpr auto value_or(Functor&& f) -> optional_impl::value_or_stage<std::decay_t<Functor>>
+{
+    return { std::forward<Functor>(f) };
+}
+
+// `x.pipe() | if_set(f) | and_then(g) | value_or(h)` has the result of `x.if_set(f).and_then(g).value_or(h)`, but
+// composes the functors first and then evaluates them in one pass. Each value is handed straight to the next functor
+// rather than through an intermediate optional, so `x` is checked once and only the optionals `and_then` functors
+// return are checked after that. A pipeline is consumed by its evaluation
+template <typename Source, typename... Stages>
+class optional_pipeline {
+    using optional_type = std::remove_cvref_t<Source>;
+    using source_value_type = typename optional_type::value_type;
+    using source_argument_type = std::conditional_t<std::is_lvalue_reference_v<Source>,
+        std::conditional_t<std::is_const_v<std::remove_reference_t<Source>>, const source_value_type&, source_value_type&>,
+        source_value_type&&>;
+    using types = optional_impl::pipeline_types<source_value_type, source_argument_type, Stages...>;
+
+public:
+    using value_type = typename types::value_type;
+
+    constexpr explicit optional_pipeline(Source source)
+        : m_source(static_cast<Source>(source))
+    {
+    }
+
+    constexpr optional_pipeline(Source source, std::tuple<Stages...> stages)
+        : m_source(static_cast<Source>(source))
+        , m_stages(std::move(stages))
     {
-        if (m_engaged) {
-            // no need to destroy a reference
-            if constexpr (!is_reference) {
-                std::destroy_at(&value());
-            }
+    }
 
-            m_engaged = false;
+    // the final value, as an optional
+    constexpr auto evaluate() && -> optional<value_type>
+    {
+        return std::move(*this).template run_source<optional<value_type>>(
+            [](auto&& value) -> optional<value_type> { return optional<value_type> { std::forward<decltype(value)>(value) }; },
+            []() -> optional<value_type> { return std::nullopt; });
+    }
+
+    template <typename Stage>
+    requires(optional_impl::is_pipeline_stage<Stage>::value)
+    friend constexpr auto operator|(optional_pipeline&& pipeline, Stage stage) -> optional_pipeline<Source, Stages..., Stage>
+    {
+        return { static_cast<Source>(pipeline.m_source), std::tuple_cat(std::move(pipeline.m_stages), std::tuple<Stage> { std::move(stage) }) };
+    }
+
+    template <typename Functor>
+    friend constexpr auto operator|(optional_pipeline&& pipeline, optional_impl::value_or_stage<Functor> stage) -> value_type
+    {
+        static_assert(impl::invocable_and_returns<Functor&&, value_type>, "value_or functor must return the pipeline's value type");
+
+        return std::move(pipeline).template run_source<value_type>(
+            [](auto&& value) -> value_type { return std::forward<decltype(value)>(value); },
+            [&]() -> value_type { return std::move(stage.m_functor)(); });
+    }
+
+private:
+    template <typename Result, typename Finish, typename Empty>
+    constexpr auto run_source(Finish&& finish, Empty&& empty) && -> Result
+    {
+        if (m_source.engaged()) {
+            return run<Result, 0>(static_cast<source_argument_type>(m_source.value()), finish, empty);
         }
+
+        return empty();
     }
 
-    bool m_engaged { false };
-    uint8_t m_buffer[sizeof(storage_type)];
+    template <typename Result, size_t I, typename Argument, typename Finish, typename Empty>
+    constexpr auto run(Argument&& argument, Finish& finish, Empty& empty) -> Result
+    {
+        if constexpr (I == sizeof...(Stages)) {
+            return finish(std::forward<Argument>(argument));
+        } else {
+            using functor_type = decltype(std::get<I>(m_stages).m_functor);
+            auto&& functor = std::move(std::get<I>(m_stages).m_functor);
+
+            if constexpr (optional_impl::is_and_then_stage<std::tuple_element_t<I, std::tuple<Stages...>>>::value) {
+                static_assert(optional_impl::invocable_and_returns_optional<functor_type&&, Argument&&>, "and_then functor on optional must return an optional");
+
+                auto result = std::move(functor)(std::forward<Argument>(argument));
+                if (result.engaged()) {
+                    return run<Result, I + 1>(static_cast<typename decltype(result)::value_type&&>(result.value()), finish, empty);
+                }
+
+                return empty();
+            } else if constexpr (impl::invocable_and_returns_nothing<functor_type&&, Argument&&>) {
+                std::move(functor)(std::forward<Argument>(argument));
+
+                return run<Result, I + 1>(std::forward<Argument>(argument), finish, empty);
+            } else {
+                return run<Result, I + 1>(std::move(functor)(std::forward<Argument>(argument)), finish, empty);
+            }
+        }
+    }
 
+    Source m_source;
+    std::tuple<Stages...> m_stages;
 };
 
 template <typename T>
-auto operator<=>(const optional<T>& lhs, const optional<T>& rhs) -> std::compare_three_way_result_t<T>
+constexpr auto operator<=>(const optional<T>& lhs, const optional<T>& rhs) -> std::compare_three_way_result_t<T>
 {
     return lhs.and_then([&](const T& lhs_value) {
                   return rhs.if_set([&](const T& rhs_value) {
@@ -463,7 +846,7 @@ auto operator<=>(const optional<T>& lhs, const optional<T>& rhs) -> std::compare
 }
 
 template <typename T>
-auto operator==(const optional<T>& lhs, const optional<T>& rhs) -> bool
+constexpr auto operator==(const optional<T>& lhs, const optional<T>& rhs) -> bool
 {
     return lhs.and_then([&](const T& lhs_value) {
                   return rhs.if_set([&](const T& rhs_value) {
@@ -478,7 +861,7 @@ auto operator==(const optional<T>& lhs, const optional<T>& rhs) -> bool
 }
 
 template <typename T, optional_impl::three_way_comparable_with_optional<T> U>
-auto operator<=>(const optional<T>& lhs, const U& rhs) -> std::compare_three_way_result_t<T, U>
+constexpr auto operator<=>(const optional<T>& lhs, const U& rhs) -> std::compare_three_way_result_t<T, U>
 {
     return lhs.if_set([&](const T& lhs_value) -> std::compare_three_way_result_t<T, U> {
                   return lhs_value <=> rhs;
@@ -487,7 +870,7 @@ auto operator<=>(const optional<T>& lhs, const U& rhs) -> std::compare_three_way
 }
 
 template <typename T, optional_impl::equality_comparable_with_optional<T> U>
-auto operator==(const optional<T>& lhs, const U& rhs) -> bool
+constexpr auto operator==(const optional<T>& lhs, const U& rhs) -> bool
 {
     return lhs.if_set([&](const T& lhs_value) {
                   return lhs_value == rhs;
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <safet/finally.hpp>
+#include <safet/impl/concepts.hpp>
+#include <safet/optional.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace safet {
+// a sequence of optionals, storing the values contiguously with no flag next to each, and whether each is set in a
+// separate bitmap. Counting the set values is a popcount per 64 elements, and `visit_all` skips empty elements a word
+// of the bitmap at a time rather than testing each one. Empty elements leave their value's storage unconstructed
+template <typename T>
+class optional_vector {
+public:
+    static_assert(!std::is_reference_v<T>, "optional_vector values must not be references");
+
+    optional_vector() = default;
+
+    // delegates so a throwing copy is cleaned up by the destructor, which only sees the values marked as copied so far
+    optional_vector(const optional_vector& copy)
+        : optional_vector()
+    {
+        reserve(copy.m_size);
+        m_engaged.resize(copy.m_engaged.size());
+        copy.for_each_engaged([&](size_t position) {
+            std::construct_at(m_values + position, copy.m_values[position]);
+            m_engaged[position / word_bits] |= bit(position);
+        });
+        m_size = copy.m_size;
+    }
+
+    optional_vector(optional_vector&& move) noexcept
+        : m_values(std::exchange(move.m_values, nullptr))
+        , m_size(std::exchange(move.m_size, 0))
+        , m_capacity(std::exchange(move.m_capacity, 0))
+        , m_engaged(std::move(move.m_engaged))
+    {
+        move.m_engaged.clear();
+    }
+
+    ~optional_vector()
+    {
+        clear();
+        deallocate(m_values, m_capacity);
+    }
+
+    auto operator=(const optional_vector& copy) -> optional_vector&
+    {
+        if (this != &copy) {
+            optional_vector { copy }.swap(*this);
+        }
+
+        return *this;
+    }
+
+    auto operator=(optional_vector&& move) noexcept -> optional_vector&
+    {
+        optional_vector { std::move(move) }.swap(*this);
+
+        return *this;
+    }
+
+    auto swap(optional_vector& other) noexcept -> void
+    {
+        std::swap(m_values, other.m_values);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+        m_engaged.swap(other.m_engaged);
+    }
+
+    template <typename... Params>
+    auto emplace_back(Params&&... params) -> T&
+    {
+        if (m_size == m_capacity) {
+            // `params` may refer to a value in the storage growing frees (e.g. `v.emplace_back(*v.get(0))`), so as
+            // `std::vector` does the new value is built first
+            T value(std::forward<Params>(params)...);
+            grow_for_one();
+
+            return construct_back(std::move(value));
+        }
+
+        grow_for_one();
+        return construct_back(std::forward<Params>(params)...);
+    }
+
+    auto push_back(T value) -> void
+    {
+        emplace_back(std::move(value));
+    }
+
+    auto push_back(std::nullopt_t) -> void
+    {
+        grow_for_one();
+        push_bit(false);
+    }
+
+    auto push_back(const optional<T>& value) -> void
+    {
+        if (value.empty()) {
+            push_back(std::nullopt);
+        } else {
+            value.if_set([&](const T& set) { emplace_back(set); });
+        }
+    }
+
+    // empty for positions past the end, as for those that aren't set
+    auto get(size_t position) -> optional<T&>
+    {
+        if (engaged(position)) {
+            return m_values[position];
+        }
+
+        return std::nullopt;
+    }
+
+    auto get(size_t position) const -> optional<const T&>
+    {
+        if (engaged(position)) {
+            return m_values[position];
+        }
+
+        return std::nullopt;
+    }
+
+    // replaces any value at `position`, which must be less than `size()`
+    template <typename... Params>
+    auto emplace(size_t position, Params&&... params) -> T&
+    {
+        if (engaged(position)) {
+            // `params` may refer to the value being replaced, so it's only destroyed once the new one is built
+            T replacement(std::forward<Params>(params)...);
+            reset(position);
+            return construct_in(position, std::move(replacement));
+        }
+
+        return construct_in(position, std::forward<Params>(params)...);
+    }
+
+    auto reset(size_t position) -> void
+    {
+        if (engaged(position)) {
+            std::destroy_at(m_values + position);
+            m_engaged[position / word_bits] &= ~bit(position);
+        }
+    }
+
+    // every element, set or not
+    auto size() const noexcept -> size_t
+    {
+        return m_size;
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return m_size == 0;
+    }
+
+    // only the elements that are set
+    auto count() const noexcept -> size_t
+    {
+        size_t total { 0 };
+        for (const auto word : m_engaged) {
+            total += static_cast<size_t>(std::popcount(word));
+        }
+
+        return total;
+    }
+
+    auto reserve(size_t capacity) -> void
+    {
+        if (capacity > m_capacity) {
+            reallocate(capacity);
+        }
+        m_engaged.reserve((capacity + word_bits - 1) / word_bits);
+    }
+
+    auto clear() noexcept -> void
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for_each_engaged([&](size_t position) { std::destroy_at(m_values + position); });
+        }
+
+        m_engaged.clear();
+        m_size = 0;
+    }
+
+    // calls `v` with every set value in order, skipping empty elements
+    template <typename Visitor>
+    auto visit_all(Visitor&& v) -> void
+    {
+        static_assert(impl::invocable<Visitor&, T&>, "visitor must be invocable with T&");
+
+        for_each_engaged([&](size_t position) { v(m_values[position]); });
+    }
+    template <typename Visitor>
+    auto visit_all(Visitor&& v) const -> void
+    {
+        static_assert(impl::invocable<Visitor&, const T&>, "visitor must be invocable with const T&");
+
+        for_each_engaged([&](size_t position) { v(std::as_const(m_values[position])); });
+    }
+
+private:
+    using word_type = uint64_t;
+    static constexpr size_t word_bits = 64;
+
+    static constexpr auto bit(size_t position) noexcept -> word_type
+    {
+        return word_type { 1 } << (position % word_bits);
+    }
+
+    auto engaged(size_t position) const noexcept -> bool
+    {
+        return position < m_size && (m_engaged[position / word_bits] & bit(position)) != 0;
+    }
+
+    template <typename... Params>
+    auto construct_back(Params&&... params) -> T&
+    {
+        auto& value = *std::construct_at(m_values + m_size, std::forward<Params>(params)...);
+        push_bit(true);
+
+        return value;
+    }
+
+    // `position` must not be set
+    template <typename... Params>
+    auto construct_in(size_t position, Params&&... params) -> T&
+    {
+        auto& value = *std::construct_at(m_values + position, std::forward<Params>(params)...);
+        m_engaged[position / word_bits] |= bit(position);
+
+        return value;
+    }
+
+    // clears each word's lowest set bit in turn, so the cost follows the number of set elements rather than the size
+    template <typename Functor>
+    auto for_each_engaged(Functor&& f) const -> void
+    {
+        for (size_t word = 0; word < m_engaged.size(); ++word) {
+            for (auto bits = m_engaged[word]; bits != 0; bits &= bits - 1) {
+                f(word * word_bits + static_cast<size_t>(std::countr_zero(bits)));
+            }
+        }
+    }
+
+    // grows before anything is constructed, so a throwing value leaves the vector as it was
+    auto grow_for_one() -> void
+    {
+        if (m_size == m_capacity) {
+            reallocate(std::max<size_t>(m_capacity * 2, word_bits));
+        }
+        if (m_size % word_bits == 0 && m_engaged.size() == m_engaged.capacity()) {
+            m_engaged.reserve(std::max<size_t>(m_engaged.capacity() * 2, 1));
+        }
+    }
+
+    auto push_bit(bool set) noexcept -> void
+    {
+        if (m_size % word_bits == 0) {
+            // reserved by grow_for_one
+            m_engaged.push_back(0);
+        }
+        if (set) {
+            m_engaged.back() |= bit(m_size);
+        }
+        ++m_size;
+    }
+
+    // set values are moved if that can't throw, and copied otherwise so a throw leaves the original intact
+    auto reallocate(size_t capacity) -> void
+    {
+        auto* values = std::allocator<T> {}.allocate(capacity);
+        size_t constructed { 0 };
+        scope_fail undo { [&]() {
+            for_each_engaged([&](size_t position) {
+                if (position < constructed) {
+                    std::destroy_at(values + position);
+                }
+            });
+            deallocate(values, capacity);
+        } };
+
+        for_each_engaged([&](size_t position) {
+            std::construct_at(values + position, std::move_if_noexcept(m_values[position]));
+            constructed = position + 1;
+        });
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for_each_engaged([&](size_t position) { std::destroy_at(m_values + position); });
+        }
+        deallocate(m_values, m_capacity);
+
+        m_values = values;
+        m_capacity = capacity;
+    }
+
+    static auto deallocate(T* values, size_t capacity) noexcept -> void
+    {
+        if (values != nullptr) {
+            std::allocator<T> {}.deallocate(values, capacity);
+        }
+    }
+
+    T* m_values { nullptr };
+    size_t m_size { 0 };
+    size_t m_capacity { 0 };
+    std::vector<word_type> m_engaged;
+};
+}
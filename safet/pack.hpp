@@ -1,9 +1,24 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
+#if defined(__has_builtin)
+#if __has_builtin(__type_pack_element)
+#define SAFET_PACK_HAS_TYPE_PACK_ELEMENT
+#endif
+#if __has_builtin(__is_same)
+#define SAFET_PACK_IS_SAME(L, R) __is_same(L, R)
+#endif
+#endif
+
+#if !defined(SAFET_PACK_IS_SAME)
+#define SAFET_PACK_IS_SAME(L, R) std::is_same_v<L, R>
+#endif
+
 namespace safet {
 
 // predeclare - some impl items need this declaration
@@ -21,6 +36,111 @@ namespace pack_impl {
         using type = DestinationType<SourceArgs...>;
     };
 
+    // the Ith type of a pack in constant instantiation depth, by the builtin where the compiler has one, otherwise by
+    // letting overload resolution pick the one indexed base matching I
+#if defined(SAFET_PACK_HAS_TYPE_PACK_ELEMENT)
+    template <size_t I, typename... Types>
+    using element_t = __type_pack_element<I, Types...>;
+#else
+    template <size_t I, typename T>
+    struct indexed {
+        using type = T;
+    };
+
+    template <typename Sequence, typename... Types>
+    struct indexer;
+
+    template <size_t... Is, typename... Types>
+    struct indexer<std::index_sequence<Is...>, Types...> : indexed<Is, Types>... {
+    };
+
+    template <size_t I, typename T>
+    auto select_indexed(const indexed<I, T>*) -> indexed<I, T>;
+
+    template <size_t I, typename... Types>
+    using element_t = typename decltype(select_indexed<I>(static_cast<indexer<std::index_sequence_for<Types...>, Types...>*>(nullptr)))::type;
+#endif
+
+    // joins packs eight at a time, so even hundreds of them only recurse a few dozen deep
+    template <typename... Packs>
+    struct concat_helper {
+        using type = pack<>;
+    };
+
+    template <typename... As>
+    struct concat_helper<pack<As...>> {
+        using type = pack<As...>;
+    };
+
+    template <typename... As, typename... Bs, typename... Rest>
+    struct concat_helper<pack<As...>, pack<Bs...>, Rest...> {
+        using type = typename concat_helper<pack<As..., Bs...>, Rest...>::type;
+    };
+
+    template <typename... As, typename... Bs, typename... Cs, typename... Ds, typename... Es, typename... Fs, typename... Gs,
+        typename... Hs, typename... Rest>
+    struct concat_helper<pack<As...>, pack<Bs...>, pack<Cs...>, pack<Ds...>, pack<Es...>, pack<Fs...>, pack<Gs...>, pack<Hs...>,
+        Rest...> {
+        using type = typename concat_helper<pack<As..., Bs..., Cs..., Ds..., Es..., Fs..., Gs..., Hs...>, Rest...>::type;
+    };
+
+    // the types whose flag is set, in order. Every type is wrapped alongside its flag in one expansion rather than looked
+    // up by index, which would cost a search of the whole pack per kept type
+    template <typename Flags, typename... Types>
+    struct keep_helper;
+
+    template <bool... Keep, typename... Types>
+    struct keep_helper<std::integer_sequence<bool, Keep...>, Types...> {
+        using type = typename concat_helper<std::conditional_t<Keep, pack<Types>, pack<>>...>::type;
+    };
+
+    template <typename Flags, typename... Types>
+    using keep_t = typename keep_helper<Flags, Types...>::type;
+
+    template <size_t Offset, size_t Count, typename Sequence>
+    struct range_flags;
+
+    template <size_t Offset, size_t Count, size_t... Is>
+    struct range_flags<Offset, Count, std::index_sequence<Is...>> {
+        using type = std::integer_sequence<bool, (Is >= Offset && Is - Offset < Count)...>;
+    };
+
+    // the compiler's builtin, where there is one, compares types without instantiating an is_same for every pair. Types are
+    // never compared by the address of a per-type tag, as gcc's `-fsanitize=null` stops address comparisons from being
+    // constant expressions
+    template <typename NeedleType, typename... HaystackTypes>
+    inline constexpr bool matches[sizeof...(HaystackTypes) + 1] { SAFET_PACK_IS_SAME(NeedleType, HaystackTypes)..., false };
+
+    template <typename NeedleType, typename... HaystackTypes>
+    constexpr auto first_index_of() -> size_t
+    {
+        constexpr auto& found = matches<NeedleType, HaystackTypes...>;
+        for (size_t i = 0; i < sizeof...(HaystackTypes); ++i) {
+            if (found[i]) {
+                return i;
+            }
+        }
+
+        return sizeof...(HaystackTypes);
+    }
+
+    // a plain array rather than std::array, subscripting it for every type of a pack mustn't cost a call each
+    template <size_t Size>
+    struct flag_array {
+        bool value[Size + 1] {};
+    };
+
+    template <typename... Types>
+    inline constexpr flag_array<sizeof...(Types)> first_occurrences = [] {
+        constexpr size_t firsts[] { first_index_of<Types, Types...>()..., 0 };
+        flag_array<sizeof...(Types)> result;
+        for (size_t i = 0; i < sizeof...(Types); ++i) {
+            result.value[i] = firsts[i] == i;
+        }
+
+        return result;
+    }();
+
     template <typename... Ts>
     struct first_helper {
         static_assert(sizeof...(Ts) > 0, "Cannot get the first type of an empty parameter pack");
@@ -31,19 +151,14 @@ namespace pack_impl {
         using type = T;
     };
 
-    template <typename... T>
+    template <typename... Ts>
     struct last_helper {
-        static_assert(sizeof...(T) > 0, "Cannot get the last type of an empty parameter pack");
+        static_assert(sizeof...(Ts) > 0, "Cannot get the last type of an empty parameter pack");
     };
 
-    template <typename T, typename T2, typename... Ts>
-    struct last_helper<T, T2, Ts...> {
-        using type = typename last_helper<T2, Ts...>::type;
-    };
-
-    template <typename T>
-    struct last_helper<T> {
-        using type = T;
+    template <typename T, typename... Ts>
+    struct last_helper<T, Ts...> {
+        using type = element_t<sizeof...(Ts), T, Ts...>;
     };
 
     template <size_t I, typename... Args>
@@ -51,95 +166,112 @@ namespace pack_impl {
         static_assert(I < sizeof...(Args), "Too few types in parameter pack to get the Ith type");
     };
 
-    template <typename Arg, typename... Args>
-    struct ith_helper<0, Arg, Args...> {
-        using type = Arg;
+    template <size_t I, typename... Args>
+        requires(I < sizeof...(Args))
+    struct ith_helper<I, Args...> {
+        using type = element_t<I, Args...>;
     };
 
-    template <size_t I, typename Arg, typename... Args>
-    struct ith_helper<I, Arg, Args...> {
-        using type = typename ith_helper<I - 1, Args...>::type;
-    };
+    template <typename NeedleType, typename... HaystackTypes>
+    constexpr auto count_of() -> size_t
+    {
+        size_t count = 0;
+        for (const bool found : matches<NeedleType, HaystackTypes...>) {
+            count += found ? 1 : 0;
+        }
 
-    template <typename NeedleType, size_t Count, typename... HaystackTypes>
-    struct count_of_helper : std::integral_constant<size_t, Count> {
-    };
+        return count;
+    }
 
-    template <typename NeedleType, size_t Count, typename HaystackFirstType, typename... HaystackTypes>
-    struct count_of_helper<NeedleType, Count, HaystackFirstType, HaystackTypes...>
-        : std::integral_constant<
-              size_t,
-              count_of_helper<
-                  NeedleType,
-                  Count + std::conditional_t<std::is_same<NeedleType, HaystackFirstType>::value, std::integral_constant<size_t, 1>, std::integral_constant<size_t, 0>>::value,
-                  HaystackTypes...>::value> {
-    };
+    template <typename NeedleType, typename... HaystackTypes>
+    using count_of_helper = std::integral_constant<size_t, count_of<NeedleType, HaystackTypes...>()>;
 
-    template <size_t NumToRemove, typename... Types>
-    struct remove_prefix_types {
-    };
+    template <typename NeedleType, typename... HaystackTypes>
+    using contains_helper = std::bool_constant<(first_index_of<NeedleType, HaystackTypes...>() < sizeof...(HaystackTypes))>;
 
-    template <size_t NumToRemove, typename FirstType, typename... Types>
-    struct remove_prefix_types<NumToRemove, FirstType, Types...> {
-        using type = typename remove_prefix_types<NumToRemove - 1, Types...>::type;
+    template <typename NeedleType, typename... HaystackTypes>
+    struct index_of_helper : std::integral_constant<size_t, first_index_of<NeedleType, HaystackTypes...>()> {
+        static_assert(index_of_helper::value < sizeof...(HaystackTypes), "Cannot get the index of a type the parameter pack does not contain");
     };
 
-    template <typename FirstType, typename... Types>
-    struct remove_prefix_types<0, FirstType, Types...> {
-        using type = pack<FirstType, Types...>;
-    };
+    // alone in a helper, so that none of its counting happens until a pack is actually compared. Equal sizes and equal counts
+    // of every left hand type leave no room for any other right hand type
+    template <typename LeftPack, typename RightPack>
+    struct equivalent_helper;
 
-    template <size_t NumToKeep, typename... Types>
-    struct remove_suffix_helper {
+    template <typename... LeftTypes, typename... RightTypes>
+    struct equivalent_helper<pack<LeftTypes...>, pack<RightTypes...>>
+        : std::bool_constant<sizeof...(LeftTypes) == sizeof...(RightTypes)
+              && ((count_of_helper<LeftTypes, LeftTypes...>::value == count_of_helper<LeftTypes, RightTypes...>::value) && ...)> {
     };
 
-    template <size_t NumToKeep, typename FirstType, typename... Types>
-    struct remove_suffix_helper<NumToKeep, FirstType, Types...> {
-        using type =
-            typename remove_suffix_helper<NumToKeep - 1, Types...>::type::template apply<pack<FirstType>::template append>;
-    };
+    template <size_t Offset, size_t Count, typename... Types>
+    struct subpack_helper {
+        static constexpr bool in_range = Offset <= sizeof...(Types) && Count <= sizeof...(Types) - Offset;
+        static_assert(in_range, "Too few types in parameter pack to take the requested range");
 
-    template <typename FirstType, typename... Types>
-    struct remove_suffix_helper<1, FirstType, Types...> {
-        using type = pack<FirstType>;
+        using type = keep_t<typename range_flags<Offset, in_range ? Count : 0, std::index_sequence_for<Types...>>::type, Types...>;
     };
 
-    template <size_t NumToremove, typename... Types>
-    struct remove_suffix_types {
-        using type = typename remove_suffix_helper<sizeof...(Types) - NumToremove, Types...>::type;
-    };
+    template <size_t NumToRemove, typename... Types>
+    using remove_prefix_types = subpack_helper<NumToRemove, sizeof...(Types) - NumToRemove, Types...>;
 
-    template <template <typename...> typename Filter, typename... Types>
+    template <size_t NumToRemove, typename... Types>
+    using remove_suffix_types = subpack_helper<0, sizeof...(Types) - NumToRemove, Types...>;
+
+    template <template <typename...> typename Filterer, typename... Types>
     struct filter_helper {
-        using type = pack<>;
+        using type = keep_t<std::integer_sequence<bool, bool { Filterer<Types>::value }...>, Types...>;
     };
 
-    template <template <typename...> typename Filterer, typename FirstType, typename... Types>
-    struct filter_helper<Filterer, FirstType, Types...> {
-        using type = typename std::conditional<
-            Filterer<FirstType>::value,
-            typename filter_helper<Filterer, Types...>::type::template apply<pack<FirstType>::template append>,
-            typename filter_helper<Filterer, Types...>::type>::type;
+    // every pack names its remove_duplicates, so this must stay cheap: a type is kept only at its first occurrence
+    template <typename Sequence, typename... Args>
+    struct remove_duplicates_impl;
+
+    template <size_t... Is, typename... Args>
+    struct remove_duplicates_impl<std::index_sequence<Is...>, Args...> {
+        using type = keep_t<std::integer_sequence<bool, first_occurrences<Args...>.value[Is]...>, Args...>;
     };
 
-    template <typename PackType, typename... Others>
-    struct add_if_new {
-        using type = PackType;
+    template <size_t Size>
+    struct index_array {
+        size_t value[Size + 1] {};
     };
 
-    template <typename PackType, typename First, typename... Others>
-    struct add_if_new<PackType, First, Others...> {
-        using type = typename add_if_new<
-            typename std::conditional<
-                PackType::template contains<First>::value,
-                PackType,
-                typename PackType::template append<First>>::type,
-            Others...>::type;
+    // a stable counting sort: each type's position is the number of types ordered before it, plus the number of equal
+    // types preceding it
+    template <template <typename, typename> typename Compare, typename... Types>
+    struct sort_order {
+        template <typename T>
+        static constexpr std::array<bool, sizeof...(Types)> sorts_before { bool { Compare<Types, T>::value }... };
+
+        static constexpr auto value = [] {
+            constexpr std::array<std::array<bool, sizeof...(Types)>, sizeof...(Types)> before { sorts_before<Types>... };
+
+            index_array<sizeof...(Types)> order;
+            for (size_t i = 0; i < before.size(); ++i) {
+                size_t position = 0;
+                for (size_t j = 0; j < before.size(); ++j) {
+                    position += before[i][j] || (j < i && !before[j][i]) ? 1 : 0;
+                }
+                order.value[position] = i;
+            }
+
+            return order;
+        }();
+    };
+
+    template <template <typename, typename> typename Compare, typename Sequence, typename... Types>
+    struct sort_helper;
+
+    template <template <typename, typename> typename Compare, size_t... Is, typename... Types>
+    struct sort_helper<Compare, std::index_sequence<Is...>, Types...> {
+        using type = pack<element_t<sort_order<Compare, Types...>::value.value[Is], Types...>...>;
     };
 
     template <typename... Args>
     struct remove_duplicates_helper {
-        using type = typename add_if_new<pack<>, Args...>::type;
+        using type = typename remove_duplicates_impl<std::index_sequence_for<Args...>, Args...>::type;
     };
 } // namespace pack_impl
 
@@ -170,23 +302,21 @@ struct pack {
     using prepend_variadic_args = typename pack_impl::copy_template_args<pack, OtherVariadic>::type::template apply<prepend>;
 
     template <typename TestType>
-    using contains = std::disjunction<std::is_same<TestType, PackArgs>...>;
+    using contains = pack_impl::contains_helper<TestType, PackArgs...>;
     template <typename TestType>
     using does_not_contain = std::bool_constant<!contains<TestType>::value>;
     template <typename... TestTypes>
     using is_equal = std::conjunction<std::is_same<TestTypes, PackArgs>...>;
 
     template <typename NeedleType>
-    using count_of = pack_impl::count_of_helper<NeedleType, 0, PackArgs...>;
+    using count_of = pack_impl::count_of_helper<NeedleType, PackArgs...>;
+    template <typename NeedleType>
+    using index_of = pack_impl::index_of_helper<NeedleType, PackArgs...>;
 
     template <typename... TestTypes>
     using is_superset_of = std::conjunction<contains<TestTypes>...>;
     template <typename... TestTypes>
-    using equivalent = std::conjunction<std::bool_constant<sizeof...(TestTypes) == sizeof...(PackArgs)>,
-        is_superset_of<TestTypes...>,
-        typename pack<TestTypes...>::template is_superset_of<PackArgs...>,
-        std::bool_constant<count_of<TestTypes>::value == pack<TestTypes...>::template count_of<TestTypes>::value>...,
-        std::bool_constant<count_of<PackArgs>::value == pack<TestTypes...>::template count_of<PackArgs>::value>...>;
+    using equivalent = pack_impl::equivalent_helper<pack, pack<TestTypes...>>;
 
     template <size_t NumToRemove>
     using remove_prefix = typename pack_impl::remove_prefix_types<NumToRemove, PackArgs...>::type;
@@ -195,16 +325,20 @@ struct pack {
     using remove_suffix = typename pack_impl::remove_suffix_types<NumToRemove, PackArgs...>::type;
 
     template <size_t NewSize>
-    using downsize = typename pack_impl::remove_suffix_types<sizeof...(PackArgs) - NewSize, PackArgs...>::type;
+    using downsize = typename pack_impl::subpack_helper<0, NewSize, PackArgs...>::type;
 
     template <size_t StartIndex, size_t Count>
-    using subpack = typename remove_prefix<StartIndex>::template downsize<Count>;
+    using subpack = typename pack_impl::subpack_helper<StartIndex, Count, PackArgs...>::type;
 
     template <template <typename...> typename Filterer>
     using filter = typename pack_impl::filter_helper<Filterer, PackArgs...>::type;
 
     using remove_duplicates = typename pack_impl::remove_duplicates_helper<PackArgs...>::type;
 
+    // stable, `Compare<L, R>::value` is whether L belongs before R
+    template <template <typename, typename> typename Compare>
+    using sort_by = typename pack_impl::sort_helper<Compare, std::index_sequence_for<PackArgs...>, PackArgs...>::type;
+
     template <template <typename...> typename Transformer>
     using transform = pack<typename Transformer<PackArgs>::type...>;
 
@@ -227,6 +361,12 @@ struct pack {
     }
 };
 
+// a `sort_by` order placing the most strictly aligned, then the largest, types first. Members laid out in this order need
+// no padding between them
+template <typename L, typename R>
+struct alignment_order : std::bool_constant<(alignof(L) > alignof(R)) || (alignof(L) == alignof(R) && sizeof(L) > sizeof(R))> {
+};
+
 template <typename ParentType>
 using pack_for = typename pack_impl::copy_template_args<pack, ParentType>::type;
 } // namespace safet
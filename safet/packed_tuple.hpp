@@ -0,0 +1,175 @@
+#pragma once
+
+#include <safet/pack.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace safet {
+namespace packed_tuple_impl {
+    // a member paired with its declaration index, so the index survives the members being reordered
+    template <size_t I, typename T>
+    struct entry {
+        using type = T;
+        static constexpr size_t index = I;
+    };
+
+    template <typename L, typename R>
+    using entry_order = alignment_order<typename L::type, typename R::type>;
+
+    template <size_t I, typename T>
+    struct leaf {
+        template <typename... Params>
+        constexpr explicit leaf(std::in_place_t, Params&&... params)
+            : value(std::forward<Params>(params)...)
+        {
+        }
+
+        T value;
+    };
+
+    template <typename Sequence, typename... Ts>
+    struct entries;
+
+    template <size_t... Is, typename... Ts>
+    struct entries<std::index_sequence<Is...>, Ts...> {
+        using type = pack<entry<Is, Ts>...>;
+    };
+
+    template <typename SortedEntries>
+    struct storage;
+
+    // bases are laid out in the order they're listed, which is the sorted order. Each leaf is constructed from the
+    // parameter at its declaration index, or value initialized when there are none
+    template <typename... Entries>
+    struct storage<pack<Entries...>> : leaf<Entries::index, typename Entries::type>... {
+        constexpr storage()
+            : leaf<Entries::index, typename Entries::type>(std::in_place)...
+        {
+        }
+
+        template <typename Params>
+        constexpr explicit storage(Params&& params)
+            : leaf<Entries::index, typename Entries::type>(std::in_place, std::get<Entries::index>(std::forward<Params>(params)))...
+        {
+        }
+    };
+
+    template <typename... Ts>
+    using sorted_storage = storage<typename entries<std::index_sequence_for<Ts...>, Ts...>::type::template sort_by<entry_order>>;
+} // namespace packed_tuple_impl
+
+// a tuple which lays out its members by descending alignment then size, rather than in declaration order, so there is
+// no padding between them. Members are still indexed in declaration order, `get<0>()` of a `packed_tuple<char, double>`
+// is the char even though the double is stored first
+template <typename... Ts>
+class packed_tuple {
+public:
+    static_assert((!std::is_reference_v<Ts> && ...), "packed_tuple members must not be references");
+
+    constexpr packed_tuple() = default;
+
+    template <typename... Params, typename = std::enable_if_t<sizeof...(Params) == sizeof...(Ts) && sizeof...(Ts) != 0 && !(std::is_same_v<std::remove_cvref_t<Params>, packed_tuple> && ...) && (std::is_constructible_v<Ts, Params&&> && ...)>>
+    constexpr packed_tuple(Params&&... params)
+        : m_storage(std::forward_as_tuple(std::forward<Params>(params)...))
+    {
+    }
+
+    template <size_t I>
+    constexpr auto get() & -> typename pack<Ts...>::template ith_type<I>::type&
+    {
+        return member<I>(m_storage).value;
+    }
+
+    template <size_t I>
+    constexpr auto get() const& -> const typename pack<Ts...>::template ith_type<I>::type&
+    {
+        return member<I>(m_storage).value;
+    }
+
+    template <size_t I>
+    constexpr auto get() && -> typename pack<Ts...>::template ith_type<I>::type&&
+    {
+        return std::move(member<I>(m_storage).value);
+    }
+
+    template <typename T>
+    constexpr auto get() & -> T&
+    {
+        return get<unique_index<T>()>();
+    }
+
+    template <typename T>
+    constexpr auto get() const& -> const T&
+    {
+        return get<unique_index<T>()>();
+    }
+
+    template <typename T>
+    constexpr auto get() && -> T&&
+    {
+        return std::move(*this).template get<unique_index<T>()>();
+    }
+
+    friend constexpr auto operator==(const packed_tuple& lhs, const packed_tuple& rhs) -> bool
+    {
+        return equal(lhs, rhs, std::index_sequence_for<Ts...> {});
+    }
+
+private:
+    using storage_type = packed_tuple_impl::sorted_storage<Ts...>;
+
+    template <size_t I, typename Storage>
+    static constexpr auto member(Storage& storage) -> auto&
+    {
+        using leaf_type = packed_tuple_impl::leaf<I, typename pack<Ts...>::template ith_type<I>::type>;
+        return static_cast<std::conditional_t<std::is_const_v<Storage>, const leaf_type&, leaf_type&>>(storage);
+    }
+
+    template <typename T>
+    static constexpr auto unique_index() -> size_t
+    {
+        static_assert(pack<Ts...>::template count_of<T>::value == 1, "type must be exactly one of the packed_tuple's members, use its index instead");
+
+        return pack<Ts...>::template index_of<T>::value;
+    }
+
+    template <size_t... Is>
+    static constexpr auto equal(const packed_tuple& lhs, const packed_tuple& rhs, std::index_sequence<Is...>) -> bool
+    {
+        return ((lhs.template get<Is>() == rhs.template get<Is>()) && ...);
+    }
+
+    storage_type m_storage;
+};
+
+template <size_t I, typename... Ts>
+constexpr decltype(auto) get(packed_tuple<Ts...>& tuple)
+{
+    return tuple.template get<I>();
+}
+
+template <size_t I, typename... Ts>
+constexpr decltype(auto) get(const packed_tuple<Ts...>& tuple)
+{
+    return tuple.template get<I>();
+}
+
+template <size_t I, typename... Ts>
+constexpr decltype(auto) get(packed_tuple<Ts...>&& tuple)
+{
+    return std::move(tuple).template get<I>();
+}
+} // namespace safet
+
+// structured bindings
+template <typename... Ts>
+struct std::tuple_size<safet::packed_tuple<Ts...>> : std::integral_constant<size_t, sizeof...(Ts)> {
+};
+
+template <size_t I, typename... Ts>
+struct std::tuple_element<I, safet::packed_tuple<Ts...>> {
+    using type = typename safet::pack<Ts...>::template ith_type<I>::type;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <safet/impl/concepts.hpp>
+#include <safet/memory.hpp>
+#include <safet/optional.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace safet {
+// read-copy-update over an immutable, shared value. Readers take a `shared_ptr<const T>` snapshot which they may hold
+// as long as they like, without ever blocking writers or one another. Writers copy the current version, modify the
+// copy and then atomically publish it. Old versions are released once the last snapshot of them is dropped.
+//
+// Snapshots are loaded from a `std::atomic<std::shared_ptr>`, which has no mutex. Writers are serialized by `Mutex`
+// so that each update sees the result of the previous one.
+template <typename T, impl::lockable Mutex = std::mutex>
+class rcu {
+public:
+    static_assert(std::is_copy_constructible_v<T>, "rcu type must be copy constructible");
+
+    template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, Params&&...>>>
+    rcu(Params&&... params)
+        : m_current(std::make_shared<const T>(std::forward<Params>(params)...))
+    {
+    }
+
+    rcu(const rcu&) = delete;
+    rcu(rcu&&) = delete;
+
+    ~rcu() = default;
+
+    auto operator=(const rcu&) -> rcu& = delete;
+    auto operator=(rcu&&) -> rcu& = delete;
+
+    // publishes an entirely new version without copying the current one
+    auto operator=(T new_value) -> rcu&
+    {
+        std::unique_lock guard { m_writer };
+        m_current.store(std::make_shared<const T>(std::move(new_value)), std::memory_order_release);
+
+        return *this;
+    }
+
+    // the current version, which is never empty and will never change while it's held
+    auto snapshot() const -> shared_ptr<const T>
+    {
+        return shared_ptr<const T> { m_current.load(std::memory_order_acquire) };
+    }
+
+    // calls `f` on the current version, which is kept alive until `f` returns even if it's replaced in the meantime
+    template <impl::invocable<const T&> InspectFunctor>
+    auto inspect(InspectFunctor&& f) const -> std::invoke_result_t<InspectFunctor&&, const T&>
+    {
+        const auto current = m_current.load(std::memory_order_acquire);
+
+        return std::forward<InspectFunctor>(f)(*current);
+    }
+
+    // copies the current version for `f` to modify, and publishes the copy once `f` returns. If `f` throws nothing is
+    // published
+    template <typename Functor>
+    decltype(auto) update(Functor&& f)
+    {
+        static_assert(impl::invocable<Functor&&, T&>, "update functor must be invocable with T&");
+
+        std::unique_lock guard { m_writer };
+        auto next = std::make_shared<T>(*m_current.load(std::memory_order_relaxed));
+
+        if constexpr (impl::invocable_and_returns_something<Functor&&, T&>) {
+            decltype(auto) ret_val = std::forward<Functor>(f)(*next);
+            m_current.store(std::move(next), std::memory_order_release);
+
+            return ret_val;
+        } else {
+            std::forward<Functor>(f)(*next);
+            m_current.store(std::move(next), std::memory_order_release);
+        }
+    }
+
+private:
+    Mutex m_writer;
+    std::atomic<std::shared_ptr<const T>> m_current;
+};
+}
@@ -1,8 +1,21 @@
 #pragma once
 
+#include <safet/atomic_value.hpp>
+#include <safet/channel.hpp>
+#include <safet/combining_critical_section.hpp>
 #include <safet/cow.hpp>
 #include <safet/critical_section.hpp>
+#include <safet/future.hpp>
 #include <safet/memory.hpp>
+#include <safet/mutex.hpp>
+#include <safet/object_pool.hpp>
 #include <safet/optional.hpp>
+#include <safet/optional_vector.hpp>
 #include <safet/pack.hpp>
+#include <safet/packed_tuple.hpp>
+#include <safet/rcu.hpp>
+#include <safet/seqlock.hpp>
+#include <safet/sharded_critical_section.hpp>
+#include <safet/thread_pool.hpp>
 #include <safet/variant.hpp>
+#include <safet/variant_vector.hpp>
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <safet/impl/concepts.hpp>
+#include <safet/impl/hardware.hpp>
+#include <safet/mutex.hpp>
+#include <safet/optional.hpp>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+namespace safet {
+// a sequence lock, for small values that are read far more often than they are written. Readers take a copy of the
+// value without ever writing to shared memory, so they never contend with each other nor block writers. Instead a
+// reader that races a writer simply retries its copy. Writers are serialized by `Mutex`.
+//
+// The value is held as an array of relaxed atomic words rather than a plain `T`, as a reader's copy racing a writer
+// would otherwise be a data race, even though any torn copy is discarded.
+template <typename T, impl::lockable Mutex = spin_mutex>
+class seqlock {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "seqlock type must be trivially copyable");
+
+    template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, Params&&...>>>
+    seqlock(Params&&... params)
+    {
+        store_words(T(std::forward<Params>(params)...));
+    }
+
+    seqlock(const seqlock&) = delete;
+    seqlock(seqlock&&) = delete;
+
+    ~seqlock() = default;
+
+    auto operator=(const seqlock&) -> seqlock& = delete;
+    auto operator=(seqlock&&) -> seqlock& = delete;
+
+    auto operator=(T new_value) -> seqlock&
+    {
+        std::unique_lock guard { m_writer };
+        publish(new_value);
+
+        return *this;
+    }
+
+    // modifies a copy of the value which is published once `f` returns, so readers only ever observe the value
+    // before or after `f`. If `f` throws nothing is published
+    template <typename Functor>
+    decltype(auto) enter(Functor&& f)
+    {
+        static_assert(impl::invocable<Functor&&, T&>, "enter functor must be invocable with T&");
+
+        std::unique_lock guard { m_writer };
+        auto value = load_words();
+
+        if constexpr (impl::invocable_and_returns_something<Functor&&, T&>) {
+            decltype(auto) ret_val = std::forward<Functor>(f)(value);
+            publish(value);
+
+            return ret_val;
+        } else {
+            std::forward<Functor>(f)(value);
+            publish(value);
+        }
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(Functor&& f)
+    {
+        static_assert(impl::invocable<Functor&&, T&>, "enter functor must be invocable with T&");
+
+        std::unique_lock guard { m_writer, std::try_to_lock };
+        if constexpr (impl::invocable_and_returns_something<Functor&&, T&>) {
+            return [&]() -> optional<std::invoke_result_t<Functor&&, T&>> {
+                if (guard.owns_lock()) {
+                    auto value = load_words();
+                    decltype(auto) ret_val = std::forward<Functor>(f)(value);
+                    publish(value);
+
+                    return ret_val;
+                } else {
+                    return std::nullopt;
+                }
+            }();
+        } else {
+            if (guard.owns_lock()) {
+                auto value = load_words();
+                std::forward<Functor>(f)(value);
+                publish(value);
+
+                return true;
+            }
+
+            return false;
+        }
+    }
+
+    // a consistent copy of the value, never blocks though it may retry while writers are active
+    auto read() const -> T
+    {
+        while (true) {
+            const auto before = m_sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                // a writer is mid-publish, any copy now would be discarded
+                impl::cpu_relax();
+                continue;
+            }
+
+            auto value = load_words();
+
+            // orders the word loads above before the sequence re-check below
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                return value;
+            }
+        }
+    }
+
+    // calls `f` with a consistent copy of the value, `f` only runs once and does not hold anything
+    template <impl::invocable<const T&> InspectFunctor>
+    auto inspect(InspectFunctor&& f) const -> std::invoke_result_t<InspectFunctor&&, const T&>
+    {
+        const auto value = read();
+
+        return std::forward<InspectFunctor>(f)(value);
+    }
+
+private:
+    using word_type = std::uintptr_t;
+    static constexpr auto word_count = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+
+    auto load_words() const -> T
+    {
+        std::array<word_type, word_count> words;
+        for (size_t i = 0; i < word_count; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+
+        std::array<std::byte, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+
+        return std::bit_cast<T>(bytes);
+    }
+
+    auto store_words(const T& value) -> void
+    {
+        std::array<word_type, word_count> words {};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        for (size_t i = 0; i < word_count; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    // must hold `m_writer`
+    auto publish(const T& value) -> void
+    {
+        const auto sequence = m_sequence.load(std::memory_order_relaxed);
+
+        // odd sequence marks a write in progress. The fence orders it before the word stores that follow
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        store_words(value);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    Mutex m_writer;
+    std::atomic<size_t> m_sequence { 0 };
+    std::array<std::atomic<word_type>, word_count> m_words;
+};
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <safet/critical_section.hpp>
+#include <safet/impl/concepts.hpp>
+#include <safet/impl/hardware.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace safet {
+namespace sharded_critical_section_impl {
+    // many std::hash implementations are the identity function, which maps keys sharing low bits (e.g. aligned
+    // pointers) onto the same shard. Fibonacci hashing spreads them out using the high bits of the product
+    inline auto mix(size_t hash) -> uint64_t
+    {
+        return (static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> 32;
+    }
+
+    // each shard gets its own cache line(s) so that threads working on different shards never contend on the same
+    // line, neither through the mutex nor the value
+    template <typename T, typename Mutex>
+    struct alignas(impl::cache_line_size) shard {
+        template <typename... Params>
+        shard(const Params&... params)
+            : m_section(params...)
+        {
+        }
+
+        critical_section<T, Mutex> m_section;
+    };
+}
+
+// N independently locked `critical_section<T, Mutex>`s, with keys routed to a shard by `Hasher`. Operations on keys in
+// different shards never contend, while `enter_all` still allows a consistent operation across every shard.
+//
+// Keys are converted to `Key` before they're hashed, so one logical key always lands on the same shard however it's
+// spelled, e.g. `"foo"` and `std::string { "foo" }` for a `std::string` key
+template <typename T, size_t N, typename Key, typename Hasher = std::hash<Key>, impl::lockable Mutex = std::mutex>
+class sharded_critical_section {
+public:
+    static_assert(N > 0, "sharded_critical_section must have at least one shard");
+    static_assert(impl::invocable<const Hasher&, const Key&>, "sharded_critical_section Hasher must be invocable with const Key&");
+
+    using key_type = Key;
+
+    // each shard's value is constructed from (copies of) the same params
+    template <typename... Params, typename = std::enable_if_t<std::is_constructible_v<T, const Params&...>>>
+    sharded_critical_section(const Params&... params)
+        : sharded_critical_section(std::make_index_sequence<N> {}, params...)
+    {
+    }
+
+    sharded_critical_section(const sharded_critical_section&) = delete;
+    sharded_critical_section(sharded_critical_section&&) = delete;
+
+    ~sharded_critical_section() = default;
+
+    auto operator=(const sharded_critical_section&) -> sharded_critical_section& = delete;
+    auto operator=(sharded_critical_section&&) -> sharded_critical_section& = delete;
+
+    static constexpr auto shard_count() -> size_t
+    {
+        return N;
+    }
+
+    auto shard_index(const Key& key) const -> size_t
+    {
+        return sharded_critical_section_impl::mix(m_hasher(key)) % N;
+    }
+
+    // enters only the shard `key` belongs to, with the same semantics as `critical_section::enter`
+    template <typename Functor>
+    decltype(auto) enter(const Key& key, Functor&& f) &
+    {
+        return m_shards[shard_index(key)].m_section.enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) enter(const Key& key, Functor&& f) const&
+    {
+        return m_shards[shard_index(key)].m_section.enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(const Key& key, Functor&& f) &
+    {
+        return m_shards[shard_index(key)].m_section.try_enter(std::forward<Functor>(f));
+    }
+
+    template <typename Functor>
+    decltype(auto) try_enter(const Key& key, Functor&& f) const&
+    {
+        return m_shards[shard_index(key)].m_section.try_enter(std::forward<Functor>(f));
+    }
+
+    // locks every shard (always in index order, so concurrent `enter_all`s cannot deadlock) and then calls `f` with
+    // each shard's value in turn while all are held. If `f` returns something the results are returned as an array
+    // indexed by shard
+    template <typename Functor>
+    decltype(auto) enter_all(Functor&& f) &
+    {
+        static_assert(impl::invocable<Functor&, T&>, "enter_all functor must be invocable with T&");
+
+        return enter_all_helper(*this, f, std::make_index_sequence<N> {});
+    }
+
+    template <typename Functor>
+    decltype(auto) enter_all(Functor&& f) const&
+    {
+        static_assert(impl::invocable<Functor&, const T&>, "enter_all functor must be invocable with const T&");
+
+        return enter_all_helper(*this, f, std::make_index_sequence<N> {});
+    }
+
+private:
+    using shard_type = sharded_critical_section_impl::shard<T, Mutex>;
+
+    template <size_t... Is, typename... Params>
+    sharded_critical_section(std::index_sequence<Is...>, const Params&... params)
+        : m_shards { { (static_cast<void>(Is), shard_type { params... })... } }
+    {
+    }
+
+    template <typename Self, typename Functor, size_t... Is>
+    static decltype(auto) enter_all_helper(Self& self, Functor& f, std::index_sequence<Is...>)
+    {
+        using access = critical_section_impl::access;
+
+        auto guards = std::array { access::guard(self.m_shards[Is].m_section)... };
+        for (auto& guard : guards) {
+            guard.lock();
+        }
+
+        using value_type = decltype(access::value(self.m_shards[0].m_section));
+        if constexpr (impl::invocable_and_returns_something<Functor&, value_type>) {
+            // braced initialization guarantees the shards are visited in order
+            return std::array<std::invoke_result_t<Functor&, value_type>, N> { f(access::value(self.m_shards[Is].m_section))... };
+        } else {
+            (f(access::value(self.m_shards[Is].m_section)), ...);
+        }
+    }
+
+    std::array<shard_type, N> m_shards;
+    [[no_unique_address]] Hasher m_hasher;
+};
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include <safet/critical_section.hpp>
+#include <safet/future.hpp>
+#include <safet/impl/hardware.hpp>
+#include <safet/mutex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace safet {
+namespace thread_pool_impl {
+    // a move-only `void()` callable, stored inline when it fits
+    class task {
+    public:
+        template <typename Functor, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Functor>, task>>>
+        task(Functor&& f)
+        {
+            using functor_type = std::decay_t<Functor>;
+
+            if constexpr (sizeof(functor_type) <= sizeof(m_buffer) && alignof(functor_type) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<functor_type>) {
+                new (m_buffer) functor_type(std::forward<Functor>(f));
+                m_ops = &inline_ops<functor_type>;
+            } else {
+                new (m_buffer) functor_type*(new functor_type(std::forward<Functor>(f)));
+                m_ops = &heap_ops<functor_type>;
+            }
+        }
+
+        task(const task&) = delete;
+        task(task&& move) noexcept
+            : m_ops(std::exchange(move.m_ops, nullptr))
+        {
+            if (m_ops != nullptr) {
+                m_ops->relocate(move.m_buffer, m_buffer);
+            }
+        }
+
+        ~task()
+        {
+            if (m_ops != nullptr) {
+                m_ops->destroy(m_buffer);
+            }
+        }
+
+        auto operator=(const task&) -> task& = delete;
+        auto operator=(task&& move) noexcept -> task&
+        {
+            if (&move != this) {
+                std::destroy_at(this);
+                new (this) task(std::move(move));
+            }
+
+            return *this;
+        }
+
+        auto operator()() -> void
+        {
+            m_ops->invoke(m_buffer);
+        }
+
+    private:
+        struct ops {
+            auto (*invoke)(std::byte*) -> void;
+            // move constructs into `to` and destroys `from`
+            auto (*relocate)(std::byte* from, std::byte* to) noexcept -> void;
+            auto (*destroy)(std::byte*) noexcept -> void;
+        };
+
+        template <typename Functor>
+        static auto as(std::byte* buffer) -> Functor*
+        {
+            return std::launder(reinterpret_cast<Functor*>(buffer));
+        }
+
+        template <typename Functor>
+        static constexpr ops inline_ops {
+            [](std::byte* buffer) { (*as<Functor>(buffer))(); },
+            [](std::byte* from, std::byte* to) noexcept {
+                new (to) Functor(std::move(*as<Functor>(from)));
+                std::destroy_at(as<Functor>(from));
+            },
+            [](std::byte* buffer) noexcept { std::destroy_at(as<Functor>(buffer)); },
+        };
+
+        template <typename Functor>
+        static constexpr ops heap_ops {
+            [](std::byte* buffer) { (**as<Functor*>(buffer))(); },
+            [](std::byte* from, std::byte* to) noexcept { new (to) Functor*(*as<Functor*>(from)); },
+            [](std::byte* buffer) noexcept { delete *as<Functor*>(buffer); },
+        };
+
+        alignas(std::max_align_t) std::byte m_buffer[6 * sizeof(void*)];
+        const ops* m_ops;
+    };
+
+    // the owning worker pushes and pops at the back, so recently submitted (and likely cache-hot) work runs first,
+    // while thieves take the oldest work from the front
+    struct alignas(impl::cache_line_size) worker_queue {
+        critical_section<std::deque<task>, spin_mutex> m_tasks;
+    };
+
+    // set on pool threads so work submitted from a task goes to the submitting worker's own queue
+    struct worker_identity {
+        const void* m_pool { nullptr };
+        size_t m_index { 0 };
+    };
+
+    inline auto current_worker() -> worker_identity&
+    {
+        thread_local worker_identity identity;
+        return identity;
+    }
+}
+
+struct thread_pool_options {
+    size_t threads { std::max(std::thread::hardware_concurrency(), 1u) };
+    // pins worker i to cpu i (modulo the cpu count). Only supported on linux, elsewhere it is ignored
+    bool pin_threads { false };
+    // how many times an idle worker scans the queues before going to sleep
+    uint32_t spin_count { 64 };
+};
+
+// a fixed size pool of worker threads, each with its own task queue. Tasks submitted from a worker are queued on that
+// worker, everything else is distributed round robin, and idle workers steal from the others before sleeping. Tasks
+// and continuations must not throw.
+//
+// Satisfies `impl::executor` so futures can run continuations on it with `then(pool, f)`
+class thread_pool {
+public:
+    explicit thread_pool(thread_pool_options options = {})
+        : m_queues(std::max<size_t>(options.threads, 1))
+        , m_spin_count(options.spin_count)
+    {
+        m_threads.reserve(m_queues.size());
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            m_threads.emplace_back([this, i]() { work(i); });
+
+            if (options.pin_threads) {
+                pin(m_threads.back(), i);
+            }
+        }
+    }
+
+    explicit thread_pool(size_t threads)
+        : thread_pool(thread_pool_options { .threads = threads })
+    {
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+
+    // runs every task already submitted before joining the workers
+    ~thread_pool()
+    {
+        m_stopping.store(true);
+        wake(true);
+
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    auto operator=(const thread_pool&) -> thread_pool& = delete;
+    auto operator=(thread_pool&&) -> thread_pool& = delete;
+
+    auto thread_count() const -> size_t
+    {
+        return m_threads.size();
+    }
+
+    // true on the pool's own worker threads
+    auto on_worker() const -> bool
+    {
+        return thread_pool_impl::current_worker().m_pool == this;
+    }
+
+    // queues `f` to run on a worker, without a future for its result
+    template <typename Functor>
+    auto post(Functor&& f) -> void
+    {
+        static_assert(impl::invocable<std::decay_t<Functor>&>, "thread_pool tasks must be invocable with no arguments");
+
+        const auto& self = thread_pool_impl::current_worker();
+        const auto index = self.m_pool == this ? self.m_index : m_next_queue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+        // counted before it is published, otherwise a thief could take it and decrement the count below zero first
+        m_queued.fetch_add(1, std::memory_order_release);
+        try {
+            m_queues[index].m_tasks.enter([&](std::deque<thread_pool_impl::task>& tasks) { tasks.emplace_back(std::forward<Functor>(f)); });
+        } catch (...) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            throw;
+        }
+
+        wake(false);
+    }
+
+    // queues `f` to run on a worker, returning a future for its result
+    template <typename Functor, typename E = std::error_code>
+    auto submit(Functor&& f) -> future<std::invoke_result_t<std::decay_t<Functor>&>, E>
+    {
+        using return_type = std::invoke_result_t<std::decay_t<Functor>&>;
+
+        auto [p, result] = make_promise<return_type, E>();
+        post([p = std::move(p), f = std::forward<Functor>(f)]() mutable {
+            if constexpr (std::is_void_v<return_type>) {
+                f();
+                p.set_value();
+            } else {
+                p.set_value(f());
+            }
+        });
+
+        return std::move(result);
+    }
+
+    // calls `f` on each element of `range`, split into chunks across the workers. The returned future completes once
+    // every call has returned. Lvalue ranges are referenced, so they must outlive the returned future
+    template <std::ranges::random_access_range Range, typename Functor, typename E = std::error_code>
+    requires(std::ranges::sized_range<Range>)
+    auto bulk(Range&& range, Functor&& f) -> future<void, E>
+    {
+        using view_type = std::ranges::views::all_t<Range>;
+        using functor_type = std::decay_t<Functor>;
+
+        struct bulk_state {
+            view_type m_view;
+            functor_type m_functor;
+            size_t m_size;
+            size_t m_chunk;
+            std::atomic<size_t> m_next { 0 };
+            std::atomic<size_t> m_remaining;
+            promise<void, E> m_promise;
+        };
+
+        auto [p, result] = make_promise<void, E>();
+
+        auto view = std::ranges::views::all(std::forward<Range>(range));
+        const auto size = static_cast<size_t>(std::ranges::size(view));
+        if (size == 0) {
+            p.set_value();
+            return std::move(result);
+        }
+
+        // a few chunks per worker, so that workers finishing early can pick up the slack
+        const auto chunk = std::max<size_t>(size / (m_queues.size() * 4), 1);
+        const auto chunk_count = (size + chunk - 1) / chunk;
+
+        auto state = std::make_shared<bulk_state>(std::move(view), std::forward<Functor>(f), size, chunk, 0, chunk_count, std::move(p));
+
+        for (size_t i = 0; i < std::min(chunk_count, m_queues.size()); ++i) {
+            post([state]() {
+                for (auto begin = state->m_next.fetch_add(state->m_chunk, std::memory_order_relaxed); begin < state->m_size; begin = state->m_next.fetch_add(state->m_chunk, std::memory_order_relaxed)) {
+                    const auto end = std::min(begin + state->m_chunk, state->m_size);
+                    for (auto it = std::ranges::begin(state->m_view) + begin; it != std::ranges::begin(state->m_view) + end; ++it) {
+                        state->m_functor(*it);
+                    }
+
+                    if (state->m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        state->m_promise.set_value();
+                    }
+                }
+            });
+        }
+
+        return std::move(result);
+    }
+
+private:
+    static auto pin([[maybe_unused]] std::thread& thread, [[maybe_unused]] size_t index) -> void
+    {
+#if defined(__linux__)
+        const auto cpus = std::max(std::thread::hardware_concurrency(), 1u);
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cpus, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+
+    auto wake(bool all) -> void
+    {
+        m_epoch.fetch_add(1);
+        if (all) {
+            m_epoch.notify_all();
+        } else if (m_sleepers.load() > 0) {
+            m_epoch.notify_one();
+        }
+    }
+
+    auto work(size_t index) -> void
+    {
+        thread_pool_impl::current_worker() = { this, index };
+
+        for (;;) {
+            if (auto t = find_task(index); !t.empty()) {
+                t.if_set([](thread_pool_impl::task& task) { task(); });
+                continue;
+            }
+
+            for (uint32_t i = 0; i < m_spin_count && m_queued.load(std::memory_order_acquire) == 0; ++i) {
+                impl::cpu_relax();
+            }
+            if (m_queued.load(std::memory_order_acquire) > 0) {
+                continue;
+            }
+
+            // any post after reading the epoch changes it, so either the recheck finds the task or the wait returns
+            const auto epoch = m_epoch.load();
+            if (m_queued.load() > 0) {
+                continue;
+            }
+            if (m_stopping.load()) {
+                // nothing left to drain
+                return;
+            }
+
+            m_sleepers.fetch_add(1);
+            m_epoch.wait(epoch);
+            m_sleepers.fetch_sub(1);
+        }
+    }
+
+    // our own queue first, newest first, then the oldest task of every other queue in turn
+    auto find_task(size_t index) -> optional<thread_pool_impl::task>
+    {
+        if (m_queued.load(std::memory_order_acquire) == 0) {
+            return std::nullopt;
+        }
+
+        for (size_t i = 0; i < m_queues.size(); ++i) {
+            const auto victim = (index + i) % m_queues.size();
+            const auto own = victim == index;
+
+            auto t = m_queues[victim].m_tasks.enter([own](std::deque<thread_pool_impl::task>& tasks) -> optional<thread_pool_impl::task> {
+                if (tasks.empty()) {
+                    return std::nullopt;
+                }
+
+                auto& next = own ? tasks.back() : tasks.front();
+                optional<thread_pool_impl::task> result { std::move(next) };
+                own ? tasks.pop_back() : tasks.pop_front();
+
+                return result;
+            });
+
+            if (!t.empty()) {
+                m_queued.fetch_sub(1, std::memory_order_relaxed);
+                return t;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::vector<thread_pool_impl::worker_queue> m_queues;
+    std::vector<std::thread> m_threads;
+    uint32_t m_spin_count;
+
+    alignas(impl::cache_line_size) std::atomic<size_t> m_queued { 0 };
+    std::atomic<size_t> m_next_queue { 0 };
+    alignas(impl::cache_line_size) std::atomic<uint32_t> m_epoch { 0 };
+    std::atomic<uint32_t> m_sleepers { 0 };
+    std::atomic<bool> m_stopping { false };
+};
+}
@@ -3,7 +3,12 @@
 #include <safet/optional.hpp>
 #include <safet/pack.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <variant>
 
 namespace safet {
@@ -24,6 +29,277 @@ namespace variant_impl {
 
     template <typename T, typename... Args>
     concept one_of_as_reference = impl::one_of<T&, Args...>;
+
+    template <typename... Ts>
+    concept copy_constructible = (std::is_copy_constructible_v<Ts> && ...);
+    template <typename... Ts>
+    concept trivially_copy_constructible = copy_constructible<Ts...> && (std::is_trivially_copy_constructible_v<Ts> && ...);
+
+    template <typename... Ts>
+    concept move_constructible = (std::is_move_constructible_v<Ts> && ...);
+    template <typename... Ts>
+    concept trivially_move_constructible = move_constructible<Ts...> && (std::is_trivially_move_constructible_v<Ts> && ...);
+
+    template <typename... Ts>
+    concept trivially_destructible = (std::is_trivially_destructible_v<Ts> && ...);
+
+    template <typename... Ts>
+    concept copy_assignable = copy_constructible<Ts...> && (std::is_copy_assignable_v<Ts> && ...);
+    template <typename... Ts>
+    concept trivially_copy_assignable = copy_assignable<Ts...> && trivially_copy_constructible<Ts...>
+        && trivially_destructible<Ts...> && (std::is_trivially_copy_assignable_v<Ts> && ...);
+
+    template <typename... Ts>
+    concept move_assignable = move_constructible<Ts...> && (std::is_move_assignable_v<Ts> && ...);
+    template <typename... Ts>
+    concept trivially_move_assignable = move_assignable<Ts...> && trivially_move_constructible<Ts...>
+        && trivially_destructible<Ts...> && (std::is_trivially_move_assignable_v<Ts> && ...);
+
+    // the smallest index able to count every alternative and still leave a value for the valueless state, so a variant of
+    // fewer than 256 alternatives spends a single byte on it
+    template <size_t Count>
+    using index_type = std::conditional_t<(Count <= std::numeric_limits<uint8_t>::max()), uint8_t,
+        std::conditional_t<(Count <= std::numeric_limits<uint16_t>::max()), uint16_t, size_t>>;
+
+    // store references as pointers
+    template <typename T>
+    using stored_type = std::conditional<std::is_reference<T>::value, wrapped_reference<std::remove_reference_t<T>>, T>::type;
+
+    // a union of every alternative, nested one level per alternative. A typed union rather than a byte buffer, so the
+    // compiler's aliasing analysis sees every alternative as a possible occupant of the storage
+    template <typename... Ts>
+    union alternatives {
+    };
+
+    template <typename T, typename... Ts>
+    union alternatives<T, Ts...> {
+        constexpr alternatives() noexcept
+            : m_none {}
+        {
+        }
+
+        // only used by `variant` when trivial, otherwise the union makes them deleted
+        alternatives(const alternatives&) = default;
+        alternatives(alternatives&&) = default;
+
+        // `variant` destroys the active alternative
+        ~alternatives() requires(std::is_trivially_destructible_v<T> && (std::is_trivially_destructible_v<Ts> && ...)) = default;
+        ~alternatives()
+        {
+        }
+
+        auto operator=(const alternatives&) -> alternatives& = default;
+        auto operator=(alternatives&&) -> alternatives& = default;
+
+        template <size_t I>
+        auto get() -> auto&
+        {
+            if constexpr (I == 0) {
+                return m_head;
+            } else {
+                return m_tail.template get<I - 1>();
+            }
+        }
+        template <size_t I>
+        auto get() const -> const auto&
+        {
+            if constexpr (I == 0) {
+                return m_head;
+            } else {
+                return m_tail.template get<I - 1>();
+            }
+        }
+
+    private:
+        struct none {
+        };
+
+        none m_none;
+        T m_head;
+        alternatives<Ts...> m_tail;
+    };
+
+    // alternatives constructed in place, in a union of all of them. This is only raw storage, the variant decides which
+    // alternative is constructed, copied or destroyed
+    template <typename... Ts>
+    class inline_storage {
+    public:
+        template <size_t I>
+        using type = typename pack<Ts...>::template ith_type<I>::type;
+
+        auto index() const -> size_t
+        {
+            return m_index;
+        }
+
+        auto valueless_by_exception() const -> bool
+        {
+            return m_index == valueless;
+        }
+
+        template <size_t I>
+        auto get() -> type<I>&
+        {
+            return m_alternatives.template get<I>();
+        }
+        template <size_t I>
+        auto get() const -> const type<I>&
+        {
+            return m_alternatives.template get<I>();
+        }
+
+        // there must not be a value constructed already
+        template <size_t I, typename... ConstructArgs>
+        auto construct(ConstructArgs&&... args) -> type<I>&
+        {
+            auto& value = *std::construct_at(std::addressof(get<I>()), std::forward<ConstructArgs>(args)...);
+            m_index = I;
+
+            return value;
+        }
+
+        // called after the value has been destroyed
+        auto reset() -> void
+        {
+            m_index = valueless;
+        }
+
+    private:
+        static constexpr auto valueless = std::numeric_limits<index_type<sizeof...(Ts)>>::max();
+
+        alternatives<Ts...> m_alternatives;
+        index_type<sizeof...(Ts)> m_index { valueless };
+    };
+
+    // a variant of only references needs just one pointer, and when the referenced types are all aligned enough to leave
+    // room for the index in the low bits of that pointer, the whole variant is a single word. Alternatives are handed out
+    // as `wrapped_reference`s by value, there is nothing with their type stored to refer to
+    template <typename... Ts>
+    class tagged_storage {
+    public:
+        template <size_t I>
+        using type = wrapped_reference<typename pack<Ts...>::template ith_type<I>::type>;
+
+        auto index() const -> size_t
+        {
+            return m_bits & tag_mask;
+        }
+
+        // storing a pointer can't throw
+        static constexpr auto valueless_by_exception() -> bool
+        {
+            return false;
+        }
+
+        template <size_t I>
+        auto get() const -> type<I>
+        {
+            return type<I> { reinterpret_cast<decltype(type<I>::m_value)>(m_bits & ~tag_mask) };
+        }
+
+        template <size_t I>
+        auto construct(type<I> ref) -> type<I>
+        {
+            m_bits = reinterpret_cast<uintptr_t>(ref.m_value) | I;
+
+            return ref;
+        }
+
+        auto reset() -> void
+        {
+        }
+
+    private:
+        static constexpr uintptr_t tag_mask = std::min({ alignof(Ts)... }) - 1;
+
+        uintptr_t m_bits { 0 };
+    };
+
+    template <typename... Args>
+    concept taggable_references = (impl::reference<Args> && ...) && sizeof...(Args) <= std::min({ alignof(std::remove_reference_t<Args>)... });
+
+    template <typename... Args>
+    struct storage_for {
+        using type = inline_storage<stored_type<Args>...>;
+    };
+
+    template <typename... Args>
+    requires taggable_references<Args...>
+    struct storage_for<Args...> {
+        using type = tagged_storage<std::remove_reference_t<Args>...>;
+    };
+
+    // selects the alternative a converting constructor initializes the same way `std::variant` does: by overload resolution
+    // over one `select(T_i)` per alternative, where alternatives that would need a narrowing conversion don't participate.
+    // References are never converted to, they are only stored from a `std::reference_wrapper` or in place
+    template <size_t I, typename T>
+    struct conversion_candidate {
+        template <typename Arg>
+        requires requires(Arg&& arg) { std::type_identity_t<T[]> { std::forward<Arg>(arg) }; }
+        static auto select(T, Arg&&) -> std::integral_constant<size_t, I>;
+    };
+
+    template <size_t I, impl::reference T>
+    struct conversion_candidate<I, T> {
+        static auto select() -> void;
+    };
+
+    template <typename Sequence, typename... Args>
+    struct conversion_overloads;
+
+    template <size_t... Is, typename... Args>
+    struct conversion_overloads<std::index_sequence<Is...>, Args...> : conversion_candidate<Is, Args>... {
+        using conversion_candidate<Is, Args>::select...;
+    };
+
+    template <typename Arg, typename... Args>
+    using conversion_index = decltype(conversion_overloads<std::index_sequence_for<Args...>, Args...>::select(std::declval<Arg>(), std::declval<Arg>()));
+
+    template <typename Arg, typename... Args>
+    concept converts_to_alternative = requires { typename conversion_index<Arg, Args...>; };
+
+    template <typename R, typename F, size_t I>
+    auto dispatch_entry(F&& f) -> R
+    {
+        return std::forward<F>(f)(std::integral_constant<size_t, I> {});
+    }
+
+    template <typename R, typename F, size_t Columns, size_t I>
+    auto codispatch_entry(F&& f) -> R
+    {
+        return std::forward<F>(f)(std::integral_constant<size_t, I / Columns> {}, std::integral_constant<size_t, I % Columns> {});
+    }
+
+    template <typename R, typename F, typename Sequence>
+    struct dispatch_table;
+
+    template <typename R, typename F, size_t... Is>
+    struct dispatch_table<R, F, std::index_sequence<Is...>> {
+        static constexpr R (*entries[])(F&&) = { &dispatch_entry<R, F, Is>... };
+    };
+
+    template <typename R, typename F, size_t Columns, typename Sequence>
+    struct codispatch_table;
+
+    template <typename R, typename F, size_t Columns, size_t... Is>
+    struct codispatch_table<R, F, Columns, std::index_sequence<Is...>> {
+        static constexpr R (*entries[])(F&&) = { &codispatch_entry<R, F, Columns, Is>... };
+    };
+
+    // calls `f(std::integral_constant<size_t, I> {})` for the runtime index `I` through a table of function pointers built
+    // at compile time, so dispatch is a single indirect call however many alternatives there are
+    template <typename R, size_t Count, typename F>
+    auto dispatch(size_t index, F&& f) -> R
+    {
+        return dispatch_table<R, F, std::make_index_sequence<Count>>::entries[index](std::forward<F>(f));
+    }
+
+    // as `dispatch`, for a pair of indices, through a single flattened `Rows` x `Columns` table
+    template <typename R, size_t Rows, size_t Columns, typename F>
+    auto codispatch(size_t row, size_t column, F&& f) -> R
+    {
+        return codispatch_table<R, F, Columns, std::make_index_sequence<Rows * Columns>>::entries[row * Columns + column](std::forward<F>(f));
+    }
 }
 
 template <typename... Ts>
@@ -33,67 +309,129 @@ struct overloaded : Ts... {
 template <class... Ts>
 overloaded(Ts...) -> overloaded<Ts...>;
 
+// the alternatives are stored in place, in a union of all of them next to the smallest index that can count them, or as
+// a single tagged pointer when they are all (sufficiently aligned) references. Every operation that depends on the active
+// alternative (visiting, copying, destroying, ...) goes through a single jump table rather than a recursive or linear
+// search over the alternatives.
+//
+// a variant can only become valueless (see `valueless_by_exception`) when replacing its value with an alternative that
+// throws both while being constructed and while being moved; when every alternative is nothrow move constructible a
+// variant can never be valueless
 template <typename... Args>
 class variant {
 public:
     // store references as pointers
     template <typename T>
-    using storage_type = std::conditional<std::is_reference<T>::value, variant_impl::wrapped_reference<std::remove_reference_t<T>>, T>::type;
+    using storage_type = variant_impl::stored_type<T>;
 
-    template <typename T = typename pack<Args...>::template ith_type<0>::type, typename = std::enable_if<std::is_constructible_v<T>>>
-    variant()
-        : variant(std::in_place_index_t<0> {}, T {})
+    template <size_t I>
+    using alternative_type = typename pack<Args...>::template ith_type<I>::type;
+
+    variant() requires(std::is_default_constructible_v<alternative_type<0>>)
+        : variant(std::in_place_index_t<0> {})
     {
     }
 
     template <impl::value T, typename... ConstructArgs>
     explicit variant(std::in_place_type_t<T>, ConstructArgs&&... args)
-        : m_variant(std::in_place_type_t<storage_type<T>> {}, std::forward<ConstructArgs>(args)...)
     {
+        construct<unique_index<T>()>(std::forward<ConstructArgs>(args)...);
     }
 
     template <impl::reference T>
     explicit variant(std::in_place_type_t<T>, std::type_identity_t<T> ref)
-        : m_variant(std::in_place_type_t<storage_type<T>> {}, &ref)
     {
+        construct<unique_index<T>()>(transform_in<T>(ref));
     }
 
     template <size_t I, typename... ConstructArgs, impl::value = typename pack<Args...>::template ith_type<I>::type>
     explicit variant(std::in_place_index_t<I>, ConstructArgs&&... args)
-        : m_variant(std::in_place_index_t<I> {}, std::forward<ConstructArgs>(args)...)
     {
+        construct<I>(std::forward<ConstructArgs>(args)...);
     }
 
     template <size_t I, impl::reference = typename pack<Args...>::template ith_type<I>::type>
     explicit variant(std::in_place_index_t<I>, typename pack<Args...>::template ith_type<I>::type ref)
-        : m_variant(std::in_place_index_t<I> {}, &ref)
     {
+        construct<I>(transform_in<alternative_type<I>>(ref));
     }
 
-    template <typename T, typename = std::enable_if_t<std::is_constructible_v<std::variant<storage_type<Args>...>, T&&>>>
+    template <typename T>
+    requires(!impl::decays_to<T, variant<Args...>> && variant_impl::converts_to_alternative<T, Args...>)
     variant(T&& arg)
-        : m_variant(std::forward<T>(arg))
     {
+        construct<variant_impl::conversion_index<T, Args...>::value>(std::forward<T>(arg));
     }
 
     template <variant_impl::one_of_as_reference<Args...> T>
     variant(std::reference_wrapper<T> ref)
-        : m_variant(variant_impl::wrapped_reference<T> { &ref.get() })
     {
+        construct<unique_index<T&>()>(transform_in<T&>(ref.get()));
     }
 
-    ~variant() = default;
+    // every special member is trivial when the corresponding member of every alternative is, so e.g. `variant<int, float>`
+    // is trivially copyable
+    ~variant() requires(variant_impl::trivially_destructible<storage_type<Args>...>) = default;
+    ~variant()
+    {
+        destroy();
+    }
 
-    variant(const variant<Args...>&) = default;
-    variant(variant<Args...>&&) = default;
+    variant(const variant<Args...>&) requires(variant_impl::trivially_copy_constructible<storage_type<Args>...>) = default;
+    variant(const variant<Args...>& copy) requires(variant_impl::copy_constructible<storage_type<Args>...>)
+    {
+        if (!copy.valueless_by_exception()) {
+            copy.dispatch([&](auto i) { construct<i>(copy.template raw<i>()); });
+        }
+    }
 
-    auto operator=(const variant<Args...>&) -> variant<Args...>& = default;
-    auto operator=(variant<Args...>&&) -> variant<Args...>& = default;
+    variant(variant<Args...>&&) requires(variant_impl::trivially_move_constructible<storage_type<Args>...>) = default;
+    variant(variant<Args...>&& move) noexcept((std::is_nothrow_move_constructible_v<storage_type<Args>> && ...))
+        requires(variant_impl::move_constructible<storage_type<Args>...>)
+    {
+        if (!move.valueless_by_exception()) {
+            move.dispatch([&](auto i) { construct<i>(std::move(move.template raw<i>())); });
+        }
+    }
+
+    auto operator=(const variant<Args...>&) -> variant<Args...>& requires(variant_impl::trivially_copy_assignable<storage_type<Args>...>) = default;
+    auto operator=(const variant<Args...>& copy) -> variant<Args...>& requires(variant_impl::copy_assignable<storage_type<Args>...>)
+    {
+        if (copy.valueless_by_exception()) {
+            destroy();
+        } else if (m_storage.index() == copy.m_storage.index()) {
+            copy.dispatch([&](auto i) { raw<i>() = copy.template raw<i>(); });
+        } else {
+            // copy first, so a throwing copy leaves this variant as it was
+            *this = variant<Args...> { copy };
+        }
+
+        return *this;
+    }
+
+    auto operator=(variant<Args...>&&) -> variant<Args...>& requires(variant_impl::trivially_move_assignable<storage_type<Args>...>) = default;
+    auto operator=(variant<Args...>&& move) -> variant<Args...>& requires(variant_impl::move_assignable<storage_type<Args>...>)
+    {
+        if (move.valueless_by_exception()) {
+            destroy();
+        } else if (m_storage.index() == move.m_storage.index()) {
+            move.dispatch([&](auto i) { raw<i>() = std::move(move.template raw<i>()); });
+        } else {
+            move.dispatch([&](auto i) { replace<i>(std::move(move.template raw<i>())); });
+        }
+
+        return *this;
+    }
 
     template <impl::one_of<Args...> T>
     auto operator=(T value) -> variant<Args...>&
     {
-        m_variant = transform_in(std::move(value));
+        constexpr auto I = unique_index<T>();
+        if (m_storage.index() == I) {
+            raw<I>() = std::move(value);
+        } else {
+            replace<I>(std::move(value));
+        }
 
         return *this;
     }
@@ -101,7 +439,7 @@ public:
     template <variant_impl::one_of_as_reference<Args...> T>
     auto operator=(std::reference_wrapper<T> ref) -> variant<Args...>&
     {
-        m_variant = variant_impl::wrapped_reference<T> { &ref.get() };
+        replace<unique_index<T&>()>(transform_in<T&>(ref.get()));
 
         return *this;
     }
@@ -109,104 +447,84 @@ public:
     template <impl::value Type, typename... EmplaceArgs>
     auto emplace(EmplaceArgs&&... emplace_args) -> Type&
     {
-        return m_variant.template emplace<storage_type<Type>>(std::forward<EmplaceArgs>(emplace_args)...);
+        return replace<unique_index<Type>()>(std::forward<EmplaceArgs>(emplace_args)...);
     }
 
     template <impl::reference Type>
     auto emplace(Type ref) -> Type&
     {
-        return *m_variant.template emplace<storage_type<Type>>(&ref).m_value;
+        return *replace<unique_index<Type>()>(transform_in<Type>(ref)).m_value;
     }
 
     template <size_t I, typename... EmplaceArgs>
-    auto emplace(EmplaceArgs&&... emplace_args) -> typename pack<Args...>::template ith_type<I>::type&
+    auto emplace(EmplaceArgs&&... emplace_args) -> alternative_type<I>&
     {
-        return m_variant.template emplace<I>(std::forward<EmplaceArgs>(emplace_args)...);
+        if constexpr (impl::reference<alternative_type<I>>) {
+            return *replace<I>(transform_in<alternative_type<I>>(std::forward<EmplaceArgs>(emplace_args)...)).m_value;
+        } else {
+            return replace<I>(std::forward<EmplaceArgs>(emplace_args)...);
+        }
     }
 
     template <typename Visitor>
     decltype(auto) visit(Visitor&& v) &
     {
-        return visit_helper(std::forward<Visitor>(v), typename pack<Args...>::remove_duplicates {});
+        return visit_helper(*this, std::forward<Visitor>(v));
     }
     template <typename Visitor>
     decltype(auto) visit(Visitor&& v) const&
     {
-        return visit_helper(std::forward<Visitor>(v), typename pack<Args...>::remove_duplicates {});
+        return visit_helper(*this, std::forward<Visitor>(v));
     }
     template <typename Visitor>
     decltype(auto) visit(Visitor&& v) &&
     {
-        return std::move(*this).visit_helper(std::forward<Visitor>(v), typename pack<Args...>::remove_duplicates {});
+        return visit_helper(std::move(*this), std::forward<Visitor>(v));
     }
 
     template <impl::one_of<Args...> T>
     auto get() & -> optional<T&>
     {
-        if (std::holds_alternative<storage_type<T>>(m_variant)) {
-            auto& val = std::get<storage_type<T>>(m_variant);
-
-            return transform_out<T>(val);
-        } else {
-            return std::nullopt;
-        }
+        return get<unique_index<T>()>();
     }
 
     template <impl::one_of<Args...> T>
     auto get() const& -> optional<const T&>
     {
-        if (std::holds_alternative<storage_type<T>>(m_variant)) {
-            auto& val = std::get<storage_type<T>>(m_variant);
-
-            return transform_out<T>(val);
-        } else {
-            return std::nullopt;
-        }
+        return get<unique_index<T>()>();
     }
 
     template <impl::one_of<Args...> T>
     auto get() && -> optional<T>
     {
-        if (std::holds_alternative<storage_type<T>>(m_variant)) {
-            auto& val = std::get<storage_type<T>>(m_variant);
-
-            return transform_out<T>(std::move(val));
-        } else {
-            return std::nullopt;
-        }
+        return std::move(*this).template get<unique_index<T>()>();
     }
 
     template <size_t I>
-    auto get() & -> optional<typename pack<Args...>::template ith_type<I>::type&>
+    auto get() & -> optional<alternative_type<I>&>
     {
-        if (m_variant.index() == I) {
-            auto& val = std::get<I>(m_variant);
-
-            return transform_out<typename pack<Args...>::template ith_type<I>::type>(val);
+        if (m_storage.index() == I) {
+            return alternative<I>();
         } else {
             return std::nullopt;
         }
     }
 
     template <size_t I>
-    auto get() const& -> optional<const typename pack<Args...>::template ith_type<I>::type&>
+    auto get() const& -> optional<const alternative_type<I>&>
     {
-        if (m_variant.index() == I) {
-            auto& val = std::get<I>(m_variant);
-
-            return transform_out<typename pack<Args...>::template ith_type<I>::type>(val);
+        if (m_storage.index() == I) {
+            return alternative<I>();
         } else {
             return std::nullopt;
         }
     }
 
     template <size_t I>
-    auto get() && -> optional<typename pack<Args...>::template ith_type<I>::type>
+    auto get() && -> optional<alternative_type<I>>
     {
-        if (m_variant.index() == I) {
-            auto& val = std::get<I>(m_variant);
-
-            return transform_out<typename pack<Args...>::template ith_type<I>::type>(std::move(val));
+        if (m_storage.index() == I) {
+            return std::move(*this).template alternative<I>();
         } else {
             return std::nullopt;
         }
@@ -214,66 +532,165 @@ public:
 
     auto index() const -> size_t
     {
-        return m_variant.index();
+        return valueless_by_exception() ? std::variant_npos : m_storage.index();
+    }
+
+    // only true when replacing the value threw after the old value was already destroyed, which requires an alternative
+    // that can throw from both its constructor and its move constructor. Visiting a valueless variant throws
+    // `std::bad_variant_access`
+    auto valueless_by_exception() const -> bool
+    {
+        return m_storage.valueless_by_exception();
     }
 
     template <typename Covisitor>
     decltype(auto) covisit(impl::decays_to<variant<Args...>> auto&& other, Covisitor&& covisitor) &
     {
-        return visit([&](impl::one_of<Args...> auto& first) {
-            return std::forward<decltype(other)>(other).visit([&](auto&& second) {
-                return std::forward<Covisitor>(covisitor)(first, std::forward<decltype(second)>(second));
-            });
-        });
+        return covisit_helper(*this, std::forward<decltype(other)>(other), std::forward<Covisitor>(covisitor));
     }
 
     template <typename Covisitor>
     decltype(auto) covisit(impl::decays_to<variant<Args...>> auto&& other, Covisitor&& covisitor) const&
     {
-        return visit([&](const impl::one_of<Args...> auto& first) {
-            return std::forward<decltype(other)>(other).visit([&](auto&& second) {
-                return std::forward<Covisitor>(covisitor)(first, std::forward<decltype(second)>(second));
-            });
-        });
+        return covisit_helper(*this, std::forward<decltype(other)>(other), std::forward<Covisitor>(covisitor));
     }
 
     template <typename Covisitor>
     decltype(auto) covisit(impl::decays_to<variant<Args...>> auto&& other, Covisitor&& covisitor) &&
     {
-        return visit([&](impl::one_of<Args...> auto&& first) {
-            return std::forward<decltype(other)>(other).visit([&](auto&& second) {
-                return std::forward<Covisitor>(covisitor)(std::move(first), std::forward<decltype(second)>(second));
-            });
-        });
+        return covisit_helper(std::move(*this), std::forward<decltype(other)>(other), std::forward<Covisitor>(covisitor));
     }
 
 private:
-    template <typename Visitor, typename... UniqueArgs>
-    decltype(auto) visit_helper(Visitor&& v, pack<UniqueArgs...>) &
+    template <typename T>
+    static constexpr auto unique_index() -> size_t
     {
-        return std::visit(
-            overloaded { [&](storage_type<UniqueArgs>& val) -> decltype(auto) {
-                return std::forward<Visitor>(v)(transform_out<UniqueArgs>(val));
-            }... },
-            m_variant);
+        static_assert(pack<Args...>::template count_of<T>::value == 1, "type must be exactly one of the variant's alternatives, use its index instead");
+
+        return pack<Args...>::template index_of<T>::value;
     }
-    template <typename Visitor, typename... UniqueArgs>
-    decltype(auto) visit_helper(Visitor&& v, pack<UniqueArgs...>) const&
+
+    template <typename Visitor, typename Self, size_t... Is>
+    static auto visit_result(std::index_sequence<Is...>)
     {
-        return std::visit(
-            overloaded { [&](const storage_type<UniqueArgs>& val) -> decltype(auto) {
-                return std::forward<Visitor>(v)(transform_out<UniqueArgs>(val));
-            }... },
-            m_variant);
+        using result_type = decltype(std::declval<Visitor>()(std::declval<Self>().template alternative<0>()));
+        static_assert((std::is_same_v<result_type, decltype(std::declval<Visitor>()(std::declval<Self>().template alternative<Is>()))> && ...),
+            "visitor must return the same type for every alternative");
+
+        return std::type_identity<result_type> {};
     }
-    template <typename Visitor, typename... UniqueArgs>
-    decltype(auto) visit_helper(Visitor&& v, pack<UniqueArgs...>) &&
+
+    template <typename Covisitor, typename Self, typename Other, size_t... Is>
+    static auto covisit_result(std::index_sequence<Is...>)
     {
-        return std::visit(
-            overloaded { [&](storage_type<UniqueArgs>&& val) -> decltype(auto) {
-                return std::forward<Visitor>(v)(transform_out<UniqueArgs>(std::move(val)));
-            }... },
-            std::move(m_variant));
+        constexpr auto count = sizeof...(Args);
+        using result_type = decltype(std::declval<Covisitor>()(std::declval<Self>().template alternative<0>(), std::declval<Other>().template alternative<0>()));
+        static_assert((std::is_same_v<result_type, decltype(std::declval<Covisitor>()(std::declval<Self>().template alternative<Is / count>(), std::declval<Other>().template alternative<Is % count>()))> && ...),
+            "covisitor must return the same type for every pair of alternatives");
+
+        return std::type_identity<result_type> {};
+    }
+
+    template <typename Self, typename Visitor>
+    static decltype(auto) visit_helper(Self&& self, Visitor&& v)
+    {
+        using result_type = typename decltype(visit_result<Visitor, Self>(std::index_sequence_for<Args...> {}))::type;
+
+        if (self.valueless_by_exception()) {
+            throw std::bad_variant_access {};
+        }
+
+        return self.template dispatch<result_type>([&](auto i) -> result_type {
+            return std::forward<Visitor>(v)(std::forward<Self>(self).template alternative<i>());
+        });
+    }
+
+    template <typename Self, typename Other, typename Covisitor>
+    static decltype(auto) covisit_helper(Self&& self, Other&& other, Covisitor&& covisitor)
+    {
+        constexpr auto count = sizeof...(Args);
+        using result_type = typename decltype(covisit_result<Covisitor, Self, Other>(std::make_index_sequence<count * count> {}))::type;
+
+        if (self.valueless_by_exception() || other.valueless_by_exception()) {
+            throw std::bad_variant_access {};
+        }
+
+        return variant_impl::codispatch<result_type, count, count>(self.m_storage.index(), other.m_storage.index(), [&](auto i, auto j) -> result_type {
+            return std::forward<Covisitor>(covisitor)(std::forward<Self>(self).template alternative<i>(), std::forward<Other>(other).template alternative<j>());
+        });
+    }
+
+    // calls `f` with the active alternative's index as an `std::integral_constant`, the variant must not be valueless
+    template <typename R = void, typename F>
+    auto dispatch(F&& f) const -> R
+    {
+        return variant_impl::dispatch<R, sizeof...(Args)>(m_storage.index(), std::forward<F>(f));
+    }
+
+    template <size_t I>
+    decltype(auto) raw()
+    {
+        return m_storage.template get<I>();
+    }
+    template <size_t I>
+    decltype(auto) raw() const
+    {
+        return m_storage.template get<I>();
+    }
+
+    template <size_t I>
+    auto alternative() & -> alternative_type<I>&
+    {
+        return transform_out<alternative_type<I>>(raw<I>());
+    }
+    template <size_t I>
+    auto alternative() const& -> const alternative_type<I>&
+    {
+        return transform_out<alternative_type<I>>(raw<I>());
+    }
+    template <size_t I>
+    auto alternative() && -> alternative_type<I>&&
+    {
+        return transform_out<alternative_type<I>>(std::move(raw<I>()));
+    }
+
+    // the variant must not hold a value
+    template <size_t I, typename... ConstructArgs>
+    decltype(auto) construct(ConstructArgs&&... args)
+    {
+        return m_storage.template construct<I>(std::forward<ConstructArgs>(args)...);
+    }
+
+    // destroys the current value and constructs alternative `I` in its place. The new value is built before the old one
+    // is destroyed, unless building it can't throw, so a throwing constructor leaves the variant untouched; only an
+    // alternative that can't be moved into place without throwing gives that up and may leave the variant valueless
+    template <size_t I, typename... ConstructArgs>
+    decltype(auto) replace(ConstructArgs&&... args)
+    {
+        using stored_type = storage_type<alternative_type<I>>;
+
+        if constexpr (std::is_nothrow_constructible_v<stored_type, ConstructArgs&&...>) {
+            destroy();
+            return construct<I>(std::forward<ConstructArgs>(args)...);
+        } else if constexpr (std::is_nothrow_move_constructible_v<stored_type>) {
+            stored_type replacement(std::forward<ConstructArgs>(args)...);
+            destroy();
+            return construct<I>(std::move(replacement));
+        } else {
+            destroy();
+            return construct<I>(std::forward<ConstructArgs>(args)...);
+        }
+    }
+
+    auto destroy() -> void
+    {
+        if constexpr (!variant_impl::trivially_destructible<storage_type<Args>...>) {
+            if (!valueless_by_exception()) {
+                dispatch([this](auto i) { std::destroy_at(&raw<i>()); });
+            }
+        }
+
+        m_storage.reset();
     }
 
     template <typename T>
@@ -312,7 +729,8 @@ private:
             return val;
         }
     }
-    std::variant<storage_type<Args>...> m_variant;
+
+    typename variant_impl::storage_for<Args...>::type m_storage;
 };
 
 template <typename VariantType, typename... Args>
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <safet/finally.hpp>
+#include <safet/impl/concepts.hpp>
+#include <safet/pack.hpp>
+#include <safet/variant.hpp>
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace safet {
+// a sequence of variants, stored as one contiguous array per alternative rather than as an array of variants padded to
+// the largest alternative. The order the elements were added in is kept as an array of the smallest index able to count
+// the alternatives, a single byte per element for fewer than 256 of them.
+//
+// `visit_all` runs over each alternative's array in turn, so the visitor sees long runs of the same type rather than
+// branching on every element. Elements aren't randomly accessible, as that would need each element's position within
+// its alternative's array, `visit_each` recovers the order they were added in
+template <typename... Ts>
+class variant_vector {
+public:
+    static_assert(sizeof...(Ts) > 0, "variant_vector must have at least one alternative");
+    static_assert((!std::is_reference_v<Ts> && ...), "variant_vector alternatives must not be references");
+
+    template <size_t I>
+    using alternative_type = typename pack<Ts...>::template ith_type<I>::type;
+
+    template <size_t I, typename... Params>
+    auto emplace_back(Params&&... params) -> alternative_type<I>&
+    {
+        m_indices.push_back(static_cast<index_type>(I));
+        scope_fail undo { [this]() { m_indices.pop_back(); } };
+
+        return std::get<I>(m_columns).emplace_back(std::forward<Params>(params)...);
+    }
+
+    template <typename T, typename... Params>
+    auto emplace_back(Params&&... params) -> T&
+    {
+        return emplace_back<unique_index<T>()>(std::forward<Params>(params)...);
+    }
+
+    template <typename T>
+    requires(impl::one_of<std::remove_cvref_t<T>, Ts...>) auto push_back(T&& value) -> void
+    {
+        emplace_back<std::remove_cvref_t<T>>(std::forward<T>(value));
+    }
+
+    // throws `std::bad_variant_access` for a valueless variant, as visiting it would
+    auto push_back(const variant<Ts...>& value) -> void
+    {
+        if (value.valueless_by_exception()) {
+            throw std::bad_variant_access {};
+        }
+
+        variant_impl::dispatch<void, sizeof...(Ts)>(value.index(), [&](auto i) {
+            value.template get<i>().if_set([&](const auto& alternative) { emplace_back<i>(alternative); });
+        });
+    }
+
+    auto push_back(variant<Ts...>&& value) -> void
+    {
+        if (value.valueless_by_exception()) {
+            throw std::bad_variant_access {};
+        }
+
+        variant_impl::dispatch<void, sizeof...(Ts)>(value.index(), [&](auto i) {
+            std::move(value).template get<i>().if_set([&](auto&& alternative) { emplace_back<i>(std::move(alternative)); });
+        });
+    }
+
+    auto size() const noexcept -> size_t
+    {
+        return m_indices.size();
+    }
+
+    auto empty() const noexcept -> bool
+    {
+        return m_indices.empty();
+    }
+
+    // the alternative held by the element at `position`
+    auto index(size_t position) const -> size_t
+    {
+        return m_indices[position];
+    }
+
+    auto clear() noexcept -> void
+    {
+        m_indices.clear();
+        std::apply([](auto&... columns) { (columns.clear(), ...); }, m_columns);
+    }
+
+    // every element holding alternative `I`, in the order they were added
+    template <size_t I>
+    auto alternative() -> std::span<alternative_type<I>>
+    {
+        return std::get<I>(m_columns);
+    }
+    template <size_t I>
+    auto alternative() const -> std::span<const alternative_type<I>>
+    {
+        return std::get<I>(m_columns);
+    }
+
+    template <typename T>
+    auto alternative() -> std::span<T>
+    {
+        return alternative<unique_index<T>()>();
+    }
+    template <typename T>
+    auto alternative() const -> std::span<const T>
+    {
+        return alternative<unique_index<T>()>();
+    }
+
+    // calls `v` with every element, grouped by alternative in declaration order
+    template <typename Visitor>
+    auto visit_all(Visitor&& v) -> void
+    {
+        visit_all_helper(m_columns, v, std::index_sequence_for<Ts...> {});
+    }
+    template <typename Visitor>
+    auto visit_all(Visitor&& v) const -> void
+    {
+        visit_all_helper(m_columns, v, std::index_sequence_for<Ts...> {});
+    }
+
+    // calls `v` with every element in the order they were added, one dispatch per element
+    template <typename Visitor>
+    auto visit_each(Visitor&& v) -> void
+    {
+        visit_each_helper(*this, v);
+    }
+    template <typename Visitor>
+    auto visit_each(Visitor&& v) const -> void
+    {
+        visit_each_helper(*this, v);
+    }
+
+private:
+    using index_type = variant_impl::index_type<sizeof...(Ts)>;
+
+    template <typename T>
+    static constexpr auto unique_index() -> size_t
+    {
+        static_assert(pack<Ts...>::template count_of<T>::value == 1, "type must be exactly one of the variant_vector's alternatives, use its index instead");
+
+        return pack<Ts...>::template index_of<T>::value;
+    }
+
+    template <typename Columns, typename Visitor, size_t... Is>
+    static auto visit_all_helper(Columns& columns, Visitor& v, std::index_sequence<Is...>) -> void
+    {
+        static_assert((impl::invocable<Visitor&, decltype(std::get<Is>(columns).front())> && ...), "visitor must be invocable with every alternative");
+
+        // each alternative is its own tight loop over contiguous values of a single type
+        (
+            [&]() {
+                for (auto& value : std::get<Is>(columns)) {
+                    v(value);
+                }
+            }(),
+            ...);
+    }
+
+    template <typename Self, typename Visitor>
+    static auto visit_each_helper(Self& self, Visitor& v) -> void
+    {
+        // the next unvisited element of each alternative
+        std::array<size_t, sizeof...(Ts)> cursors {};
+        for (const auto index : self.m_indices) {
+            variant_impl::dispatch<void, sizeof...(Ts)>(index, [&](auto i) { v(std::get<i>(self.m_columns)[cursors[i]++]); });
+        }
+    }
+
+    std::tuple<std::vector<Ts>...> m_columns;
+    std::vector<index_type> m_indices;
+};
+}
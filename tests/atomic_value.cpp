@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+
+#include <safet/atomic_value.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+namespace {
+struct pair16 {
+    uint64_t first;
+    uint64_t second;
+};
+
+struct oversized {
+    uint64_t words[4];
+};
+}
+
+TEST_CASE("atomic_value storage selection", "[atomic_value]")
+{
+    STATIC_REQUIRE(atomic_value<uint64_t>::is_lock_free);
+    STATIC_REQUIRE(atomic_value<pair16>::is_lock_free == bool(SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS));
+    STATIC_REQUIRE_FALSE(atomic_value<oversized>::is_lock_free);
+    STATIC_REQUIRE_FALSE(atomic_value<std::string>::is_lock_free);
+
+    // lock-free storage is nothing but the value
+    STATIC_REQUIRE(sizeof(atomic_value<uint64_t>) == sizeof(uint64_t));
+
+#if SAFET_ATOMIC_VALUE_HAS_DOUBLE_WIDTH_CAS
+    // built by libsafet_tests_cx16
+    STATIC_REQUIRE(atomic_value<pair16>::is_lock_free);
+    STATIC_REQUIRE(sizeof(atomic_value<pair16>) == 16);
+    STATIC_REQUIRE(alignof(atomic_value<pair16>) == 16);
+#endif
+}
+
+TEMPLATE_TEST_CASE("atomic_value::enter() and atomic_value::inspect()", "[atomic_value]", uint64_t, pair16, oversized)
+{
+    atomic_value<TestType> value { TestType {} };
+    auto first = [](auto& v) -> uint64_t& {
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(v)>, uint64_t>) {
+            return v;
+        } else if constexpr (std::is_same_v<std::remove_cvref_t<decltype(v)>, pair16>) {
+            return v.first;
+        } else {
+            return v.words[0];
+        }
+    };
+
+    SECTION("enter publishes the modification and returns the functor's result")
+    {
+        REQUIRE(value.enter([&](TestType& v) { return ++first(v); }) == 1);
+        value.enter([&](TestType& v) { first(v) += 10; });
+
+        REQUIRE(value.inspect([&](const TestType& v) { return first(const_cast<TestType&>(v)); }) == 11);
+        auto copy = value.read();
+        REQUIRE(first(copy) == 11);
+    }
+
+    SECTION("assignment")
+    {
+        TestType replacement {};
+        first(replacement) = 42;
+        value = replacement;
+
+        auto copy = value.read();
+        REQUIRE(first(copy) == 42);
+    }
+
+    SECTION("concurrent enters are never lost")
+    {
+        constexpr size_t thread_count = 4;
+        constexpr size_t operations = 5000;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&]() {
+                for (size_t j = 0; j < operations; ++j) {
+                    value.enter([&](TestType& v) { ++first(v); });
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        auto copy = value.read();
+        REQUIRE(first(copy) == thread_count * operations);
+    }
+}
+
+TEST_CASE("atomic_value lock-free enter", "[atomic_value]")
+{
+    atomic_value<uint64_t> value { 5 };
+
+    SECTION("nothing is published if the functor throws")
+    {
+        REQUIRE_THROWS_AS(value.enter([](uint64_t& v) {
+            v = 100;
+            throw std::runtime_error("abandoned");
+        }),
+            std::runtime_error);
+        REQUIRE(value.read() == 5);
+    }
+
+    SECTION("the functor is re-run on a fresh copy when another writer gets in first")
+    {
+        size_t attempts { 0 };
+        value.enter([&](uint64_t& v) {
+            if (attempts++ == 0) {
+                std::thread { [&]() { value = 50; } }.join();
+            }
+            v += 1;
+        });
+
+        REQUIRE(attempts >= 2);
+        REQUIRE(value.read() == 51);
+    }
+}
+
+TEST_CASE("atomic_value falls back to a critical_section", "[atomic_value]")
+{
+    atomic_value<std::string> value { "abc" };
+
+    value.enter([](std::string& v) { v += "def"; });
+    REQUIRE(value.inspect([](const std::string& v) { return v.size(); }) == 6);
+    REQUIRE(value.read() == "abcdef");
+}
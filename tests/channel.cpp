@@ -0,0 +1,336 @@
+#include <catch2/catch.hpp>
+
+#include <safet/channel.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("channel example use cases", "[channel]")
+{
+    channel<size_t> c { 64 };
+
+    SECTION("many producers and consumers transfer every item exactly once")
+    {
+        constexpr size_t producer_count = 4;
+        constexpr size_t consumer_count = 4;
+        constexpr size_t items_per_producer = 20000;
+
+        std::atomic<size_t> total { 0 };
+        std::atomic<size_t> received { 0 };
+
+        std::vector<std::thread> consumers;
+        for (size_t i = 0; i < consumer_count; ++i) {
+            consumers.emplace_back([&]() {
+                while (true) {
+                    auto item = c.pop();
+                    if (item.empty()) {
+                        break;
+                    }
+
+                    item.if_set([&](size_t value) {
+                        total += value;
+                        ++received;
+                    });
+                }
+            });
+        }
+
+        std::vector<std::thread> producers;
+        for (size_t i = 0; i < producer_count; ++i) {
+            producers.emplace_back([&, i]() {
+                // half the producers push one at a time, half in batches
+                if (i % 2 == 0) {
+                    for (size_t j = 1; j <= items_per_producer; ++j) {
+                        c.push(j);
+                    }
+                } else {
+                    std::vector<size_t> batch(100);
+                    for (size_t j = 1; j <= items_per_producer; j += batch.size()) {
+                        std::iota(batch.begin(), batch.end(), j);
+                        c.push_batch(batch);
+                    }
+                }
+            });
+        }
+
+        for (auto& t : producers) {
+            t.join();
+        }
+        c.close();
+        for (auto& t : consumers) {
+            t.join();
+        }
+
+        REQUIRE(received == producer_count * items_per_producer);
+        REQUIRE(total == producer_count * items_per_producer * (items_per_producer + 1) / 2);
+    }
+}
+
+namespace {
+// constructing or moving the item with value 0 stalls while the flag is set, so its claim completes after later ones
+std::atomic<bool> g_slow_constructs { false };
+std::atomic<bool> g_slow_moves { false };
+std::atomic<bool> g_stalled { false };
+
+struct slow_item {
+    slow_item(int v)
+        : value(v)
+    {
+        stall_if(g_slow_constructs);
+    }
+
+    slow_item(slow_item&& move) noexcept
+        : value(move.value)
+    {
+        stall_if(g_slow_moves);
+    }
+
+    auto stall_if(const std::atomic<bool>& slow) noexcept -> void
+    {
+        if (value == 0 && slow) {
+            g_stalled = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds { 20 });
+        }
+    }
+
+    int value;
+};
+
+auto wait_for_count(const std::atomic<size_t>& count, size_t expected) -> bool
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds { 2 };
+    while (count < expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    return count == expected;
+}
+}
+
+TEST_CASE("channel wakeups with claims completing out of order", "[channel]")
+{
+    // nothing here closes the channel until the assertions are made, as closing wakes everyone regardless. They only
+    // CHECK so a failure still closes the channel and joins the threads
+    g_stalled = false;
+
+    SECTION("every sleeping consumer with an item to take is woken")
+    {
+        channel<slow_item> c { 4 };
+        std::atomic<size_t> received { 0 };
+
+        std::vector<std::thread> consumers;
+        for (size_t i = 0; i < 2; ++i) {
+            consumers.emplace_back([&]() {
+                if (!c.pop().empty()) {
+                    ++received;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds { 10 });
+
+        // the first claim is still being written when the second completes
+        g_slow_constructs = true;
+        std::thread slow_producer { [&]() { c.push(0); } };
+        while (!g_stalled) {
+            std::this_thread::yield();
+        }
+        c.push(1);
+        slow_producer.join();
+        g_slow_constructs = false;
+
+        CHECK(wait_for_count(received, 2));
+
+        c.close();
+        for (auto& t : consumers) {
+            t.join();
+        }
+    }
+
+    SECTION("every sleeping producer with a free cell is woken")
+    {
+        channel<slow_item> c { 2 };
+        REQUIRE(c.push(0));
+        REQUIRE(c.push(1));
+
+        std::atomic<size_t> pushed { 0 };
+        std::vector<std::thread> producers;
+        for (int i = 2; i < 4; ++i) {
+            producers.emplace_back([&, i]() {
+                if (c.push(i)) {
+                    ++pushed;
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds { 10 });
+
+        // the first cell is still being moved out of when the second is freed
+        g_slow_moves = true;
+        std::atomic<bool> slow_popped { false };
+        std::thread slow_consumer { [&]() { slow_popped = !c.try_pop().empty(); } };
+        while (!g_stalled) {
+            std::this_thread::yield();
+        }
+        const auto popped = !c.try_pop().empty();
+        slow_consumer.join();
+        g_slow_moves = false;
+
+        CHECK(slow_popped);
+        CHECK(popped);
+
+        CHECK(wait_for_count(pushed, 2));
+
+        c.close();
+        for (auto& t : producers) {
+            t.join();
+        }
+    }
+}
+
+TEST_CASE("channel capacity", "[channel]")
+{
+    REQUIRE(channel<int> { 5 }.capacity() == 8);
+    REQUIRE(channel<int> { 8 }.capacity() == 8);
+    REQUIRE(channel<int> { 0 }.capacity() == 2);
+}
+
+TEST_CASE("channel::try_push() and channel::try_pop()", "[channel]")
+{
+    channel<std::unique_ptr<int>> c { 2 };
+
+    SECTION("items come out in order")
+    {
+        REQUIRE(c.try_push(std::make_unique<int>(1)));
+        REQUIRE(c.try_push(std::make_unique<int>(2)));
+
+        REQUIRE(*c.try_pop().value_or([]() { return std::make_unique<int>(0); }) == 1);
+        REQUIRE(*c.try_pop().value_or([]() { return std::make_unique<int>(0); }) == 2);
+        REQUIRE(c.try_pop().empty());
+    }
+
+    SECTION("a full channel rejects items without moving from them")
+    {
+        REQUIRE(c.try_push(std::make_unique<int>(1)));
+        REQUIRE(c.try_push(std::make_unique<int>(2)));
+
+        auto rejected = std::make_unique<int>(3);
+        REQUIRE_FALSE(c.try_push(std::move(rejected)));
+        REQUIRE(rejected != nullptr);
+    }
+
+    SECTION("the ring wraps around")
+    {
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(c.try_push(std::make_unique<int>(i)));
+            REQUIRE(c.try_pop().if_set([](const std::unique_ptr<int>& value) { return *value; }) == i);
+        }
+    }
+}
+
+TEST_CASE("channel batches", "[channel]")
+{
+    channel<int> c { 4 };
+
+    std::vector<int> in { 1, 2, 3, 4, 5, 6 };
+    REQUIRE(c.try_push_batch(in) == 4);
+
+    std::vector<int> out;
+    REQUIRE(c.try_pop_batch(std::back_inserter(out), 3) == 3);
+    REQUIRE(out == std::vector<int> { 1, 2, 3 });
+
+    REQUIRE(c.try_push_batch(std::span { in }.subspan(4)) == 2);
+    REQUIRE(c.try_pop_batch(std::back_inserter(out), 10) == 3);
+    REQUIRE(out == std::vector<int> { 1, 2, 3, 4, 5, 6 });
+    REQUIRE(c.try_pop_batch(std::back_inserter(out), 10) == 0);
+}
+
+TEST_CASE("channel::close()", "[channel]")
+{
+    channel<int> c { 4 };
+
+    SECTION("closing wakes blocked consumers")
+    {
+        std::thread consumer { [&]() {
+            REQUIRE(c.pop().empty());
+        } };
+
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+        c.close();
+        consumer.join();
+    }
+
+    SECTION("closing wakes blocked producers")
+    {
+        std::vector<int> in { 1, 2, 3, 4, 5 };
+        std::thread producer { [&]() {
+            REQUIRE(c.push_batch(in) == 4);
+            REQUIRE_FALSE(c.push(6));
+        } };
+
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+        c.close();
+        producer.join();
+    }
+
+    SECTION("remaining items are still drained after close")
+    {
+        REQUIRE(c.push(1));
+        REQUIRE(c.push(2));
+        c.close();
+
+        REQUIRE_FALSE(c.try_push(3));
+        REQUIRE(c.pop() == 1);
+
+        std::vector<int> out;
+        REQUIRE(c.pop_batch(std::back_inserter(out), 10) == 1);
+        REQUIRE(out == std::vector<int> { 2 });
+        REQUIRE(c.pop().empty());
+        REQUIRE(c.pop_batch(std::back_inserter(out), 10) == 0);
+    }
+}
+
+TEST_CASE("channel::close() racing producers", "[channel]")
+{
+    constexpr size_t producer_count = 4;
+
+    for (size_t round = 0; round < 50; ++round) {
+        channel<size_t> c { 16 };
+        std::atomic<size_t> pushed { 0 };
+        std::atomic<size_t> popped { 0 };
+
+        std::thread consumer { [&]() {
+            while (!c.pop().empty()) {
+                ++popped;
+            }
+        } };
+
+        std::vector<std::thread> producers;
+        for (size_t i = 0; i < producer_count; ++i) {
+            producers.emplace_back([&, i]() {
+                // every item reported as pushed must come out, however the push interleaves with `close`
+                std::vector<size_t> batch(3, i);
+                while (true) {
+                    const auto count = i % 2 == 0 ? size_t { c.try_push(i) } : c.try_push_batch(batch);
+                    pushed += count;
+                    if (count == 0 && c.closed()) {
+                        break;
+                    }
+                }
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds { 200 });
+        c.close();
+        for (auto& t : producers) {
+            t.join();
+        }
+        consumer.join();
+
+        REQUIRE(popped == pushed);
+    }
+}
@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+
+#include <safet/combining_critical_section.hpp>
+#include <safet/mutex.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+namespace {
+struct plain_section_layout {
+    std::mutex m_mutex;
+    int m_value;
+};
+}
+
+TEST_CASE("combining_critical_section layout", "[combining_critical_section]")
+{
+    // plain sections carry none of the combining state
+    STATIC_REQUIRE(sizeof(critical_section<int>) == sizeof(plain_section_layout));
+    STATIC_REQUIRE(sizeof(combining_critical_section<int>) == sizeof(critical_section<int>) + sizeof(void*));
+}
+
+TEST_CASE("combining_critical_section::enter_combined()", "[combining_critical_section]")
+{
+    SECTION("results, references and void")
+    {
+        combining_critical_section<std::vector<int>> cs { std::vector<int> { 1, 2, 3 } };
+
+        REQUIRE(cs.enter_combined([](std::vector<int>& value) { return value.size(); }) == 3);
+
+        cs.enter_combined([](std::vector<int>& value) { value.push_back(4); });
+        auto& back = cs.enter_combined([](std::vector<int>& value) -> int& { return value.back(); });
+        REQUIRE(back == 4);
+
+        auto moved_out = cs.enter_combined([](std::vector<int>& value) { return std::move(value); });
+        REQUIRE(moved_out == std::vector<int> { 1, 2, 3, 4 });
+    }
+
+    SECTION("exceptions are rethrown to their own caller")
+    {
+        combining_critical_section<int> cs { 5 };
+
+        REQUIRE_THROWS_AS(cs.enter_combined([](int&) -> int { throw std::runtime_error("combined"); }), std::runtime_error);
+        REQUIRE(cs.enter_combined([](int& value) { return ++value; }) == 6);
+    }
+
+    SECTION("each contending caller gets its own result")
+    {
+        constexpr size_t thread_count = 8;
+        constexpr size_t operations = 2000;
+
+        combining_critical_section<size_t> counter { 0 };
+        std::vector<std::vector<size_t>> seen(thread_count);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&, i]() {
+                for (size_t j = 0; j < operations; ++j) {
+                    // mixed with plain enter, which the combiners must exclude
+                    if (j % 10 == 0) {
+                        seen[i].push_back(counter.enter([](size_t& value) { return value++; }));
+                    } else {
+                        seen[i].push_back(counter.enter_combined([](size_t& value) { return value++; }));
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::vector<size_t> all;
+        for (const auto& results : seen) {
+            // each thread's own operations happen in the order it made them
+            REQUIRE(std::is_sorted(results.begin(), results.end()));
+            all.insert(all.end(), results.begin(), results.end());
+        }
+        std::sort(all.begin(), all.end());
+
+        std::vector<size_t> expected(thread_count * operations);
+        std::iota(expected.begin(), expected.end(), size_t { 0 });
+        REQUIRE(all == expected);
+    }
+
+    SECTION("waiters block behind a long enter rather than retrying the lock")
+    {
+        constexpr size_t waiter_count = 4;
+
+        combining_critical_section<int, instrumented_mutex<>> cs { 0 };
+        std::atomic<bool> holding { false };
+        std::atomic<bool> release { false };
+
+        std::thread holder { [&]() {
+            cs.enter([&](int&) {
+                holding = true;
+                while (!release) {
+                    std::this_thread::yield();
+                }
+            });
+        } };
+        while (!holding) {
+            std::this_thread::yield();
+        }
+
+        std::vector<std::thread> waiters;
+        for (size_t i = 0; i < waiter_count; ++i) {
+            waiters.emplace_back([&]() { cs.enter_combined([](int& value) { ++value; }); });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds { 50 });
+        release = true;
+
+        holder.join();
+        for (auto& waiter : waiters) {
+            waiter.join();
+        }
+
+        REQUIRE(cs.enter([](int& value) { return value; }) == static_cast<int>(waiter_count));
+        // a single failed try_lock per call, however long the wait
+        REQUIRE(cs.stats().failed_try_locks <= waiter_count);
+    }
+}
@@ -1,9 +1,14 @@
 #include <catch2/catch.hpp>
 
+#include "detached.hpp"
+
 #include <safet/condition_variable.hpp>
+#include <safet/mutex.hpp>
 
+#include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 using namespace safet;
 
@@ -67,4 +72,277 @@ TEST_CASE("condition_variable::notify() and condition_variable::wait()", "[condi
 
         s.inspect([](const int& value) { REQUIRE(value == 1); });
     }
-}
\ No newline at end of file
+}
+TEST_CASE("condition_variable::wait_for() and condition_variable::wait_until()", "[condition_variable]")
+{
+    condition_variable<int> s { 0 };
+
+    SECTION("when the condition is satisfied before the deadline")
+    {
+        std::thread modifier { [&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+            s.modify([](int& value) { value = 1; });
+        } };
+
+        auto retval = s.wait_for(
+            std::chrono::seconds { 10 },
+            [](const int& value) { return value == 1; },
+            [](int& value) { return ++value; });
+        modifier.join();
+
+        REQUIRE(retval == 2);
+    }
+
+    SECTION("when the condition is already satisfied")
+    {
+        const auto& c_s = s;
+
+        auto called = c_s.wait_until(
+            std::chrono::steady_clock::now(),
+            [](const int& value) { return value == 0; },
+            [](const int& value) { REQUIRE(value == 0); });
+        REQUIRE(called);
+
+        auto moved = std::move(s).wait_for(
+            std::chrono::milliseconds { 1 },
+            [](const int& value) { return value == 0; },
+            [](int&& value) { return value; });
+        REQUIRE(moved == 0);
+    }
+
+    SECTION("when the deadline passes")
+    {
+        auto retval = s.wait_for(
+            std::chrono::milliseconds { 5 },
+            [](const int& value) { return value == 1; },
+            [](int&) {
+                FAIL("wait_for must not call the ready functor if the deadline passes");
+
+                return 1;
+            });
+        REQUIRE(retval.empty());
+
+        auto called = s.wait_until(
+            std::chrono::steady_clock::now() + std::chrono::milliseconds { 1 },
+            [](const int& value) { return value == 1; },
+            [](int&) { FAIL("wait_until must not call the ready functor if the deadline passes"); });
+        REQUIRE_FALSE(called);
+    }
+}
+
+TEST_CASE("condition_variable keyed wait() and modify()", "[condition_variable]")
+{
+    condition_variable<int> s { 0 };
+
+    // the first condition check is made by the waiter itself before it links into the waiter list, under the same
+    // lock that modify must take, so once we've seen it any modify will find the waiter waiting
+    auto start_waiter = [&](int key, std::atomic<size_t>& checks, std::atomic<bool>& done) {
+        return std::thread { [&, key]() {
+            s.wait(
+                key,
+                [&](const int& value) {
+                    ++checks;
+                    return value == key;
+                },
+                [&](int& value) {
+                    value = -key;
+                    done = true;
+                });
+        } };
+    };
+
+    SECTION("only waiters for the notified key are woken")
+    {
+        std::atomic<size_t> checks_1 { 0 }, checks_2 { 0 };
+        std::atomic<bool> done_1 { false }, done_2 { false };
+
+        auto waiter_1 = start_waiter(1, checks_1, done_1);
+        auto waiter_2 = start_waiter(2, checks_2, done_2);
+
+        while (checks_1 == 0 || checks_2 == 0) {
+            std::this_thread::yield();
+        }
+
+        // notifying key 1 must not even check waiter 2's condition
+        const auto checks_2_before = checks_2.load();
+        s.modify([](int& value) { value = 1; }, 1);
+        waiter_1.join();
+
+        REQUIRE(done_1);
+        REQUIRE_FALSE(done_2);
+        REQUIRE(checks_2 == checks_2_before);
+
+        s.modify([](int& value) { value = 2; }, 2);
+        waiter_2.join();
+
+        REQUIRE(done_2);
+        s.inspect([](const int& value) { REQUIRE(value == -2); });
+    }
+
+    SECTION("keyed waiters are not woken by other keys even if satisfied")
+    {
+        std::atomic<size_t> checks { 0 };
+        std::atomic<bool> done { false };
+
+        auto waiter = start_waiter(1, checks, done);
+        while (checks == 0) {
+            std::this_thread::yield();
+        }
+
+        s.modify([](int& value) { value = 1; }, 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds { 5 });
+        REQUIRE_FALSE(done);
+
+        // NOTIFY_ALL considers every key
+        s.modify([](int&) {});
+        waiter.join();
+        REQUIRE(done);
+    }
+
+    SECTION("keyed notify wakes satisfied waiters")
+    {
+        std::atomic<size_t> checks { 0 };
+        std::atomic<bool> done { false };
+        std::atomic<bool> external_condition { false };
+
+        std::thread waiter { [&]() {
+            s.wait(
+                std::string { "external" },
+                [&](const int&) {
+                    ++checks;
+                    return external_condition.load();
+                },
+                [&](int&) { done = true; });
+        } };
+
+        while (checks == 0) {
+            std::this_thread::yield();
+        }
+
+        external_condition = true;
+        s.notify(std::string { "external" });
+        waiter.join();
+
+        REQUIRE(done);
+    }
+
+    SECTION("unkeyed waiters are woken by keyed modifications")
+    {
+        std::thread waiter { [&]() {
+            s.wait([](const int& value) { return value == 5; }, [](int& value) { value = 6; });
+        } };
+
+        s.modify([](int& value) { value = 5; }, 123);
+        waiter.join();
+
+        s.inspect([](const int& value) { REQUIRE(value == 6); });
+    }
+}
+
+TEMPLATE_TEST_CASE("condition_variable keyed wait() with other lock policies", "[condition_variable]", spin_mutex, atomic_mutex, adaptive_mutex<>)
+{
+    condition_variable<int, TestType> s { 0 };
+    constexpr int rounds = 200;
+
+    std::atomic<int> acknowledged { 0 };
+
+    // each round the waiter waits for the next value, so it parks (or finds it already set) and is woken by the keyed
+    // modify
+    std::thread waiter { [&]() {
+        for (int i = 1; i <= rounds; ++i) {
+            s.wait(
+                1, [&](const int& value) { return value == i; }, [&](int&) { acknowledged = i; });
+        }
+    } };
+
+    for (int i = 1; i <= rounds; ++i) {
+        s.modify([&](int& value) { value = i; }, 1);
+        while (acknowledged != i) {
+            std::this_thread::yield();
+        }
+    }
+    waiter.join();
+
+    s.inspect([&](const int& value) { REQUIRE(value == rounds); });
+}
+
+TEST_CASE("condition_variable::wait_async()", "[condition_variable]")
+{
+    condition_variable<int> cv { 0 };
+
+    SECTION("resumes once modify satisfies the condition")
+    {
+        optional<int> result;
+        // coroutine lambdas must not capture, the captures would be destroyed along with the lambda while suspended
+        [](auto& cv, optional<int>& result) -> detached {
+            result = co_await cv.wait_async([](const int& value) { return value >= 3; }, [](int& value) { return value * 10; });
+        }(cv, result);
+
+        for (int i = 0; i < 2; ++i) {
+            cv.modify([](int& value) { ++value; });
+            REQUIRE(result.empty());
+        }
+
+        cv.modify([](int& value) { ++value; });
+        REQUIRE(result == 30);
+    }
+
+    SECTION("does not suspend if already satisfied")
+    {
+        bool done = false;
+        [](auto& cv, bool& done) -> detached {
+            co_await cv.wait_async([](const int& value) { return value == 0; }, [](int&) {});
+            done = true;
+        }(cv, done);
+
+        REQUIRE(done);
+    }
+
+    SECTION("keyed waits only consider their key")
+    {
+        bool done = false;
+        [](auto& cv, bool& done) -> detached {
+            co_await cv.wait_async(1, [](const int& value) { return value == 1; }, [](int& value) { value = -1; });
+            done = true;
+        }(cv, done);
+
+        cv.modify([](int& value) { value = 1; }, 2);
+        REQUIRE_FALSE(done);
+
+        cv.notify(1);
+        REQUIRE(done);
+        cv.inspect([](const int& value) { REQUIRE(value == -1); });
+    }
+
+    SECTION("resumed coroutines may use the condition_variable")
+    {
+        std::vector<int> order;
+
+        // a chain of coroutines, each waking the next, which only works if each is resumed after the lock is released
+        for (int i = 1; i <= 3; ++i) {
+            [](auto& cv, std::vector<int>& order, int i) -> detached {
+                co_await cv.wait_async([i](const int& value) { return value == i; }, [](int&) {});
+                order.push_back(i);
+                cv.modify([](int& value) { ++value; });
+            }(cv, order, i);
+        }
+
+        cv.modify([](int& value) { value = 1; });
+
+        REQUIRE(order == std::vector<int> { 1, 2, 3 });
+    }
+
+    SECTION("woken by another thread")
+    {
+        std::atomic<bool> done { false };
+        [](auto& cv, std::atomic<bool>& done) -> detached {
+            co_await cv.wait_async([](const int& value) { return value == 1; }, [](int&) {});
+            done = true;
+        }(cv, done);
+
+        std::thread notifier { [&]() { cv.modify([](int& value) { value = 1; }); } };
+        notifier.join();
+
+        REQUIRE(done);
+    }
+}
@@ -2,7 +2,12 @@
 
 #include <safet/cow.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using namespace safet;
 
@@ -250,4 +255,191 @@ TEST_CASE("cow::operator->()", "[cow]")
 
     REQUIRE(owned->size() == base_value.size());
     REQUIRE(refed->size() == base_value.size());
-}
\ No newline at end of file
+}
+TEST_CASE("shared_cow", "[cow]")
+{
+    SECTION("copies share the value")
+    {
+        shared_cow<std::string> a { "Hello, World!" };
+        auto b = a;
+
+        REQUIRE(&a.get_const() == &b.get_const());
+        REQUIRE(a.shared());
+        REQUIRE(b.shared());
+    }
+
+    SECTION("a copy outlives the source")
+    {
+        auto make = [] {
+            shared_cow<std::string> source { "Hello, World!" };
+            auto copy = source;
+            return copy;
+        };
+
+        auto c = make();
+
+        REQUIRE_FALSE(c.shared());
+        REQUIRE(*c.operator->() == "Hello, World!");
+    }
+
+    SECTION("get_mutable copies only when shared")
+    {
+        shared_cow<std::string> a { "Hello, World!" };
+        const auto* original = &a.get_const();
+
+        // not shared, so this mutates in place
+        a.get_mutable() += "!";
+        REQUIRE(&a.get_const() == original);
+
+        auto b = a;
+        b.get_mutable() = "Goodbye, World!";
+
+        REQUIRE(&a.get_const() == original);
+        REQUIRE(a.get_const() == "Hello, World!!");
+        REQUIRE(b.get_const() == "Goodbye, World!");
+        REQUIRE_FALSE(a.shared());
+        REQUIRE_FALSE(b.shared());
+    }
+
+    SECTION("set replaces a shared value without touching the other owners")
+    {
+        shared_cow<std::string> a { std::in_place, 5u, 'a' };
+        auto b = a;
+
+        b.set("bbbbb");
+        REQUIRE(a.get_const() == "aaaaa");
+        REQUIRE(b.get_const() == "bbbbb");
+
+        a = std::string { "ccccc" };
+        REQUIRE(a.get_const() == "ccccc");
+    }
+
+    SECTION("assignment")
+    {
+        shared_cow<std::string> a { "a" };
+        shared_cow<std::string> b { "b" };
+
+        b = a;
+        REQUIRE(&a.get_const() == &b.get_const());
+
+        shared_cow<std::string> c { "c" };
+        c = std::move(b);
+        REQUIRE(&a.get_const() == &c.get_const());
+
+        c = c;
+        REQUIRE(c.get_const() == "a");
+    }
+
+    SECTION("snapshots can be passed between threads")
+    {
+        shared_cow<std::vector<size_t>> snapshot { std::vector<size_t>(1024, 1) };
+
+        std::atomic<size_t> mismatches { 0 };
+        std::vector<std::thread> stages;
+        for (size_t t = 0; t < 8; ++t) {
+            stages.emplace_back([copy = snapshot, t, &mismatches]() mutable {
+                for (size_t i = 0; i < 100; ++i) {
+                    auto local = copy;
+                    if (t % 2 == 0) {
+                        local.get_mutable()[i] = t;
+                        if (local.get_const()[i] != t) {
+                            ++mismatches;
+                        }
+                    } else if (local.get_const()[i] != 1) {
+                        ++mismatches;
+                    }
+                }
+            });
+        }
+        for (auto& stage : stages) {
+            stage.join();
+        }
+
+        REQUIRE(mismatches == 0);
+        REQUIRE(snapshot.get_const() == std::vector<size_t>(1024, 1));
+        REQUIRE_FALSE(snapshot.shared());
+    }
+}
+
+TEST_CASE("cow slices", "[cow]")
+{
+    using namespace std::string_view_literals;
+
+    const std::string record { "GET /index.html 200" };
+
+    SECTION("slices borrow from the parent buffer")
+    {
+        cow_string line { std::cref(record) };
+        auto method = line.slice(0, 3);
+        auto path = line.slice(4, 11);
+        auto status = line.slice(16);
+
+        REQUIRE(method.borrowed());
+        REQUIRE(method.get_const() == "GET");
+        REQUIRE(path.get_const() == "/index.html");
+        REQUIRE(status.get_const() == "200");
+        REQUIRE(path.get_const().data() == record.data() + 4);
+
+        // out of range slices are clamped
+        REQUIRE(line.slice(16, 100).get_const() == "200");
+        REQUIRE(line.slice(100).empty());
+    }
+
+    SECTION("get_mutable materializes only the slice")
+    {
+        cow_string path = cow_string { std::cref(record) }.slice(4, 11);
+
+        path.get_mutable() += "?page=2";
+
+        REQUIRE_FALSE(path.borrowed());
+        REQUIRE(path.get_const() == "/index.html?page=2");
+        REQUIRE(record == "GET /index.html 200");
+
+        // owned slices mutate in place from then on
+        const auto* data = path.get_mutable().data();
+        path.get_mutable()[0] = '\\';
+        REQUIRE(path.get_const().data() == data);
+    }
+
+    SECTION("owned and borrowed slices compare by content")
+    {
+        cow_string owned { std::string { "200" } };
+        cow_string borrowed { "200"sv };
+
+        REQUIRE_FALSE(owned.borrowed());
+        REQUIRE(borrowed.borrowed());
+        REQUIRE(owned == borrowed);
+        REQUIRE_FALSE(owned == cow_string { "404"sv });
+        REQUIRE(owned.size() == 3);
+    }
+
+    SECTION("set")
+    {
+        cow_string s;
+        REQUIRE(s.empty());
+        REQUIRE(s.borrowed());
+
+        s.set(std::string { "owned" });
+        REQUIRE_FALSE(s.borrowed());
+
+        s.set("borrowed"sv);
+        REQUIRE(s.borrowed());
+        REQUIRE(s.get_const() == "borrowed");
+    }
+
+    SECTION("bytes")
+    {
+        const std::vector<std::byte> buffer { std::byte { 1 }, std::byte { 2 }, std::byte { 3 }, std::byte { 4 } };
+
+        cow_bytes whole { std::cref(buffer) };
+        auto payload = whole.slice(1, 2);
+
+        REQUIRE(payload.borrowed());
+        REQUIRE(payload.get_const().data() == buffer.data() + 1);
+
+        payload.get_mutable().push_back(std::byte { 5 });
+
+        REQUIRE(payload == cow_bytes { std::vector<std::byte> { std::byte { 2 }, std::byte { 3 }, std::byte { 5 } } });
+        REQUIRE(buffer.size() == 4);
+    }
+}
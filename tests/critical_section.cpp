@@ -1,9 +1,15 @@
 #include <catch2/catch.hpp>
 
+#include "detached.hpp"
+
 #include <safet/critical_section.hpp>
+#include <safet/mutex.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <numeric>
 #include <thread>
+#include <vector>
 
 using namespace safet;
 
@@ -306,4 +312,316 @@ TEST_CASE("critical_section::try_enter()", "[critical_section]")
             }
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("shared_critical_section", "[critical_section]")
+{
+    shared_critical_section<std::string> s { 5, 'a' };
+    const auto& c_s = s;
+
+    SECTION("readers do not exclude each other")
+    {
+        c_s.enter([&](const std::string& value) {
+            REQUIRE(value == "aaaaa");
+
+            // a second reader on another thread must be able to enter while we're still inside
+            bool entered = false;
+            std::thread reader { [&]() {
+                entered = c_s.try_enter([](const std::string& value) {
+                    REQUIRE(value == "aaaaa");
+                });
+            } };
+            reader.join();
+
+            REQUIRE(entered);
+        });
+    }
+
+    SECTION("readers exclude writers")
+    {
+        c_s.enter([&](const std::string&) {
+            bool entered = true;
+            std::thread writer { [&]() {
+                entered = s.try_enter([](std::string&) {
+                    FAIL("try_enter must not call a mutable functor while readers are inside");
+                });
+            } };
+            writer.join();
+
+            REQUIRE_FALSE(entered);
+        });
+    }
+
+    SECTION("writers exclude readers")
+    {
+        s.enter([&](std::string& value) {
+            value += "bbbbb";
+
+            optional<size_t> size = 0;
+            std::thread reader { [&]() {
+                size = c_s.try_enter([](const std::string& value) {
+                    FAIL("try_enter must not call a const functor while a writer is inside");
+
+                    return value.size();
+                });
+            } };
+            reader.join();
+
+            REQUIRE(size.empty());
+        });
+
+        REQUIRE(c_s.enter([](const std::string& value) { return value; }) == "aaaaabbbbb");
+    }
+
+    SECTION("assignment takes the exclusive lock")
+    {
+        s = std::string { "ccc" };
+
+        REQUIRE(c_s.enter([](const std::string& value) { return value; }) == "ccc");
+    }
+}
+
+TEST_CASE("safet::enter() and safet::try_enter() over multiple critical_sections", "[critical_section]")
+{
+    critical_section<int> a { 100 };
+    critical_section<int> b { 0 };
+    shared_critical_section<std::string> log { "" };
+    const auto& c_log = log;
+
+    SECTION("enter passes every value to the functor")
+    {
+        auto total = enter(a, b, log, [](int& a_value, int& b_value, std::string& log_value) {
+            a_value -= 10;
+            b_value += 10;
+            log_value += "transfer";
+
+            return a_value + b_value;
+        });
+
+        REQUIRE(total == 100);
+        REQUIRE(a.enter([](int value) { return value; }) == 90);
+        REQUIRE(b.enter([](int value) { return value; }) == 10);
+        REQUIRE(c_log.enter([](const std::string& value) { return value; }) == "transfer");
+    }
+
+    SECTION("const sections are passed as const references")
+    {
+        enter(a, c_log, [](int& a_value, const std::string& log_value) {
+            REQUIRE(a_value == 100);
+            REQUIRE(log_value.empty());
+        });
+    }
+
+    SECTION("opposite lock orders do not deadlock")
+    {
+        constexpr size_t transfers = 10000;
+
+        std::thread a_to_b { [&]() {
+            for (size_t i = 0; i < transfers; ++i) {
+                enter(a, b, [](int& from, int& to) { --from; ++to; });
+            }
+        } };
+        std::thread b_to_a { [&]() {
+            for (size_t i = 0; i < transfers; ++i) {
+                enter(b, a, [](int& from, int& to) { --from; ++to; });
+            }
+        } };
+
+        a_to_b.join();
+        b_to_a.join();
+
+        REQUIRE(enter(a, b, [](int a_value, int b_value) { return a_value + b_value; }) == 100);
+    }
+
+    SECTION("try_enter succeeds when every section is free")
+    {
+        auto retval = try_enter(a, b, [](int& a_value, int& b_value) { return a_value + b_value; });
+        REQUIRE(retval == 100);
+
+        auto called = try_enter(a, b, [](int&, int&) {});
+        REQUIRE(called);
+    }
+
+    SECTION("try_enter fails when any section is held")
+    {
+        b.enter([&](int&) {
+            std::thread other { [&]() {
+                auto retval = try_enter(a, b, [](int&, int&) {
+                    FAIL("try_enter must not call the functor when any critical_section is already entered");
+
+                    return 1;
+                });
+                REQUIRE(retval.empty());
+
+                auto called = try_enter(a, b, [](int&, int&) {
+                    FAIL("try_enter must not call the functor when any critical_section is already entered");
+                });
+                REQUIRE_FALSE(called);
+            } };
+            other.join();
+        });
+
+        // a must have been released by the failed attempt
+        REQUIRE(a.try_enter([](int& value) { return value; }) == 100);
+    }
+}
+
+TEST_CASE("critical_section::try_enter_for() and critical_section::try_enter_until()", "[critical_section]")
+{
+    critical_section<std::string, std::timed_mutex> s { 5, 'a' };
+    const auto& c_s = s;
+
+    SECTION("when access is obtained before the deadline")
+    {
+        auto retval = s.try_enter_for(std::chrono::milliseconds { 10 }, [](std::string& value) {
+            value += "bbbbb";
+
+            return value.size();
+        });
+        REQUIRE(retval == 10u);
+
+        auto called = c_s.try_enter_until(std::chrono::steady_clock::now() + std::chrono::milliseconds { 10 }, [](const std::string& value) {
+            REQUIRE(value == "aaaaabbbbb");
+        });
+        REQUIRE(called);
+
+        auto moved = std::move(s).try_enter_for(std::chrono::milliseconds { 10 }, [](std::string&& value) { return std::move(value); });
+        REQUIRE(moved == "aaaaabbbbb");
+    }
+
+    SECTION("when the lock is released while waiting")
+    {
+        std::atomic<bool> entered { false };
+        std::thread holder { [&]() {
+            s.enter([&](std::string&) {
+                entered = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds { 5 });
+            });
+        } };
+
+        while (!entered) {
+            std::this_thread::yield();
+        }
+
+        auto called = s.try_enter_for(std::chrono::seconds { 10 }, [](std::string&) {});
+        holder.join();
+
+        REQUIRE(called);
+    }
+
+    SECTION("when the deadline passes")
+    {
+        s.enter([&](std::string&) {
+            std::thread other { [&]() {
+                const auto start = std::chrono::steady_clock::now();
+
+                auto retval = s.try_enter_for(std::chrono::milliseconds { 5 }, [](std::string&) {
+                    FAIL("try_enter_for must not call the functor if the deadline passes");
+
+                    return 1;
+                });
+                REQUIRE(retval.empty());
+                REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds { 5 });
+
+                auto called = c_s.try_enter_until(std::chrono::steady_clock::now(), [](const std::string&) {
+                    FAIL("try_enter_until must not call the functor if the deadline passes");
+                });
+                REQUIRE_FALSE(called);
+            } };
+            other.join();
+        });
+    }
+
+    SECTION("with a shared timed mutex")
+    {
+        critical_section<int, std::shared_timed_mutex> shared { 1 };
+        const auto& c_shared = shared;
+
+        c_shared.enter([&](const int&) {
+            std::thread other { [&]() {
+                REQUIRE(c_shared.try_enter_for(std::chrono::milliseconds { 5 }, [](const int& value) { return value; }) == 1);
+                REQUIRE_FALSE(shared.try_enter_for(std::chrono::milliseconds { 1 }, [](int&) {}));
+            } };
+            other.join();
+        });
+    }
+}
+
+TEST_CASE("critical_section::enter_async()", "[critical_section]")
+{
+    critical_section<std::vector<int>, async_mutex> cs;
+
+    SECTION("completes without suspending when uncontended")
+    {
+        size_t result = 0;
+        // coroutine lambdas must not capture, the captures would be destroyed along with the lambda while suspended
+        [](auto& cs, size_t& result) -> detached {
+            result = co_await cs.enter_async([](std::vector<int>& v) {
+                v.push_back(1);
+                return v.size();
+            });
+        }(cs, result);
+
+        REQUIRE(result == 1);
+    }
+
+    SECTION("suspends while held and resumes in order once released")
+    {
+        std::vector<size_t> resumed;
+
+        cs.enter([&](std::vector<int>&) {
+            // far more than would fit on the stack if each handoff resumed the next waiter recursively
+            for (int i = 0; i < 100000; ++i) {
+                [](auto& cs, std::vector<size_t>& resumed, int i) -> detached {
+                    const auto size = co_await cs.enter_async([i](std::vector<int>& v) {
+                        v.push_back(i);
+                        return v.size();
+                    });
+                    resumed.push_back(size);
+                }(cs, resumed, i);
+            }
+
+            REQUIRE(resumed.empty());
+        });
+
+        std::vector<int> expected_values(100000);
+        std::iota(expected_values.begin(), expected_values.end(), 0);
+        std::vector<size_t> expected_sizes(100000);
+        std::iota(expected_sizes.begin(), expected_sizes.end(), 1);
+
+        REQUIRE(resumed == expected_sizes);
+        REQUIRE(cs.enter([&](const std::vector<int>& v) { return v == expected_values; }));
+    }
+
+    SECTION("coroutines and threads share the lock")
+    {
+        critical_section<size_t, async_mutex> counter { 0u };
+
+        constexpr size_t thread_count = 4;
+        constexpr size_t increments = 10000;
+
+        std::vector<std::thread> v;
+        for (size_t i = 0; i < thread_count; ++i) {
+            v.emplace_back([&, i]() {
+                for (size_t j = 0; j < increments; ++j) {
+                    auto increment = [](size_t& value) {
+                        auto copy = value;
+                        value = copy + 1;
+                    };
+
+                    if (i % 2 == 0) {
+                        counter.enter(increment);
+                    } else {
+                        [](auto& counter, auto increment) -> detached { co_await counter.enter_async(increment); }(counter, increment);
+                    }
+                }
+            });
+        }
+
+        for (auto& t : v) {
+            t.join();
+        }
+
+        REQUIRE(counter.enter([](const size_t& value) { return value; }) == thread_count * increments);
+    }
+}
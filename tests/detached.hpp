@@ -0,0 +1,15 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+// the minimal coroutine type, starting eagerly and destroying itself once complete
+struct detached {
+    struct promise_type {
+        auto get_return_object() -> detached { return {}; }
+        auto initial_suspend() -> std::suspend_never { return {}; }
+        auto final_suspend() noexcept -> std::suspend_never { return {}; }
+        auto return_void() -> void { }
+        auto unhandled_exception() -> void { std::terminate(); }
+    };
+};
@@ -2,6 +2,12 @@
 
 #include <safet/finally.hpp>
 
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 using namespace safet;
 
 TEST_CASE("finally example use cases", "[finally]")
@@ -94,4 +100,184 @@ TEST_CASE("finally construtors", "[finally]")
     // f_copy and f_move both destruct, f no longer should hold any functor
     // and should not result in a call
     REQUIRE(call_count == 2);
-}
\ No newline at end of file
+}
+TEST_CASE("finally assignment", "[finally]")
+{
+    size_t first_count { 0 };
+    size_t second_count { 0 };
+    auto make = [](size_t& count) { return finally { [&count]() { ++count; } }; };
+
+    SECTION("copy assignment runs the pending cleanup, just as destroying it would")
+    {
+        {
+            auto first = make(first_count);
+            const auto second = make(second_count);
+
+            first = second;
+            REQUIRE(first_count == 1);
+            REQUIRE(second_count == 0);
+        }
+
+        // both now hold the second cleanup
+        REQUIRE(first_count == 1);
+        REQUIRE(second_count == 2);
+    }
+
+    SECTION("move assignment runs the pending cleanup and takes over the other one")
+    {
+        {
+            auto first = make(first_count);
+            auto second = make(second_count);
+
+            first = std::move(second);
+            REQUIRE(first_count == 1);
+            REQUIRE(second_count == 0);
+        }
+
+        REQUIRE(first_count == 1);
+        REQUIRE(second_count == 1);
+    }
+
+    SECTION("self assignment keeps the pending cleanup")
+    {
+        {
+            auto first = make(first_count);
+            auto& alias = first;
+
+            first = alias;
+            first = std::move(alias);
+            REQUIRE(first_count == 0);
+        }
+
+        REQUIRE(first_count == 1);
+    }
+}
+
+TEST_CASE("scope guards", "[finally]")
+{
+    size_t call_count { 0 };
+    auto increment = [&]() { ++call_count; };
+
+    SECTION("the functor is stored next to a single flag")
+    {
+        STATIC_REQUIRE(sizeof(scope_exit<decltype(increment)>) == 2 * sizeof(void*));
+        STATIC_REQUIRE_FALSE(std::is_copy_constructible_v<scope_exit<decltype(increment)>>);
+        STATIC_REQUIRE(std::is_nothrow_move_constructible_v<scope_exit<decltype(increment)>>);
+    }
+
+    SECTION("scope_exit runs once however it's moved")
+    {
+        {
+            scope_exit guard { increment };
+            scope_exit moved { std::move(guard) };
+            REQUIRE(call_count == 0);
+        }
+        REQUIRE(call_count == 1);
+    }
+
+    SECTION("release dismisses the guard")
+    {
+        {
+            scope_exit guard { increment };
+            guard.release();
+        }
+        REQUIRE(call_count == 0);
+    }
+
+    SECTION("scope_fail and scope_success on a normal exit")
+    {
+        size_t success_count { 0 };
+        {
+            scope_fail fail_guard { increment };
+            scope_success success_guard { [&]() { ++success_count; } };
+        }
+        REQUIRE(call_count == 0);
+        REQUIRE(success_count == 1);
+    }
+
+    SECTION("scope_fail and scope_success on an exception")
+    {
+        size_t success_count { 0 };
+        try {
+            scope_fail fail_guard { increment };
+            scope_success success_guard { [&]() { ++success_count; } };
+            throw std::runtime_error("unwinding");
+        } catch (const std::runtime_error&) {
+        }
+        REQUIRE(call_count == 1);
+        REQUIRE(success_count == 0);
+    }
+
+    SECTION("a guard created during unwinding judges only its own scope")
+    {
+        size_t success_count { 0 };
+        try {
+            scope_exit unwinding { [&]() {
+                scope_fail fail_guard { increment };
+                scope_success success_guard { [&]() { ++success_count; } };
+            } };
+            throw std::runtime_error("unwinding");
+        } catch (const std::runtime_error&) {
+        }
+        REQUIRE(call_count == 0);
+        REQUIRE(success_count == 1);
+    }
+}
+
+TEST_CASE("finally_stack", "[finally]")
+{
+    std::vector<int> order;
+
+    SECTION("actions run last in first out")
+    {
+        {
+            finally_stack<128> stack;
+            REQUIRE(stack.push([&]() { order.push_back(1); }));
+            REQUIRE(stack.push([&]() { order.push_back(2); }));
+            REQUIRE(stack.push([&, big = std::array<char, 17> {}]() { order.push_back(3 + big[0]); }));
+            REQUIRE(stack.size() == 3);
+            REQUIRE(order.empty());
+        }
+        REQUIRE(order == std::vector<int> { 3, 2, 1 });
+    }
+
+    SECTION("push fails without storing when full")
+    {
+        {
+            finally_stack<2 * (2 * sizeof(void*) + sizeof(void*))> stack;
+            REQUIRE(stack.push([&]() { order.push_back(1); }));
+            REQUIRE(stack.push([&]() { order.push_back(2); }));
+            REQUIRE_FALSE(stack.push([&]() { order.push_back(3); }));
+            REQUIRE(stack.size() == 2);
+        }
+        REQUIRE(order == std::vector<int> { 2, 1 });
+    }
+
+    SECTION("release commits, dismissing every action")
+    {
+        {
+            finally_stack<64> stack;
+            REQUIRE(stack.push([&]() { order.push_back(1); }));
+            stack.release();
+            REQUIRE(stack.empty());
+            // the space is reused
+            REQUIRE(stack.push([&]() { order.push_back(2); }));
+        }
+        REQUIRE(order == std::vector<int> { 2 });
+    }
+
+    SECTION("stored functors are destroyed exactly once")
+    {
+        auto tracked = std::make_shared<int>(0);
+        {
+            finally_stack<64> stack;
+            REQUIRE(stack.push([tracked]() { ++*tracked; }));
+            REQUIRE(stack.push([tracked]() { ++*tracked; }));
+            REQUIRE(tracked.use_count() == 3);
+            stack.run();
+            REQUIRE(tracked.use_count() == 1);
+            REQUIRE(*tracked == 2);
+        }
+        REQUIRE(*tracked == 2);
+    }
+}
@@ -0,0 +1,315 @@
+#include <catch2/catch.hpp>
+
+#include <safet/future.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("future example use cases", "[future]")
+{
+    SECTION("a chain of continuations runs on the thread completing the promise")
+    {
+        auto [p, f] = make_promise<int>();
+
+        auto chained = std::move(f)
+                           .then([](int value) { return value * 2; })
+                           .then([](int value) { return std::to_string(value); })
+                           .then([](std::string value) { return value + "!"; });
+
+        REQUIRE_FALSE(chained.ready());
+
+        std::thread producer { [p = std::move(p)]() mutable { p.set_value(21); } };
+        producer.join();
+
+        REQUIRE(chained.ready());
+        REQUIRE(std::move(chained).value() == "42!");
+    }
+
+    SECTION("errors skip continuations")
+    {
+        size_t calls = 0;
+        auto result = make_error_future<int>(std::make_error_code(std::errc::timed_out))
+                          .then([&](int value) {
+                              ++calls;
+                              return value;
+                          })
+                          .error();
+
+        REQUIRE(calls == 0);
+        REQUIRE(result == std::make_error_code(std::errc::timed_out));
+    }
+}
+
+TEST_CASE("promise", "[future]")
+{
+    SECTION("destroying an unsatisfied promise breaks it")
+    {
+        auto f = [] {
+            auto [p, f] = make_promise<int>();
+            return std::move(f);
+        }();
+
+        REQUIRE(f.ready());
+        REQUIRE(std::move(f).error() == future_errc::broken_promise);
+    }
+
+    SECTION("results can only be set once")
+    {
+        auto [p, f] = make_promise<int>();
+
+        REQUIRE_FALSE(p.satisfied());
+        REQUIRE(p.set_value(1));
+        REQUIRE(p.satisfied());
+        REQUIRE_FALSE(p.set_value(2));
+        REQUIRE_FALSE(p.set_error(future_errc::broken_promise));
+
+        REQUIRE(std::move(f).value() == 1);
+    }
+
+    SECTION("custom error types")
+    {
+        struct error {
+            error(future_errc)
+                : m_message("broken")
+            {
+            }
+            error(std::string message)
+                : m_message(std::move(message))
+            {
+            }
+
+            std::string m_message;
+        };
+
+        auto [p, f] = make_promise<int, error>();
+        p.set_error(error { "failed" });
+
+        REQUIRE(std::move(f).error().if_set([](error&& e) { return e.m_message; }) == "failed");
+    }
+}
+
+TEST_CASE("future", "[future]")
+{
+    SECTION("results are consumed once")
+    {
+        auto f = make_ready_future<std::string>(3, 'a');
+
+        REQUIRE(f.valid());
+        REQUIRE(std::move(f).value() == "aaa");
+        REQUIRE_FALSE(f.valid());
+        REQUIRE(std::move(f).result().empty());
+    }
+
+    SECTION("wait blocks until the promise is satisfied")
+    {
+        auto [p, f] = make_promise<int>();
+
+        std::thread producer { [p = std::move(p)]() mutable {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            p.set_value(5);
+        } };
+
+        f.wait();
+        REQUIRE(f.ready());
+        REQUIRE(std::move(f).value() == 5);
+
+        producer.join();
+    }
+
+    SECTION("continuations on ready futures run immediately")
+    {
+        bool ran = false;
+        auto f = make_ready_future<int>(1).then([&](int) { ran = true; });
+
+        REQUIRE(ran);
+        REQUIRE(f.ready());
+    }
+
+    SECTION("void futures")
+    {
+        auto [p, f] = make_promise<void>();
+        auto next = std::move(f).then([]() { return 3; });
+
+        p.set_value();
+        REQUIRE(std::move(next).value() == 3);
+    }
+
+    SECTION("move only and large continuations")
+    {
+        std::array<int, 64> large {};
+        large.back() = 7;
+
+        auto f = make_ready_future<std::unique_ptr<int>>(std::make_unique<int>(2))
+                     .then([owned = std::make_unique<int>(3)](std::unique_ptr<int> value) { return *value + *owned; })
+                     .then([large](int value) { return value + large.back(); });
+
+        REQUIRE(std::move(f).value() == 12);
+    }
+
+    SECTION("continuations returning futures are flattened")
+    {
+        auto [inner_promise, inner] = make_promise<std::string>();
+
+        auto f = make_ready_future<int>(1).then([inner = std::move(inner)](int) mutable { return std::move(inner); });
+        static_assert(std::is_same_v<decltype(f), future<std::string>>);
+
+        REQUIRE_FALSE(f.ready());
+        inner_promise.set_value("done");
+        REQUIRE(std::move(f).value() == "done");
+    }
+}
+
+TEST_CASE("when_all", "[future]")
+{
+    SECTION("variadic")
+    {
+        auto [p1, f1] = make_promise<int>();
+        auto [p2, f2] = make_promise<std::string>();
+
+        auto all = when_all(std::move(f1), std::move(f2), make_ready_future<void>());
+
+        p2.set_value("b");
+        REQUIRE_FALSE(all.ready());
+        p1.set_value(1);
+
+        auto values = std::move(all).value();
+        REQUIRE_FALSE(values.empty());
+        values.if_set([](auto& tuple) {
+            REQUIRE(std::get<0>(tuple) == 1);
+            REQUIRE(std::get<1>(tuple) == "b");
+        });
+    }
+
+    SECTION("the first error completes immediately")
+    {
+        auto [p1, f1] = make_promise<int>();
+        auto [p2, f2] = make_promise<int>();
+
+        auto all = when_all(std::move(f1), std::move(f2));
+        p2.set_error(std::make_error_code(std::errc::io_error));
+
+        REQUIRE(all.ready());
+        REQUIRE(std::move(all).error() == std::make_error_code(std::errc::io_error));
+    }
+
+    SECTION("vector across threads")
+    {
+        std::vector<promise<size_t>> promises;
+        std::vector<future<size_t>> futures;
+        for (size_t i = 0; i < 64; ++i) {
+            auto [p, f] = make_promise<size_t>();
+            promises.push_back(std::move(p));
+            futures.push_back(std::move(f));
+        }
+
+        auto all = when_all(std::move(futures));
+
+        std::vector<std::thread> producers;
+        for (size_t t = 0; t < 4; ++t) {
+            producers.emplace_back([&, t]() {
+                for (size_t i = t; i < promises.size(); i += 4) {
+                    promises[i].set_value(i * i);
+                }
+            });
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+
+        auto values = std::move(all).value();
+        REQUIRE_FALSE(values.empty());
+        values.if_set([](std::vector<size_t>& v) {
+            REQUIRE(v.size() == 64);
+            for (size_t i = 0; i < v.size(); ++i) {
+                REQUIRE(v[i] == i * i);
+            }
+        });
+    }
+
+    SECTION("empty vector")
+    {
+        REQUIRE(when_all(std::vector<future<int>> {}).value() == std::vector<int> {});
+    }
+}
+
+TEST_CASE("future_impl::block_pool", "[future]")
+{
+    // a size no shared state has, so this thread's list starts empty
+    using pool = future_impl::block_pool<40, 8>;
+
+    SECTION("blocks freed on another thread go back to the thread that allocated them")
+    {
+        std::vector<void*> blocks(16);
+        for (auto& block : blocks) {
+            block = pool::allocate();
+        }
+
+        std::thread other { [&]() {
+            for (auto* block : blocks) {
+                pool::deallocate(block);
+            }
+        } };
+        other.join();
+
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            auto* block = pool::allocate();
+            REQUIRE(std::find(blocks.begin(), blocks.end(), block) != blocks.end());
+        }
+        for (auto* block : blocks) {
+            pool::deallocate(block);
+        }
+    }
+
+    SECTION("blocks outliving the thread that allocated them are freed by whoever frees them")
+    {
+        std::vector<void*> blocks(16);
+        std::thread other { [&]() {
+            for (auto& block : blocks) {
+                block = pool::allocate();
+            }
+            // one freed into the thread's own list before it exits, the rest after
+            pool::deallocate(blocks.back());
+            blocks.pop_back();
+        } };
+        other.join();
+
+        for (auto* block : blocks) {
+            pool::deallocate(block);
+        }
+    }
+}
+
+TEST_CASE("when_any", "[future]")
+{
+    SECTION("the first success wins")
+    {
+        auto [p1, f1] = make_promise<int>();
+        auto [p2, f2] = make_promise<int>();
+        std::vector<future<int>> futures;
+        futures.push_back(std::move(f1));
+        futures.push_back(std::move(f2));
+
+        auto any = when_any(std::move(futures));
+
+        p1.set_error(std::make_error_code(std::errc::io_error));
+        REQUIRE_FALSE(any.ready());
+        p2.set_value(2);
+
+        REQUIRE(std::move(any).value() == std::pair<size_t, int> { 1, 2 });
+    }
+
+    SECTION("the last error is reported when all fail")
+    {
+        std::vector<future<int>> futures;
+        futures.push_back(make_error_future<int>(std::make_error_code(std::errc::io_error)));
+        futures.push_back(make_error_future<int>(std::make_error_code(std::errc::timed_out)));
+
+        REQUIRE(when_any(std::move(futures)).error() == std::make_error_code(std::errc::timed_out));
+    }
+}
@@ -3,6 +3,13 @@
 #include <safet/finally.hpp>
 #include <safet/memory.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 using namespace safet;
 
 template <typename T>
@@ -406,4 +413,317 @@ TEST_CASE("weak_ptr::clear()", "[weak_ptr]")
 
     REQUIRE(a.lock().empty());
     REQUIRE(b.lock().empty());
-}
\ No newline at end of file
+}
+// counts what passes through to the wrapped resource, to check everything allocated is returned
+template <typename Resource>
+struct counting_resource {
+    auto allocate(size_t size, size_t alignment) -> void*
+    {
+        ++allocations;
+        return resource.allocate(size, alignment);
+    }
+
+    auto deallocate(void* memory, size_t size, size_t alignment) -> void
+    {
+        ++deallocations;
+        resource.deallocate(memory, size, alignment);
+    }
+
+    Resource resource;
+    size_t allocations { 0 };
+    size_t deallocations { 0 };
+};
+
+TEST_CASE("arena", "[memory]")
+{
+    SECTION("allocations are aligned and don't overlap")
+    {
+        arena a { 64 };
+
+        auto* c = static_cast<char*>(a.allocate(1, 1));
+        auto* d = static_cast<double*>(a.allocate(sizeof(double), alignof(double)));
+        auto* big = a.allocate(1000, 64);
+
+        REQUIRE(reinterpret_cast<uintptr_t>(d) % alignof(double) == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+        REQUIRE(static_cast<void*>(c) != static_cast<void*>(d));
+
+        *c = 'c';
+        *d = 1.0;
+        std::fill_n(static_cast<char*>(big), 1000, 'x');
+        REQUIRE(*c == 'c');
+        REQUIRE(*d == 1.0);
+    }
+
+    SECTION("reset reuses the largest chunk")
+    {
+        arena a { 64 };
+
+        std::vector<void*> starts;
+        for (size_t round = 0; round < 4; ++round) {
+            a.reset();
+
+            starts.push_back(a.allocate(16));
+            for (size_t i = 0; i < 100; ++i) {
+                a.allocate(16);
+            }
+        }
+
+        // once a round has grown a chunk that fits all of it, every later round is served from that chunk alone
+        REQUIRE(starts[3] == starts[2]);
+    }
+}
+
+TEST_CASE("pool", "[memory]")
+{
+    pool p;
+
+    SECTION("deallocated blocks are reused by allocations of the same size class")
+    {
+        auto* a = p.allocate(24);
+        p.deallocate(a, 24);
+        auto* b = p.allocate(32);
+
+        REQUIRE(a == b);
+
+        auto* c = p.allocate(33);
+        REQUIRE(c != b);
+
+        p.deallocate(b, 32);
+        p.deallocate(c, 33);
+    }
+
+    SECTION("large and over-aligned allocations go to the global allocator")
+    {
+        auto* large = p.allocate(pool::max_block_size + 1);
+        auto* aligned = p.allocate(64, 128);
+
+        REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 128 == 0);
+
+        p.deallocate(large, pool::max_block_size + 1);
+        p.deallocate(aligned, 64, 128);
+    }
+}
+
+TEST_CASE("make_unique_in", "[memory]")
+{
+    SECTION("the object is destroyed and its memory returned to the resource")
+    {
+        counting_resource<pool> resource;
+        bool destroyed = false;
+
+        {
+            auto ptr = make_unique_in<finally<std::function<void()>>>(resource, [&]() { destroyed = true; });
+            REQUIRE_FALSE(ptr.empty());
+            REQUIRE(resource.allocations == 1);
+        }
+
+        REQUIRE(destroyed);
+        REQUIRE(resource.deallocations == 1);
+    }
+
+    SECTION("clear returns the memory")
+    {
+        counting_resource<pool> resource;
+        auto ptr = make_unique_in<int>(resource, 5);
+
+        REQUIRE(ptr.deref() == 5);
+        ptr.clear();
+        REQUIRE(resource.deallocations == 1);
+    }
+
+    SECTION("a throwing constructor returns the memory")
+    {
+        struct throws {
+            throws()
+            {
+                throw std::runtime_error { "construction" };
+            }
+        };
+
+        counting_resource<arena> resource;
+
+        REQUIRE_THROWS(make_unique_in<throws>(resource));
+        REQUIRE(resource.allocations == resource.deallocations);
+    }
+}
+
+TEST_CASE("make_shared_in", "[memory]")
+{
+    counting_resource<pool> resource;
+
+    {
+        auto s_ptr = make_shared_in<std::string>(resource, 100u, 'x');
+        auto copy = s_ptr;
+        weak_ptr<std::string> w_ptr { copy };
+
+        // the object and the reference counts are one allocation
+        REQUIRE(resource.allocations == 1);
+        REQUIRE(w_ptr.lock().deref().if_set([](std::string& s) { return s.size(); }) == 100u);
+    }
+
+    REQUIRE(resource.deallocations == 1);
+
+    SECTION("allocate_shared with a standard allocator over an arena")
+    {
+        arena a;
+        auto s_ptr = allocate_shared<int>(resource_allocator<int, arena> { a }, 7);
+
+        REQUIRE(s_ptr.deref() == 7);
+    }
+}
+
+TEST_CASE("local_shared_ptr", "[memory]")
+{
+    SECTION("shares a single object")
+    {
+        auto a = make_local_shared<std::string>(3, 'x');
+        auto b = a;
+
+        REQUIRE(a.deref() == "xxx");
+        b.deref().if_set([](std::string& value) { value += "y"; });
+        REQUIRE(a.deref() == "xxxy");
+    }
+    SECTION("the last owner destroys the object")
+    {
+        size_t destroyed = 0;
+        {
+            auto a = make_local_shared<finally<std::function<void()>>>([&destroyed]() { ++destroyed; });
+            local_shared_ptr<finally<std::function<void()>>> b { a };
+            local_shared_ptr<finally<std::function<void()>>> c {};
+
+            a.clear();
+            REQUIRE(destroyed == 0);
+            c = std::move(b);
+            REQUIRE(b.empty());
+            REQUIRE(destroyed == 0);
+        }
+
+        REQUIRE(destroyed == 1);
+    }
+    SECTION("assignment")
+    {
+        auto a = make_local_shared<int>(1);
+        auto b = make_local_shared<int>(2);
+
+        a = a;
+        REQUIRE(a.deref() == 1);
+
+        a = b;
+        REQUIRE(a.deref() == 2);
+        b.clear();
+        REQUIRE(a.deref() == 2);
+        REQUIRE(b.deref().empty());
+    }
+    SECTION("local_weak_ptr observes without owning")
+    {
+        local_weak_ptr<int> weak {};
+        REQUIRE(weak.lock().empty());
+
+        {
+            auto shared = make_local_shared<int>(5);
+            weak = shared;
+            local_weak_ptr<int> copy { weak };
+
+            REQUIRE(weak.lock().deref() == 5);
+            REQUIRE(copy.lock().deref() == 5);
+        }
+
+        // the object is gone, but the block stays for as long as the weak pointer does
+        REQUIRE(weak.lock().empty());
+        weak.clear();
+        REQUIRE(weak.lock().empty());
+    }
+}
+
+namespace {
+struct counted_node : intrusive_ref_counted {
+    counted_node(int value, size_t& destroyed)
+        : value(value)
+        , destroyed(destroyed)
+    {
+    }
+
+    virtual ~counted_node()
+    {
+        ++destroyed;
+    }
+
+    int value;
+    size_t& destroyed;
+};
+
+struct derived_node : counted_node {
+    using counted_node::counted_node;
+
+    intrusive_weak_ptr<derived_node> self;
+};
+
+auto value_of(const intrusive_ptr<counted_node>& ptr) -> int
+{
+    return ptr.deref().if_set([](const counted_node& node) { return node.value; }).value_or([]() { return -1; });
+}
+}
+
+TEST_CASE("intrusive_ptr", "[memory]")
+{
+    size_t destroyed = 0;
+
+    SECTION("the count lives in the object")
+    {
+        {
+            auto a = make_intrusive<counted_node>(1, destroyed);
+            // a second pointer made from the raw pointer shares the count
+            intrusive_ptr<counted_node> b {};
+            a.deref().if_set([&b](counted_node& node) { b = intrusive_ptr<counted_node> { &node }; });
+
+            a.clear();
+            REQUIRE(destroyed == 0);
+            REQUIRE(value_of(b) == 1);
+
+            intrusive_ptr<counted_node> c {};
+            c = b;
+            b = std::move(c);
+            REQUIRE(c.empty());
+            REQUIRE(destroyed == 0);
+        }
+
+        REQUIRE(destroyed == 1);
+    }
+    SECTION("copies of the object count separately")
+    {
+        auto a = make_intrusive<counted_node>(1, destroyed);
+        intrusive_ptr<counted_node> b {};
+        a.deref().if_set([&b](const counted_node& node) { b = make_intrusive<counted_node>(node); });
+
+        a.clear();
+        REQUIRE(destroyed == 1);
+        REQUIRE(value_of(b) == 1);
+    }
+    SECTION("intrusive_weak_ptr")
+    {
+        intrusive_weak_ptr<counted_node> weak {};
+        REQUIRE(weak.lock().empty());
+
+        {
+            auto shared = make_intrusive<counted_node>(2, destroyed);
+            weak = shared;
+            intrusive_weak_ptr<counted_node> copy { weak };
+
+            REQUIRE(value_of(weak.lock()) == 2);
+            REQUIRE(value_of(copy.lock()) == 2);
+        }
+
+        REQUIRE(destroyed == 1);
+        REQUIRE(weak.lock().empty());
+    }
+    SECTION("an object's weak pointer to itself can't be locked during destruction")
+    {
+        {
+            auto node = make_intrusive<derived_node>(3, destroyed);
+            node.deref().if_set([&node](derived_node& self) { self.self = node; });
+        }
+
+        REQUIRE(destroyed == 1);
+    }
+}
@@ -0,0 +1,223 @@
+#include <catch2/catch.hpp>
+
+#include <safet/condition_variable.hpp>
+#include <safet/critical_section.hpp>
+#include <safet/mutex.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+TEMPLATE_TEST_CASE("lock policies", "[mutex]", spin_mutex, atomic_mutex, adaptive_mutex<>, async_mutex)
+{
+    TestType m;
+
+    SECTION("try_lock fails while locked")
+    {
+        m.lock();
+        REQUIRE_FALSE(m.try_lock());
+        m.unlock();
+
+        REQUIRE(m.try_lock());
+        REQUIRE_FALSE(m.try_lock());
+        m.unlock();
+    }
+
+    SECTION("guards a critical_section under contention")
+    {
+        critical_section<size_t, TestType> cs { 0u };
+
+        constexpr size_t thread_count = 8;
+        constexpr size_t increments = 10000;
+
+        std::vector<std::thread> v;
+        for (size_t i = 0; i < thread_count; ++i) {
+            v.emplace_back([&]() {
+                for (size_t j = 0; j < increments; ++j) {
+                    // deliberately non-atomic read-modify-write, only correct if the lock excludes other threads
+                    cs.enter([](size_t& value) {
+                        auto copy = value;
+                        value = copy + 1;
+                    });
+                }
+            });
+        }
+
+        for (auto& t : v) {
+            t.join();
+        }
+
+        REQUIRE(cs.enter([](const size_t& value) { return value; }) == thread_count * increments);
+    }
+
+    SECTION("try_enter respects the policy")
+    {
+        critical_section<int, TestType> cs { 1 };
+
+        cs.enter([&](int&) {
+            REQUIRE_FALSE(cs.try_enter([](int&) { FAIL("try_enter must not call the functor on an already entered critical_section"); }));
+        });
+
+        REQUIRE(cs.try_enter([](int& value) { return value; }) == 1);
+    }
+
+    SECTION("condition_variable wait and modify")
+    {
+        condition_variable<int, TestType> cv { 0 };
+
+        std::thread waiter { [&]() {
+            cv.wait([](const int& value) { return value == 1; }, [](int& value) { value = 2; });
+            cv.notify();
+        } };
+
+        cv.modify([](int& value) { value = 1; });
+        cv.wait([](const int& value) { return value == 2; }, [](int&) {});
+        waiter.join();
+
+        cv.inspect([](const int& value) { REQUIRE(value == 2); });
+    }
+}
+
+TEMPLATE_TEST_CASE("lock policy timed locking", "[mutex]", spin_mutex, atomic_mutex, adaptive_mutex<>)
+{
+    critical_section<int, TestType> cs { 1 };
+
+    REQUIRE(cs.try_enter_for(std::chrono::milliseconds { 1 }, [](int& value) { return value; }) == 1);
+
+    cs.enter([&](int&) {
+        std::thread other { [&]() {
+            REQUIRE_FALSE(cs.try_enter_for(std::chrono::milliseconds { 1 }, [](int&) {}));
+        } };
+        other.join();
+    });
+}
+
+TEMPLATE_TEST_CASE("lock policy timed locking backs off instead of spinning", "[mutex]", spin_mutex, atomic_mutex,
+    adaptive_mutex<>)
+{
+    TestType m;
+    m.lock();
+
+    constexpr auto timeout = std::chrono::milliseconds { 200 };
+
+    std::atomic<bool> acquired { true };
+    std::chrono::steady_clock::duration waited {};
+    std::clock_t cpu_used {};
+    std::thread other { [&]() {
+        const auto cpu_start = std::clock();
+        const auto start = std::chrono::steady_clock::now();
+        acquired = m.try_lock_for(timeout);
+        waited = std::chrono::steady_clock::now() - start;
+        cpu_used = std::clock() - cpu_start;
+    } };
+    other.join();
+    m.unlock();
+
+    CHECK_FALSE(acquired);
+    CHECK(waited >= timeout);
+    // busy polling would spend about the whole timeout on the cpu
+    CHECK(cpu_used * 1000 / CLOCKS_PER_SEC < timeout.count() / 2);
+}
+
+TEST_CASE("instrumented_mutex", "[mutex]")
+{
+    SECTION("records acquisitions and failed attempts")
+    {
+        critical_section<int, instrumented_mutex<>> cs { 0 };
+        cs.set_name("counter");
+
+        cs.enter([&](int& value) {
+            ++value;
+
+            std::thread other { [&]() {
+                REQUIRE_FALSE(cs.try_enter([](int&) {}));
+            } };
+            other.join();
+        });
+        REQUIRE(cs.try_enter([](int& value) { return value; }) == 1);
+
+        const auto stats = cs.stats();
+        REQUIRE(stats.name == "counter");
+        REQUIRE(stats.acquisitions == 2);
+        REQUIRE(stats.contended_acquisitions == 0);
+        REQUIRE(stats.failed_try_locks == 1);
+        REQUIRE(stats.max_hold <= stats.total_hold);
+        REQUIRE(stats.total_wait == std::chrono::nanoseconds { 0 });
+    }
+
+    SECTION("records contention and wait times")
+    {
+        critical_section<int, instrumented_mutex<spin_mutex>> cs { 0 };
+
+        std::atomic<bool> entered { false };
+        std::thread holder { [&]() {
+            cs.enter([&](int&) {
+                entered = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds { 5 });
+            });
+        } };
+
+        while (!entered) {
+            std::this_thread::yield();
+        }
+        cs.enter([](int& value) { ++value; });
+        holder.join();
+
+        const auto stats = cs.stats();
+        REQUIRE(stats.acquisitions == 2);
+        REQUIRE(stats.contended_acquisitions == 1);
+        REQUIRE(stats.max_wait > std::chrono::nanoseconds { 0 });
+        REQUIRE(stats.max_wait == stats.total_wait);
+        REQUIRE(stats.max_hold >= std::chrono::milliseconds { 5 });
+    }
+
+    SECTION("supports shared and timed mutexes")
+    {
+        critical_section<int, instrumented_mutex<std::shared_timed_mutex>> cs { 1 };
+        const auto& c_cs = cs;
+
+        REQUIRE(c_cs.enter([](const int& value) { return value; }) == 1);
+        REQUIRE(cs.try_enter_for(std::chrono::milliseconds { 1 }, [](int& value) { return value; }) == 1);
+
+        REQUIRE(cs.stats().acquisitions == 2);
+    }
+
+    SECTION("statistics can be read and named from within the critical section")
+    {
+        critical_section<int, instrumented_mutex<>> cs { 0 };
+
+        cs.enter([&](int&) {
+            cs.set_name("inside");
+            REQUIRE(cs.stats().name == "inside");
+        });
+        REQUIRE(cs.stats().acquisitions == 1);
+    }
+
+    SECTION("sums the statistics recorded by every thread")
+    {
+        critical_section<int, instrumented_mutex<>> cs { 0 };
+        constexpr size_t thread_count = 12;
+        constexpr size_t per_thread = 1000;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([&]() {
+                for (size_t j = 0; j < per_thread; ++j) {
+                    cs.enter([](int& value) { ++value; });
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        const auto stats = cs.stats();
+        REQUIRE(stats.acquisitions == thread_count * per_thread);
+        REQUIRE(stats.acquisitions == static_cast<uint64_t>(cs.enter([](int& value) { return value; })));
+    }
+}
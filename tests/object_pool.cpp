@@ -0,0 +1,204 @@
+#include <catch2/catch.hpp>
+
+#include <safet/object_pool.hpp>
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+namespace {
+struct tracked {
+    tracked(int value = 0)
+        : value(value)
+    {
+        ++constructed;
+    }
+
+    ~tracked()
+    {
+        ++destroyed;
+    }
+
+    int value;
+
+    static inline std::atomic<size_t> constructed { 0 };
+    static inline std::atomic<size_t> destroyed { 0 };
+};
+
+auto value_of(const object_pool<tracked>::pointer& ptr) -> int
+{
+    return ptr.deref().if_set([](const tracked& t) { return t.value; }).value_or([]() { return -1; });
+}
+
+auto address_of(const auto& ptr) -> const void*
+{
+    return ptr.deref().if_set([](const auto& value) -> const void* { return &value; }).value_or([]() -> const void* { return nullptr; });
+}
+
+// destroyed after the main thread's thread_locals, `g_held` (declared later, so destroyed first) is released after the
+// thread's cache is gone and the pool then destroyed without it
+object_pool<std::string> g_pool {};
+object_pool<std::string>::pointer g_held;
+}
+
+TEST_CASE("object_pool", "[object_pool]")
+{
+    tracked::constructed = 0;
+    tracked::destroyed = 0;
+
+    SECTION("released objects are destroyed and their memory reused")
+    {
+        object_pool<tracked> pool {};
+
+        auto a = pool.acquire(1);
+        auto first = address_of(a);
+        REQUIRE(value_of(a) == 1);
+
+        a.clear();
+        REQUIRE(tracked::destroyed == 1);
+        REQUIRE(pool.retained() == 1);
+
+        auto b = pool.acquire(2);
+        REQUIRE(address_of(b) == first);
+        REQUIRE(value_of(b) == 2);
+        REQUIRE(pool.retained() == 0);
+        REQUIRE(tracked::constructed == 2);
+    }
+    SECTION("a reset hook runs instead of the destructor")
+    {
+        size_t resets = 0;
+        auto reset = [&resets](std::string& s) {
+            s.clear();
+            ++resets;
+        };
+        object_pool<std::string, decltype(reset)> pool { reset };
+
+        const void* first = nullptr;
+        {
+            auto s = pool.acquire();
+            s.deref().if_set([](std::string& value) { value = "a string too long for the small buffer"; });
+            first = address_of(s);
+        }
+
+        REQUIRE(resets == 1);
+
+        auto s = pool.acquire();
+        REQUIRE(address_of(s) == first);
+        // reset, but not destroyed, so it keeps its capacity
+        REQUIRE(s.deref().if_set([](const std::string& value) { return value.empty() && value.capacity() > 15; }).value_or([]() { return false; }));
+    }
+    SECTION("no more than max_retained objects are kept")
+    {
+        {
+            object_pool<tracked> pool { 4 };
+            std::vector<object_pool<tracked>::pointer> held;
+            for (int i = 0; i < 10; ++i) {
+                held.push_back(pool.acquire(i));
+            }
+
+            held.clear();
+            REQUIRE(pool.retained() == 4);
+            REQUIRE(tracked::destroyed == 10);
+        }
+
+        REQUIRE(tracked::destroyed == 10);
+    }
+    SECTION("objects spill from the thread cache to the global list")
+    {
+        object_pool<tracked> pool { 10000 };
+        std::vector<object_pool<tracked>::pointer> held;
+        std::set<const void*> addresses;
+        for (int i = 0; i < 500; ++i) {
+            held.push_back(pool.acquire(i));
+            addresses.insert(address_of(held.back()));
+        }
+        held.clear();
+        REQUIRE(pool.retained() == 500);
+
+        // another thread finds them in the global list
+        std::thread other([&pool, &addresses]() {
+            std::vector<object_pool<tracked>::pointer> reused;
+            for (int i = 0; i < 100; ++i) {
+                reused.push_back(pool.acquire(i));
+            }
+
+            size_t recycled = 0;
+            for (auto& p : reused) {
+                recycled += addresses.count(address_of(p));
+            }
+
+            REQUIRE(recycled == reused.size());
+        });
+        other.join();
+
+        REQUIRE(pool.retained() == 500);
+    }
+    SECTION("objects cached by a thread are only counted globally once it exchanges them with the global list")
+    {
+        object_pool<tracked> pool {};
+        std::vector<object_pool<tracked>::pointer> held;
+        for (int i = 0; i < 10; ++i) {
+            held.push_back(pool.acquire(i));
+        }
+        held.clear();
+
+        size_t seen_elsewhere = 0;
+        std::thread other([&]() { seen_elsewhere = pool.retained(); });
+        other.join();
+
+        REQUIRE(pool.retained() == 10);
+        REQUIRE(seen_elsewhere == 0);
+    }
+    SECTION("acquired and released from many threads")
+    {
+        object_pool<tracked> pool { 256 };
+        std::atomic<size_t> failures { 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&pool, &failures, t]() {
+                for (int i = 0; i < 10000; ++i) {
+                    auto a = pool.acquire(t * 10000 + i);
+                    auto b = pool.acquire(-i);
+                    if (value_of(a) != t * 10000 + i || value_of(b) != -i) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(failures == 0);
+        REQUIRE(tracked::constructed == tracked::destroyed);
+    }
+    SECTION("a thread's cache returns its objects when the thread exits")
+    {
+        auto pool = std::make_unique<object_pool<tracked>>();
+        std::thread other([&pool]() {
+            auto a = pool->acquire(1);
+        });
+        other.join();
+
+        // the other thread's cache returned its object to the global list when the thread exited
+        REQUIRE(pool->retained() == 1);
+        auto b = pool->acquire(2);
+        REQUIRE(value_of(b) == 2);
+        b.clear();
+        pool.reset();
+    }
+}
+
+TEST_CASE("object_pool with static storage duration", "[object_pool]")
+{
+    auto a = g_pool.acquire("cached by this thread");
+    a.clear();
+    REQUIRE(g_pool.retained() == 1);
+
+    g_held = g_pool.acquire("released at exit");
+    REQUIRE(g_pool.retained() == 0);
+}
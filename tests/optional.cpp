@@ -3,6 +3,11 @@
 #include <safet/finally.hpp>
 #include <safet/optional.hpp>
 
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 using namespace safet;
 
 TEST_CASE("optional example use cases", "[optional]")
@@ -650,4 +655,234 @@ TEST_CASE("optional comparisons", "[optional]")
     REQUIRE(engaged_1 <= 0);
     REQUIRE_FALSE(engaged_1 < -1);
     REQUIRE_FALSE(engaged_1 <= -1);
-}
\ No newline at end of file
+}
+namespace {
+struct file_handle {
+    int m_fd;
+};
+
+struct alignas(64) over_aligned {
+    int m_value;
+};
+}
+
+template <>
+struct safet::optional_niche<file_handle> {
+    static auto empty_value() -> file_handle
+    {
+        return file_handle { -1 };
+    }
+
+    static auto is_empty(const file_handle& handle) -> bool
+    {
+        return handle.m_fd < 0;
+    }
+};
+
+TEST_CASE("optional layout", "[optional]")
+{
+    SECTION("values are aligned and the flag fits in the padding")
+    {
+        static_assert(alignof(optional<double>) == alignof(double));
+        static_assert(sizeof(optional<double>) == 2 * sizeof(double));
+        static_assert(sizeof(optional<uint8_t>) == 2);
+        static_assert(alignof(optional<over_aligned>) == 64);
+
+        optional<over_aligned> o { over_aligned { 3 } };
+        REQUIRE(o.if_set([](const over_aligned& value) { return reinterpret_cast<uintptr_t>(&value) % 64; }) == 0u);
+    }
+
+    SECTION("references are stored as a nullable pointer")
+    {
+        static_assert(sizeof(optional<int&>) == sizeof(int*));
+        static_assert(sizeof(optional<const std::string&>) == sizeof(std::string*));
+
+        int i = 1;
+        optional<int&> o { i };
+        REQUIRE_FALSE(o.empty());
+
+        o = std::nullopt;
+        REQUIRE(o.empty());
+    }
+
+    SECTION("user niches")
+    {
+        static_assert(sizeof(optional<file_handle>) == sizeof(file_handle));
+
+        optional<file_handle> o;
+        REQUIRE(o.empty());
+
+        o = file_handle { 3 };
+        REQUIRE(o.if_set([](const file_handle& handle) { return handle.m_fd; }) == 3);
+
+        auto copy = o;
+        REQUIRE_FALSE(copy.empty());
+
+        o = std::nullopt;
+        REQUIRE(o.empty());
+        REQUIRE_FALSE(copy.empty());
+
+        // the sentinel itself reads as empty
+        o = file_handle { -1 };
+        REQUIRE(o.empty());
+    }
+}
+
+namespace {
+struct counting {
+    counting() = default;
+    counting(const counting&)
+    {
+        ++constructions;
+    }
+    auto operator=(const counting&) -> counting&
+    {
+        ++assignments;
+        return *this;
+    }
+
+    inline static size_t constructions = 0;
+    inline static size_t assignments = 0;
+};
+}
+
+TEST_CASE("optional triviality and constexpr", "[optional]")
+{
+    SECTION("trivial when T is")
+    {
+        static_assert(std::is_trivially_copyable_v<optional<int>>);
+        static_assert(std::is_trivially_destructible_v<optional<int>>);
+        static_assert(std::is_trivially_copyable_v<optional<int&>>);
+        static_assert(std::is_trivially_copyable_v<optional<file_handle>>);
+
+        static_assert(!std::is_trivially_copyable_v<optional<std::string>>);
+        static_assert(!std::is_trivially_destructible_v<optional<std::string>>);
+        static_assert(std::is_copy_constructible_v<optional<std::string>>);
+    }
+
+    SECTION("usable in constant expressions")
+    {
+        constexpr optional<int> engaged { 3 };
+        constexpr optional<int> empty;
+        static_assert(engaged.value_or([]() { return 0; }) == 3);
+        static_assert(empty.empty());
+        static_assert(engaged == 3);
+
+        // non-trivial values too
+        constexpr auto modified = []() {
+            optional<std::vector<int>> o { std::vector<int> { 1 } };
+            o.if_set([](std::vector<int>& v) { v.push_back(2); });
+            o = std::nullopt;
+            o.emplace(3u, 4);
+
+            return o.value_or([]() { return std::vector<int> {}; }).size();
+        }();
+        static_assert(modified == 3);
+    }
+
+    SECTION("assignment between engaged optionals assigns in place")
+    {
+        optional<counting> a { std::in_place };
+        optional<counting> b { std::in_place };
+        counting::constructions = 0;
+
+        a = b;
+        REQUIRE(counting::constructions == 0);
+        REQUIRE(counting::assignments == 1);
+    }
+
+    SECTION("reference optionals rebind")
+    {
+        int i = 1, j = 2;
+        optional<int&> a { i };
+        optional<int&> b { j };
+
+        a = b;
+        REQUIRE(i == 1);
+        REQUIRE(a.if_set([&](int& value) { return &value == &j; }) == true);
+    }
+}
+
+TEST_CASE("optional::pipe()", "[optional]")
+{
+    ssize_t calls = 0;
+    auto triple = [&](const int& value) {
+        ++calls;
+        return value * 3;
+    };
+    auto even_string = [&](int value) -> optional<std::string> {
+        ++calls;
+        if (value % 2 == 0) {
+            return std::to_string(value);
+        }
+        return std::nullopt;
+    };
+
+    SECTION("matches the eager chain")
+    {
+        for (auto input : { optional<int> { 2 }, optional<int> { 3 }, optional<int> {} }) {
+            auto eager = input.if_set(triple).and_then(even_string).value_or([]() { return std::string { "none" }; });
+            auto lazy = input.pipe() | if_set(triple) | and_then(even_string) | value_or([]() { return std::string { "none" }; });
+            REQUIRE(lazy == eager);
+        }
+    }
+
+    SECTION("stops at the first empty value")
+    {
+        optional<int> odd { 1 };
+        auto result = odd.pipe() | if_set(triple) | and_then(even_string) | if_set([](std::string&& value) { return value.size(); }) | value_or([]() -> size_t { return 0; });
+        REQUIRE(result == 0);
+        REQUIRE(calls == 2);
+
+        optional<int> empty;
+        REQUIRE((empty.pipe() | if_set(triple) | value_or([]() { return -1; })) == -1);
+        REQUIRE(calls == 2);
+    }
+
+    SECTION("functors returning nothing pass the value along")
+    {
+        optional<std::string> s { "value" };
+        auto result = std::move(s).pipe() | if_set([](std::string&& value) { value += "!"; }) | value_or([]() { return std::string {}; });
+        REQUIRE(result == "value!");
+    }
+
+    SECTION("evaluate() gives the final optional, references included")
+    {
+        int x = 1;
+        optional<int&> ref { x };
+
+        auto same = (ref.pipe() | if_set([](int& value) -> int& { return value; })).evaluate();
+        REQUIRE(same.if_set([&](int& value) { return &value == &x; }) == true);
+
+        optional<int> empty;
+        REQUIRE((empty.pipe() | if_set(triple)).evaluate().empty());
+    }
+
+    SECTION("no intermediate optionals are built")
+    {
+        struct moves {
+            moves() = default;
+            moves(const moves& copy)
+                : count(copy.count + 1)
+            {
+            }
+            moves(moves&& move)
+                : count(move.count + 1)
+            {
+            }
+
+            int count { 0 };
+        };
+
+        optional<moves> o { std::in_place };
+        auto pass = [](moves&& value) { return std::move(value); };
+
+        auto eager = std::move(o).if_set(pass).if_set(pass).if_set(pass).value_or([]() { return moves {}; });
+        o.emplace();
+        auto lazy = std::move(o).pipe() | if_set(pass) | if_set(pass) | if_set(pass) | value_or([]() { return moves {}; });
+
+        // one move out of each functor, and one into the result
+        REQUIRE(lazy.count == 4);
+        REQUIRE(eager.count > lazy.count);
+    }
+}
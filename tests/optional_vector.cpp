@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+
+#include <safet/optional_vector.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("optional_vector", "[optional_vector]")
+{
+    optional_vector<std::string> values;
+    values.push_back(std::string { "zero" });
+    values.push_back(std::nullopt);
+    values.emplace_back(3, 'b');
+    values.push_back(optional<std::string> {});
+    values.push_back(optional<std::string> { "four" });
+
+    SECTION("size counts every element, count only those set")
+    {
+        REQUIRE(values.size() == 5);
+        REQUIRE(values.count() == 3);
+    }
+
+    SECTION("get")
+    {
+        REQUIRE(values.get(0) == "zero");
+        REQUIRE(values.get(1).empty());
+        REQUIRE(std::as_const(values).get(2) == "bbb");
+        REQUIRE(values.get(3).empty());
+        REQUIRE(values.get(4) == "four");
+    }
+
+    SECTION("get past the end is empty")
+    {
+        REQUIRE(values.get(5).empty());
+        REQUIRE(std::as_const(values).get(1000).empty());
+    }
+
+    SECTION("values may be built from elements of the same vector")
+    {
+        values.emplace(0, std::string(100, 'z'));
+        // the next emplace_back grows the storage `*values.get(0)` lives in
+        while (values.size() < 64) {
+            values.push_back(std::nullopt);
+        }
+        values.get(0).if_set([&](std::string& first) { values.emplace_back(first); });
+        values.get(0).if_set([&](std::string& first) { values.emplace(0, first + "!"); });
+
+        REQUIRE(values.size() == 65);
+        REQUIRE(values.get(64) == std::string(100, 'z'));
+        REQUIRE(values.get(0) == std::string(100, 'z') + "!");
+    }
+
+    SECTION("visit_all skips empty elements")
+    {
+        std::vector<std::string> seen;
+        std::as_const(values).visit_all([&](const std::string& value) { seen.push_back(value); });
+        REQUIRE(seen == std::vector<std::string> { "zero", "bbb", "four" });
+
+        values.visit_all([](std::string& value) { value += "!"; });
+        REQUIRE(values.get(2) == "bbb!");
+    }
+
+    SECTION("emplace and reset")
+    {
+        values.emplace(1, "one");
+        values.emplace(0, "replaced");
+        values.reset(4);
+        values.reset(3);
+
+        REQUIRE(values.count() == 3);
+        REQUIRE(values.get(0) == "replaced");
+        REQUIRE(values.get(1) == "one");
+        REQUIRE(values.get(4).empty());
+    }
+
+    SECTION("copy and move")
+    {
+        auto copy = values;
+        REQUIRE(copy.size() == 5);
+        REQUIRE(copy.get(2) == "bbb");
+        REQUIRE(copy.get(3).empty());
+
+        auto moved = std::move(copy);
+        REQUIRE(moved.count() == 3);
+        REQUIRE(copy.empty());
+
+        moved = values;
+        REQUIRE(moved.get(4) == "four");
+    }
+}
+
+TEST_CASE("optional_vector across many words", "[optional_vector]")
+{
+    // every third element set, growing well past the first reallocations and bitmap words
+    constexpr size_t element_count = 1000;
+
+    auto tracked = std::make_shared<int>(0);
+    {
+        optional_vector<std::shared_ptr<int>> values;
+        for (size_t i = 0; i < element_count; ++i) {
+            if (i % 3 == 0) {
+                values.push_back(tracked);
+            } else {
+                values.push_back(std::nullopt);
+            }
+        }
+
+        REQUIRE(values.size() == element_count);
+        REQUIRE(values.count() == (element_count + 2) / 3);
+        REQUIRE(tracked.use_count() == 1 + static_cast<long>(values.count()));
+
+        size_t visited { 0 };
+        values.visit_all([&](const std::shared_ptr<int>&) { ++visited; });
+        REQUIRE(visited == values.count());
+
+        REQUIRE(values.get(998).empty());
+        REQUIRE_FALSE(values.get(999).empty());
+    }
+
+    // every set value destroyed exactly once
+    REQUIRE(tracked.use_count() == 1);
+}
@@ -0,0 +1,78 @@
+#include <catch2/catch.hpp>
+
+#include <safet/pack.hpp>
+
+#include <string>
+#include <type_traits>
+
+using namespace safet;
+
+namespace {
+template <typename T>
+struct is_integral_filter : std::is_integral<T> { };
+
+using mixed = pack<int, std::string, int&, double, std::string, char, int>;
+}
+
+TEST_CASE("pack lookups", "[pack]")
+{
+    SECTION("ith_type, first_type and last_type")
+    {
+        STATIC_REQUIRE(std::is_same_v<mixed::ith_type<0>::type, int>);
+        STATIC_REQUIRE(std::is_same_v<mixed::ith_type<2>::type, int&>);
+        STATIC_REQUIRE(std::is_same_v<mixed::ith_type<6>::type, int>);
+        STATIC_REQUIRE(std::is_same_v<mixed::first_type::type, int>);
+        STATIC_REQUIRE(std::is_same_v<mixed::last_type::type, int>);
+    }
+
+    SECTION("index_of finds the first occurrence")
+    {
+        STATIC_REQUIRE(mixed::index_of<int>::value == 0);
+        STATIC_REQUIRE(mixed::index_of<std::string>::value == 1);
+        STATIC_REQUIRE(mixed::index_of<int&>::value == 2);
+        STATIC_REQUIRE(mixed::index_of<char>::value == 5);
+    }
+
+    SECTION("count_of and contains tell references and cv qualified types apart")
+    {
+        STATIC_REQUIRE(mixed::count_of<int>::value == 2);
+        STATIC_REQUIRE(mixed::count_of<int&>::value == 1);
+        STATIC_REQUIRE(mixed::count_of<const int>::value == 0);
+        STATIC_REQUIRE(mixed::contains<double>::value);
+        STATIC_REQUIRE(mixed::does_not_contain<float>::value);
+        STATIC_REQUIRE(pack<>::does_not_contain<int>::value);
+    }
+
+    SECTION("equivalent compares as multisets")
+    {
+        STATIC_REQUIRE(pack<int, char, int>::equivalent<char, int, int>::value);
+        STATIC_REQUIRE_FALSE(pack<int, char, int>::equivalent<char, char, int>::value);
+        STATIC_REQUIRE_FALSE(pack<int, char>::equivalent<char, int, int>::value);
+        STATIC_REQUIRE(pack<>::equivalent<>::value);
+    }
+}
+
+TEST_CASE("pack slicing", "[pack]")
+{
+    SECTION("remove_prefix, remove_suffix, downsize and subpack")
+    {
+        STATIC_REQUIRE(std::is_same_v<mixed::remove_prefix<4>, pack<std::string, char, int>>);
+        STATIC_REQUIRE(std::is_same_v<mixed::remove_prefix<7>, pack<>>);
+        STATIC_REQUIRE(std::is_same_v<mixed::remove_suffix<4>, pack<int, std::string, int&>>);
+        STATIC_REQUIRE(std::is_same_v<mixed::downsize<0>, pack<>>);
+        STATIC_REQUIRE(std::is_same_v<mixed::subpack<2, 3>, pack<int&, double, std::string>>);
+    }
+
+    SECTION("filter keeps the order of the kept types")
+    {
+        STATIC_REQUIRE(std::is_same_v<mixed::filter<is_integral_filter>, pack<int, char, int>>);
+        STATIC_REQUIRE(std::is_same_v<pack<>::filter<is_integral_filter>, pack<>>);
+    }
+
+    SECTION("remove_duplicates keeps each first occurrence")
+    {
+        STATIC_REQUIRE(std::is_same_v<mixed::remove_duplicates, pack<int, std::string, int&, double, char>>);
+        STATIC_REQUIRE(std::is_same_v<pack<char, char, char>::remove_duplicates, pack<char>>);
+        STATIC_REQUIRE(std::is_same_v<pack<>::remove_duplicates, pack<>>);
+    }
+}
@@ -0,0 +1,98 @@
+#include <catch2/catch.hpp>
+
+#include <safet/packed_tuple.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+using namespace safet;
+
+TEST_CASE("pack::sort_by", "[pack]")
+{
+    SECTION("alignment_order puts the most aligned, then largest, types first")
+    {
+        STATIC_REQUIRE(std::is_same_v<pack<char, double, char, int>::sort_by<alignment_order>, pack<double, int, char, char>>);
+        STATIC_REQUIRE(std::is_same_v<pack<uint16_t, char[3], uint64_t>::sort_by<alignment_order>, pack<uint64_t, uint16_t, char[3]>>);
+        STATIC_REQUIRE(std::is_same_v<pack<>::sort_by<alignment_order>, pack<>>);
+    }
+
+    SECTION("sorting is stable")
+    {
+        STATIC_REQUIRE(std::is_same_v<pack<int8_t, uint32_t, uint8_t, int32_t, char>::sort_by<alignment_order>, pack<uint32_t, int32_t, int8_t, uint8_t, char>>);
+    }
+}
+
+TEST_CASE("packed_tuple layout", "[packed_tuple]")
+{
+    STATIC_REQUIRE(sizeof(std::tuple<char, double, char, int>) == 24);
+    STATIC_REQUIRE(sizeof(packed_tuple<char, double, char, int>) == 16);
+    STATIC_REQUIRE(sizeof(packed_tuple<char, uint64_t, uint16_t, uint32_t, char>) == 16);
+    STATIC_REQUIRE(alignof(packed_tuple<char, double>) == alignof(double));
+    STATIC_REQUIRE(std::is_trivially_copyable_v<packed_tuple<char, double, int>>);
+}
+
+TEST_CASE("packed_tuple access", "[packed_tuple]")
+{
+    packed_tuple<char, double, std::string, int> tuple { 'a', 2.5, "three", 4 };
+
+    SECTION("get by index is in declaration order")
+    {
+        REQUIRE(tuple.get<0>() == 'a');
+        REQUIRE(tuple.get<1>() == 2.5);
+        REQUIRE(tuple.get<2>() == "three");
+        REQUIRE(tuple.get<3>() == 4);
+
+        tuple.get<3>() = 40;
+        REQUIRE(get<3>(tuple) == 40);
+        REQUIRE(tuple.get<0>() == 'a');
+    }
+
+    SECTION("get by type")
+    {
+        REQUIRE(tuple.get<std::string>() == "three");
+        REQUIRE(std::as_const(tuple).get<double>() == 2.5);
+    }
+
+    SECTION("structured bindings")
+    {
+        auto& [c, d, s, i] = tuple;
+        REQUIRE(c == 'a');
+        REQUIRE(d == 2.5);
+        REQUIRE(s == "three");
+        REQUIRE(i == 4);
+
+        s = "changed";
+        REQUIRE(tuple.get<2>() == "changed");
+    }
+
+    SECTION("copy, move and comparison")
+    {
+        auto copy = tuple;
+        REQUIRE(copy == tuple);
+
+        copy.get<0>() = 'b';
+        REQUIRE_FALSE(copy == tuple);
+
+        auto moved = std::move(copy);
+        REQUIRE(moved.get<0>() == 'b');
+        REQUIRE(moved.get<2>() == "three");
+    }
+
+    SECTION("rvalue get moves the member out")
+    {
+        packed_tuple<std::unique_ptr<int>, char> owning { std::make_unique<int>(7), 'x' };
+        auto value = std::move(owning).get<0>();
+        REQUIRE(*value == 7);
+    }
+
+    SECTION("default construction value initializes")
+    {
+        packed_tuple<int, double, std::string> defaulted;
+        REQUIRE(defaulted.get<0>() == 0);
+        REQUIRE(defaulted.get<1>() == 0.0);
+        REQUIRE(defaulted.get<2>().empty());
+    }
+}
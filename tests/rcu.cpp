@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <safet/rcu.hpp>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("rcu example use cases", "[rcu]")
+{
+    rcu<std::map<std::string, int>> routes { std::map<std::string, int> { { "a", 1 } } };
+
+    SECTION("readers keep a consistent version while updates are published")
+    {
+        std::atomic<bool> done { false };
+        std::atomic<size_t> inconsistent_reads { 0 };
+
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < 4; ++i) {
+            readers.emplace_back([&]() {
+                while (!done) {
+                    routes.snapshot().deref().if_set([&](const std::map<std::string, int>& table) {
+                        // each update adds one entry numbered by the new size, a consistent version always matches
+                        if (table.rbegin()->second != static_cast<int>(table.size())) {
+                            ++inconsistent_reads;
+                        }
+                    });
+                }
+            });
+        }
+
+        for (int i = 2; i <= 200; ++i) {
+            routes.update([&](std::map<std::string, int>& table) { table.emplace(std::string(i, 'a'), i); });
+        }
+        done = true;
+
+        for (auto& t : readers) {
+            t.join();
+        }
+
+        REQUIRE(inconsistent_reads == 0);
+        REQUIRE(routes.inspect([](const std::map<std::string, int>& table) { return table.size(); }) == 200u);
+    }
+}
+
+TEST_CASE("rcu::snapshot()", "[rcu]")
+{
+    rcu<std::string> s { 5, 'a' };
+
+    SECTION("snapshots are never empty")
+    {
+        REQUIRE_FALSE(s.snapshot().empty());
+        REQUIRE(s.snapshot().deref() == "aaaaa");
+    }
+
+    SECTION("snapshots are unaffected by later updates")
+    {
+        auto before = s.snapshot();
+        s.update([](std::string& value) { value += "bbbbb"; });
+
+        REQUIRE(before.deref() == "aaaaa");
+        REQUIRE(s.snapshot().deref() == "aaaaabbbbb");
+    }
+
+    SECTION("old versions are released with their last snapshot")
+    {
+        weak_ptr<const std::string> old_version = s.snapshot();
+        REQUIRE_FALSE(old_version.lock().empty());
+
+        s = std::string { "new" };
+
+        REQUIRE(old_version.lock().empty());
+        REQUIRE(s.snapshot().deref() == "new");
+    }
+}
+
+TEST_CASE("rcu::update()", "[rcu]")
+{
+    rcu<std::string> s { "a" };
+
+    SECTION("when returning a value")
+    {
+        auto retval = s.update([](std::string& value) {
+            value += "b";
+            return value.size();
+        });
+
+        REQUIRE(retval == 2u);
+        REQUIRE(s.inspect([](const std::string& value) { return value; }) == "ab");
+    }
+
+    SECTION("when the functor throws nothing is published")
+    {
+        REQUIRE_THROWS(s.update([](std::string& value) {
+            value += "b";
+            throw 1;
+        }));
+
+        REQUIRE(s.snapshot().deref() == "a");
+    }
+}
@@ -0,0 +1,119 @@
+#include <catch2/catch.hpp>
+
+#include <safet/seqlock.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+namespace {
+struct quote {
+    uint64_t bid;
+    uint64_t ask;
+    uint64_t sequence;
+};
+}
+
+TEST_CASE("seqlock example use cases", "[seqlock]")
+{
+    seqlock<quote> current { quote { 100, 101, 0 } };
+
+    SECTION("readers never observe a torn write")
+    {
+        std::atomic<bool> done { false };
+        std::atomic<size_t> torn_reads { 0 };
+
+        std::thread writer { [&]() {
+            for (uint64_t i = 1; i <= 100000; ++i) {
+                current.enter([&](quote& q) {
+                    q.bid = 100 + i;
+                    q.ask = 101 + i;
+                    q.sequence = i;
+                });
+            }
+            done = true;
+        } };
+
+        std::vector<std::thread> readers;
+        for (size_t i = 0; i < 4; ++i) {
+            readers.emplace_back([&]() {
+                uint64_t last_sequence = 0;
+                while (!done) {
+                    const auto q = current.read();
+
+                    // every field must belong to the same write, and writes must never appear to go backwards.
+                    // Counted rather than REQUIRE'd as catch2 assertions aren't thread safe
+                    if (q.ask != q.bid + 1 || q.bid != 100 + q.sequence || q.sequence < last_sequence) {
+                        ++torn_reads;
+                    }
+                    last_sequence = q.sequence;
+                }
+            });
+        }
+
+        writer.join();
+        for (auto& t : readers) {
+            t.join();
+        }
+
+        REQUIRE(torn_reads == 0);
+        REQUIRE(current.read().sequence == 100000);
+    }
+}
+
+TEST_CASE("seqlock constructor", "[seqlock]")
+{
+    seqlock<quote> s { quote { 1, 2, 3 } };
+
+    const auto q = s.read();
+    REQUIRE(q.bid == 1);
+    REQUIRE(q.ask == 2);
+    REQUIRE(q.sequence == 3);
+}
+
+TEST_CASE("seqlock::enter() and seqlock::try_enter()", "[seqlock]")
+{
+    seqlock<int> s { 1 };
+
+    SECTION("enter publishes the modified value")
+    {
+        auto retval = s.enter([](int& value) { return value += 1; });
+
+        REQUIRE(retval == 2);
+        REQUIRE(s.read() == 2);
+    }
+
+    SECTION("enter does not publish if the functor throws")
+    {
+        REQUIRE_THROWS(s.enter([](int& value) {
+            value = 5;
+            throw 1;
+        }));
+
+        REQUIRE(s.read() == 1);
+    }
+
+    SECTION("try_enter fails while another writer is inside")
+    {
+        s.enter([&](int&) {
+            REQUIRE(s.try_enter([](int& value) { return value; }).empty());
+            REQUIRE_FALSE(s.try_enter([](int&) {}));
+
+            // readers are unaffected by the writer
+            REQUIRE(s.read() == 1);
+        });
+
+        REQUIRE(s.try_enter([](int& value) { return ++value; }) == 2);
+        REQUIRE(s.try_enter([](int& value) { ++value; }));
+        REQUIRE(s.read() == 3);
+    }
+
+    SECTION("assignment")
+    {
+        s = 10;
+
+        REQUIRE(s.inspect([](const int& value) { return value * 2; }) == 20);
+    }
+}
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <safet/sharded_critical_section.hpp>
+
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("sharded_critical_section example use cases", "[sharded_critical_section]")
+{
+    sharded_critical_section<std::unordered_map<int, int>, 16, int> counts;
+
+    SECTION("count keys on multiple threads")
+    {
+        constexpr int thread_count = 8;
+        constexpr int key_count = 1000;
+
+        std::vector<std::thread> v;
+        for (int i = 0; i < thread_count; ++i) {
+            v.emplace_back([&]() {
+                for (int key = 0; key < key_count; ++key) {
+                    counts.enter(key, [&](std::unordered_map<int, int>& shard) { ++shard[key]; });
+                }
+            });
+        }
+
+        for (auto& t : v) {
+            t.join();
+        }
+
+        const auto sizes = counts.enter_all([](const std::unordered_map<int, int>& shard) { return shard.size(); });
+
+        size_t total = 0;
+        for (auto size : sizes) {
+            total += size;
+        }
+        REQUIRE(total == key_count);
+
+        for (int key = 0; key < key_count; ++key) {
+            REQUIRE(counts.enter(key, [&](const std::unordered_map<int, int>& shard) { return shard.at(key); }) == thread_count);
+        }
+    }
+}
+
+TEST_CASE("sharded_critical_section layout", "[sharded_critical_section]")
+{
+    using sharded = sharded_critical_section<int, 4, int>;
+
+    REQUIRE(sharded::shard_count() == 4);
+    REQUIRE(alignof(sharded) >= impl::cache_line_size);
+    REQUIRE(sizeof(sharded) >= 4 * impl::cache_line_size);
+}
+
+TEST_CASE("sharded_critical_section constructor", "[sharded_critical_section]")
+{
+    // every shard is constructed from the same params
+    sharded_critical_section<std::string, 3, int> s { 3, 'a' };
+
+    s.enter_all([](const std::string& value) { REQUIRE(value == "aaa"); });
+}
+
+TEST_CASE("sharded_critical_section::enter() and sharded_critical_section::try_enter()", "[sharded_critical_section]")
+{
+    sharded_critical_section<int, 8, int> s { 0 };
+
+    SECTION("keys always route to the same shard")
+    {
+        REQUIRE(s.shard_index(1234) == s.shard_index(1234));
+        REQUIRE(s.shard_index(1234) < 8u);
+
+        s.enter(1234, [](int& value) { value = 1; });
+        REQUIRE(s.enter(1234, [](const int& value) { return value; }) == 1);
+    }
+
+    SECTION("try_enter only contends with its own shard")
+    {
+        auto other_key = 0;
+        while (s.shard_index(other_key) == s.shard_index(1)) {
+            ++other_key;
+        }
+
+        s.enter(1, [&](int&) {
+            std::thread other { [&]() {
+                REQUIRE_FALSE(s.try_enter(1, [](int&) { FAIL("try_enter must not call the functor on an entered shard"); }));
+                REQUIRE(s.try_enter(other_key, [](int& value) { return ++value; }) == 1);
+            } };
+            other.join();
+        });
+    }
+
+    SECTION("enter_all holds every shard")
+    {
+        s.enter_all([&](int&) {
+            std::thread other { [&]() {
+                for (int key = 0; key < 100; ++key) {
+                    REQUIRE_FALSE(s.try_enter(key, [](int&) {}));
+                }
+            } };
+            other.join();
+        });
+    }
+}
+
+TEST_CASE("sharded_critical_section keys are converted to the key type before hashing", "[sharded_critical_section]")
+{
+    sharded_critical_section<int, 64, std::string> s { 0 };
+
+    // hashed as the string rather than the pointer, so every spelling of the key reaches the same shard
+    for (const char* key : { "foo", "bar", "a somewhat longer key" }) {
+        const std::string copy { key };
+        REQUIRE(s.shard_index(key) == s.shard_index(copy));
+        REQUIRE(s.shard_index(key) == s.shard_index(copy.c_str()));
+    }
+
+    s.enter("foo", [](int& value) { ++value; });
+    REQUIRE(s.enter(std::string { "foo" }, [](const int& value) { return value; }) == 1);
+}
@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+
+#include <safet/thread_pool.hpp>
+
+#include <atomic>
+#include <numeric>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+using namespace safet;
+
+TEST_CASE("thread_pool example use cases", "[thread_pool]")
+{
+    thread_pool pool { 4 };
+
+    SECTION("futures chained across the pool")
+    {
+        auto f = pool.submit([]() { return 20; }).then(pool, [](int value) { return value + 1; }).then(pool, [](int value) { return value * 2; });
+
+        REQUIRE(std::move(f).value() == 42);
+    }
+
+    SECTION("lots of small tasks")
+    {
+        std::atomic<size_t> sum { 0 };
+        std::vector<future<void>> futures;
+        for (size_t i = 1; i <= 10000; ++i) {
+            futures.push_back(pool.submit([&sum, i]() { sum += i; }));
+        }
+
+        when_all(std::move(futures)).wait();
+        REQUIRE(sum == 10000 * 10001 / 2);
+    }
+}
+
+TEST_CASE("thread_pool::submit()", "[thread_pool]")
+{
+    thread_pool pool { 2 };
+
+    SECTION("runs on a worker")
+    {
+        REQUIRE_FALSE(pool.on_worker());
+        REQUIRE(pool.submit([&]() { return pool.on_worker(); }).value() == true);
+        REQUIRE(pool.submit([]() { return std::this_thread::get_id(); }).value() != std::this_thread::get_id());
+    }
+
+    SECTION("tasks can submit more tasks")
+    {
+        auto f = pool.submit([&]() {
+                         return pool.submit([]() { return 1; });
+                     })
+                     .then([](future<int> inner) { return inner; });
+
+        REQUIRE(std::move(f).value() == 1);
+    }
+
+    SECTION("move only tasks")
+    {
+        auto f = pool.submit([owned = std::make_unique<int>(3)]() { return *owned; });
+        REQUIRE(std::move(f).value() == 3);
+    }
+}
+
+TEST_CASE("thread_pool::bulk()", "[thread_pool]")
+{
+    thread_pool pool { 4 };
+
+    SECTION("every element is visited once")
+    {
+        std::vector<std::atomic<int>> visits(1000);
+
+        pool.bulk(visits, [](std::atomic<int>& v) { ++v; }).wait();
+
+        REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v == 1; }));
+    }
+
+    SECTION("views")
+    {
+        std::atomic<size_t> sum { 0 };
+        pool.bulk(std::views::iota(size_t { 0 }, size_t { 100 }), [&](size_t i) { sum += i; }).wait();
+
+        REQUIRE(sum == 4950);
+    }
+
+    SECTION("empty ranges complete immediately")
+    {
+        REQUIRE(pool.bulk(std::vector<int> {}, [](int) {}).ready());
+    }
+}
+
+TEST_CASE("thread_pool lifetime", "[thread_pool]")
+{
+    SECTION("destruction drains queued tasks")
+    {
+        std::atomic<size_t> ran { 0 };
+        {
+            thread_pool pool { thread_pool_options { .threads = 2, .pin_threads = true } };
+            for (size_t i = 0; i < 1000; ++i) {
+                pool.post([&]() { ++ran; });
+            }
+        }
+
+        REQUIRE(ran == 1000);
+    }
+
+    SECTION("then on an executor runs there")
+    {
+        thread_pool pool { 1 };
+        auto [p, f] = make_promise<int>();
+
+        auto on_pool = std::move(f).then(pool, [&](int) { return pool.on_worker(); });
+        p.set_value(1);
+
+        REQUIRE(std::move(on_pool).value() == true);
+    }
+}
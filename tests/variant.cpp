@@ -3,7 +3,11 @@
 #include <safet/variant.hpp>
 
 #include <charconv>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 using namespace safet;
 
@@ -766,4 +770,189 @@ TEST_CASE("variant comparisons", "[variant]")
         REQUIRE_FALSE(a == b);
         REQUIRE(a != b);
     }
-}
\ No newline at end of file
+}
+template <size_t I>
+struct alternative_tag {
+    size_t value { I };
+};
+
+template <size_t... Is>
+auto make_wide_variant(size_t index, std::index_sequence<Is...>) -> variant<alternative_tag<Is>...>
+{
+    variant<alternative_tag<Is>...> v;
+    ((index == Is ? (void)v.template emplace<Is>() : (void)0), ...);
+
+    return v;
+}
+
+struct throws_on_construction {
+    explicit throws_on_construction(bool do_throw)
+    {
+        if (do_throw) {
+            throw std::runtime_error { "construction" };
+        }
+    }
+};
+
+struct throws_on_move {
+    explicit throws_on_move(bool do_throw)
+    {
+        if (do_throw) {
+            throw std::runtime_error { "construction" };
+        }
+    }
+    throws_on_move(throws_on_move&&) noexcept(false) { }
+};
+
+TEST_CASE("variant storage and dispatch", "[variant]")
+{
+    SECTION("the index takes a single byte for fewer than 256 alternatives")
+    {
+        static_assert(sizeof(variant<int32_t, float>) == 2 * sizeof(int32_t));
+        static_assert(sizeof(variant<char, bool>) == 2);
+        static_assert(sizeof(variant<char&, double&>) == 2 * sizeof(void*));
+
+        // 255 alternatives leave 255 itself for the valueless state
+        static_assert(std::is_same_v<variant_impl::index_type<255>, uint8_t>);
+        static_assert(std::is_same_v<variant_impl::index_type<256>, uint16_t>);
+    }
+
+    SECTION("special members are trivial when the alternatives' are")
+    {
+        static_assert(std::is_trivially_copyable_v<variant<int, float, int*>>);
+        static_assert(std::is_trivially_copyable_v<variant<int&, const double&>>);
+        static_assert(!std::is_trivially_copyable_v<variant<int, std::string>>);
+        static_assert(!std::is_copy_constructible_v<variant<int, std::unique_ptr<int>>>);
+        static_assert(std::is_nothrow_move_constructible_v<variant<int, std::string>>);
+    }
+
+    SECTION("visit dispatches across many alternatives")
+    {
+        using sequence = std::make_index_sequence<40>;
+
+        for (size_t i = 0; i < 40; ++i) {
+            auto v = make_wide_variant(i, sequence {});
+
+            REQUIRE(v.index() == i);
+            REQUIRE(v.visit([](const auto& tag) { return tag.value; }) == i);
+
+            auto copy = v;
+            REQUIRE(copy.index() == i);
+            REQUIRE(copy.covisit(v, [](const auto& lhs, const auto& rhs) { return lhs.value * 100 + rhs.value; }) == i * 101);
+        }
+    }
+
+    SECTION("covisit sees every pair of alternatives")
+    {
+        variant<int, std::string> lhs { 1 };
+        variant<int, std::string> rhs { "two" };
+
+        auto covisitor = overloaded {
+            [](int, int) { return 0; },
+            [](int, const std::string&) { return 1; },
+            [](const std::string&, int) { return 2; },
+            [](const std::string&, const std::string&) { return 3; },
+        };
+
+        REQUIRE(lhs.covisit(lhs, covisitor) == 0);
+        REQUIRE(lhs.covisit(rhs, covisitor) == 1);
+        REQUIRE(rhs.covisit(lhs, covisitor) == 2);
+        REQUIRE(rhs.covisit(rhs, covisitor) == 3);
+    }
+
+    SECTION("a throwing construction leaves the old value in place")
+    {
+        variant<std::string, throws_on_construction> v { "still here" };
+
+        REQUIRE_THROWS(v.emplace<throws_on_construction>(true));
+        REQUIRE_FALSE(v.valueless_by_exception());
+        REQUIRE(v.get<std::string>() == "still here");
+    }
+
+    SECTION("only an alternative that throws while both constructed and moved can leave the variant valueless")
+    {
+        variant<std::string, throws_on_move> v { "going" };
+
+        REQUIRE_THROWS(v.emplace<throws_on_move>(true));
+        REQUIRE(v.valueless_by_exception());
+        REQUIRE(v.index() == std::variant_npos);
+        REQUIRE_THROWS_AS(v.visit([](const auto&) { return 0; }), std::bad_variant_access);
+
+        v = std::string { "back" };
+        REQUIRE(v.get<std::string>() == "back");
+    }
+}
+
+struct shape {
+    virtual ~shape() = default;
+    virtual auto area() const -> double = 0;
+};
+
+struct circle : shape {
+    auto area() const -> double override { return 3.0; }
+};
+
+struct square : shape {
+    auto area() const -> double override { return 4.0; }
+};
+
+struct triangle : shape {
+    auto area() const -> double override { return 0.5; }
+};
+
+TEST_CASE("variant of references", "[variant]")
+{
+    using shape_handle = variant<circle&, square&, const triangle&>;
+
+    circle c;
+    square s;
+    const triangle t;
+
+    SECTION("references to aligned types pack the index into the pointer")
+    {
+        static_assert(sizeof(shape_handle) == sizeof(void*));
+        static_assert(sizeof(variant<int&, const double&, std::string&>) == sizeof(void*));
+        static_assert(std::is_trivially_copyable_v<shape_handle>);
+
+        // a char is not aligned enough to leave a bit free for the index
+        static_assert(sizeof(variant<char&, int&>) > sizeof(void*));
+    }
+
+    SECTION("visit and get see the referenced objects")
+    {
+        std::vector<shape_handle> handles { std::ref(c), std::ref(s), std::cref(t), std::ref(c) };
+
+        auto area = [](const shape& value) { return value.area(); };
+
+        REQUIRE(handles[0].index() == 0);
+        REQUIRE(handles[1].index() == 1);
+        REQUIRE(handles[2].index() == 2);
+        REQUIRE(handles[0].visit(area) == 3.0);
+        REQUIRE(handles[1].visit(area) == 4.0);
+        REQUIRE(handles[2].visit(area) == 0.5);
+
+        REQUIRE(handles[3].get<circle&>().if_set([&](circle& ref) { return &ref == &c; }) == true);
+        REQUIRE(handles[3].get<square&>().empty());
+        REQUIRE(handles[2].get<2>().if_set([&](const triangle& ref) { return &ref == &t; }) == true);
+        REQUIRE(std::move(handles[1]).visit([&](auto& ref) { return static_cast<const void*>(&ref); }) == &s);
+    }
+
+    SECTION("rebinding")
+    {
+        shape_handle handle { std::ref(c) };
+        square other;
+
+        handle = std::ref(s);
+        REQUIRE(handle.get<square&>().if_set([&](square& ref) { return &ref == &s; }) == true);
+
+        handle.emplace<square&>(other);
+        REQUIRE(handle.get<square&>().if_set([&](square& ref) { return &ref == &other; }) == true);
+
+        handle.emplace<2>(t);
+        REQUIRE(handle.index() == 2);
+
+        shape_handle copy { std::ref(c) };
+        copy = handle;
+        REQUIRE(copy.get<const triangle&>().if_set([&](const triangle& ref) { return &ref == &t; }) == true);
+    }
+}
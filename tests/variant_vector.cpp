@@ -0,0 +1,158 @@
+#include <catch2/catch.hpp>
+
+#include <safet/variant_vector.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace safet;
+
+namespace {
+struct throws_on_copy {
+    throws_on_copy() = default;
+    throws_on_copy(const throws_on_copy&)
+    {
+        throw std::runtime_error("copy");
+    }
+};
+
+struct throws_on_move {
+    explicit throws_on_move(bool do_throw)
+    {
+        if (do_throw) {
+            throw std::runtime_error { "construction" };
+        }
+    }
+    throws_on_move(const throws_on_move&) = default;
+    throws_on_move(throws_on_move&&) noexcept(false) { }
+};
+
+struct counts_copies {
+    counts_copies() = default;
+    counts_copies(const counts_copies&)
+    {
+        ++copies;
+    }
+    counts_copies(counts_copies&&) noexcept = default;
+
+    static inline size_t copies { 0 };
+};
+}
+
+TEST_CASE("variant_vector", "[variant_vector]")
+{
+    variant_vector<int, double, std::string> events;
+    events.push_back(1);
+    events.push_back(std::string { "two" });
+    events.push_back(3.0);
+    events.emplace_back<int>(4);
+    events.emplace_back<2>(3, 'x');
+
+    SECTION("each alternative is stored contiguously")
+    {
+        REQUIRE(events.size() == 5);
+        REQUIRE(events.alternative<int>().size() == 2);
+        REQUIRE(events.alternative<0>()[1] == 4);
+        REQUIRE(events.alternative<double>()[0] == 3.0);
+        REQUIRE(std::as_const(events).alternative<std::string>()[1] == "xxx");
+    }
+
+    SECTION("the order elements were added is kept")
+    {
+        REQUIRE(events.index(0) == 0);
+        REQUIRE(events.index(1) == 2);
+        REQUIRE(events.index(2) == 1);
+        REQUIRE(events.index(4) == 2);
+    }
+
+    SECTION("visit_all groups elements by alternative")
+    {
+        std::vector<std::string> seen;
+        events.visit_all(overloaded {
+            [&](int value) { seen.push_back("i" + std::to_string(value)); },
+            [&](double) { seen.push_back("d"); },
+            [&](const std::string& value) { seen.push_back(value); } });
+
+        REQUIRE(seen == std::vector<std::string> { "i1", "i4", "d", "two", "xxx" });
+    }
+
+    SECTION("visit_all can modify elements")
+    {
+        events.visit_all(overloaded {
+            [](int& value) { value *= 10; },
+            [](auto&) {} });
+
+        REQUIRE(events.alternative<int>()[0] == 10);
+        REQUIRE(events.alternative<int>()[1] == 40);
+    }
+
+    SECTION("visit_each keeps the order elements were added")
+    {
+        std::vector<std::string> seen;
+        std::as_const(events).visit_each(overloaded {
+            [&](int value) { seen.push_back("i" + std::to_string(value)); },
+            [&](double) { seen.push_back("d"); },
+            [&](const std::string& value) { seen.push_back(value); } });
+
+        REQUIRE(seen == std::vector<std::string> { "i1", "two", "d", "i4", "xxx" });
+    }
+
+    SECTION("push_back from a variant")
+    {
+        events.push_back(variant<int, double, std::string> { 2.5 });
+        REQUIRE(events.size() == 6);
+        REQUIRE(events.index(5) == 1);
+        REQUIRE(events.alternative<double>()[1] == 2.5);
+    }
+
+    SECTION("push_back moves from an r-value variant")
+    {
+        variant_vector<int, counts_copies> values;
+        counts_copies::copies = 0;
+
+        values.push_back(variant<int, counts_copies> { counts_copies {} });
+        REQUIRE(values.alternative<counts_copies>().size() == 1);
+        REQUIRE(counts_copies::copies == 0);
+    }
+
+    SECTION("push_back rejects a valueless variant")
+    {
+        variant<std::string, throws_on_move> v { "going" };
+        REQUIRE_THROWS(v.emplace<throws_on_move>(true));
+        REQUIRE(v.valueless_by_exception());
+
+        variant_vector<std::string, throws_on_move> values;
+        REQUIRE_THROWS_AS(values.push_back(v), std::bad_variant_access);
+        REQUIRE_THROWS_AS(values.push_back(std::move(v)), std::bad_variant_access);
+        REQUIRE(values.empty());
+    }
+
+    SECTION("clear")
+    {
+        events.clear();
+        REQUIRE(events.empty());
+        REQUIRE(events.alternative<std::string>().empty());
+    }
+}
+
+TEST_CASE("variant_vector index size", "[variant_vector]")
+{
+    // one byte of index per element rather than a padded variant
+    STATIC_REQUIRE(sizeof(variant<uint8_t, uint64_t>) == 16);
+    STATIC_REQUIRE(sizeof(variant_impl::index_type<2>) == 1);
+}
+
+TEST_CASE("variant_vector is unchanged by a throwing emplace_back", "[variant_vector]")
+{
+    variant_vector<int, throws_on_copy> values;
+    values.push_back(1);
+
+    const throws_on_copy original;
+    REQUIRE_THROWS_AS(values.push_back(original), std::runtime_error);
+    REQUIRE(values.size() == 1);
+    REQUIRE(values.alternative<throws_on_copy>().empty());
+}